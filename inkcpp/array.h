@@ -28,6 +28,31 @@ public:
 		}
 	}
 
+	managed_array(const managed_array& other)
+	    : managed_array()
+	{
+		*this = other;
+	}
+
+	managed_array& operator=(const managed_array& other)
+	{
+		if (this == &other) {
+			return *this;
+		}
+		if constexpr (dynamic) {
+			if (other._size > _capacity) {
+				extend(other._size);
+			}
+		} else {
+			inkAssert(other._size <= _capacity, "Array is to small to copy data into!");
+		}
+		for (size_t i = 0; i < other._size; ++i) {
+			data()[i] = other.data()[i];
+		}
+		_size = other._size;
+		return *this;
+	}
+
 	virtual ~managed_array()
 	{
 		if constexpr (dynamic) {
@@ -147,6 +172,12 @@ public:
 	{
 		decltype(_size) size;
 		ptr = snap_read(ptr, size);
+		// each element takes at least one byte, so a corrupted size is detected before allocating
+		if constexpr (is_base_of<snapshot_interface, T>::value) {
+			inkAssert(size <= loader.remaining(ptr), "Corrupted snapshot");
+		} else {
+			inkAssert(size <= loader.remaining(ptr) / sizeof(T), "Corrupted snapshot");
+		}
 		if constexpr (dynamic) {
 			resize(size);
 		} else {
@@ -291,6 +322,9 @@ public:
 	// Resets all values and clears any save points
 	void clear(const T& value);
 
+	// Copies values and save state of another array
+	void copy_from(const basic_restorable_array<T>& other);
+
 	// snapshot interface
 	virtual size_t               snap(unsigned char* data, const snapper&) const;
 	virtual const unsigned char* snap_load(const unsigned char* data, const loader&);
@@ -482,6 +516,21 @@ private:
 	T* _buffer;
 };
 
+template<typename T>
+inline void basic_restorable_array<T>::copy_from(const basic_restorable_array<T>& other)
+{
+	if (_capacity < other._capacity) {
+		static_cast<allocated_restorable_array<T>&>(*this).resize(other._capacity);
+	}
+	inkAssert(_capacity >= other._capacity, "Array is to small to copy data into!");
+	inkAssert(other._null == _null, "null value is different in copy source!");
+	_saved = other._saved;
+	for (size_t i = 0; i < other._capacity; ++i) {
+		_array[i] = other._array[i];
+		_temp[i]  = other._temp[i];
+	}
+}
+
 template<typename T>
 inline size_t basic_restorable_array<T>::snap(unsigned char* data, const snapper& snapper) const
 {
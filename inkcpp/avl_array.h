@@ -43,6 +43,7 @@
 #define _AVL_ARRAY_H_
 
 #include "system.h"
+#include "array.h"
 
 #include <cstdint>
 
@@ -53,8 +54,9 @@
  * \param size_type Container size type
  * \param Size Container size
  * \param Fast If true every node stores an extra parent index. This increases memory but speed up insert/erase by factor 10
+ * \param Dynamic If true the container grows when it is full, Size is the initial capacity then
  */
-template<typename Key, typename T, typename size_type, const size_type Size, const bool Fast = true>
+template<typename Key, typename T, typename size_type, const size_type Size, const bool Fast = true, const bool Dynamic = false>
 class avl_array
 {
   // child index pointer class
@@ -64,16 +66,19 @@ class avl_array
   } child_type;
 
   // node storage, due to possible structure packing effects, single arrays are used instead of a 'node' structure 
-  Key         key_[Size];                 // node key
-  T           val_[Size];                 // node value
-  std::int8_t balance_[Size];             // subtree balance
-  child_type  child_[Size];               // node childs
-  size_type   size_;                      // actual size
-  size_type   root_;                      // root node
-  size_type   parent_[Fast ? Size : 1];   // node parent, use one element if not needed (zero sized array is not allowed)
- 
+  template<typename A>
+  using storage = ink::runtime::internal::managed_array<A, Dynamic, Size>;
+  storage<Key>         key_;              // node key
+  storage<T>           val_;              // node value
+  storage<std::int8_t> balance_;          // subtree balance
+  storage<child_type>  child_;            // node childs
+  size_type            size_;             // actual size
+  size_type            root_;             // root node
+  ink::runtime::internal::managed_array<size_type, Dynamic, Fast ? Size : 1>
+                       parent_;           // node parent, use one element if not needed (zero sized array is not allowed)
+
   // invalid index (like 'nullptr' in a pointer implementation)
-  static const size_type INVALID_IDX = Size;
+  static const size_type INVALID_IDX = static_cast<size_type>(-1);
 
   // iterator class
   template<bool Const>
@@ -101,6 +106,8 @@ class avl_array
   	  , idx_(itr.idx_)
   	{}
 
+    tag_avl_array_iterator(const tag_avl_array_iterator&) = default;
+
     inline tag_avl_array_iterator& operator=(const tag_avl_array_iterator& other)
     {
       instance_ = other.instance_;
@@ -135,7 +142,7 @@ class avl_array
     tag_avl_array_iterator& operator++()
     {
       // end reached?
-      if (idx_ >= Size) {
+      if (idx_ == instance_->INVALID_IDX) {
         return *this;
       }
       // take left most child of right child, if not existent, take parent
@@ -189,9 +196,13 @@ public:
   // ctor
   avl_array()
     : size_(0U)
-    , root_(Size)
+    , root_(INVALID_IDX)
   { }
 
+  // the storage only tracks its capacity, not the nodes in use
+  avl_array(const avl_array&)            = delete;
+  avl_array& operator=(const avl_array&) = delete;
+
 
   // iterators
   inline iterator begin()
@@ -226,7 +237,7 @@ public:
   { return size_ == static_cast<size_type>(0); }
 
   inline size_type max_size() const
-  { return Size; }
+  { return key_.capacity(); }
 
 
   /**
@@ -260,7 +271,7 @@ public:
     for (size_type i = root_; i != INVALID_IDX; i = (key < key_[i]) ? child_[i].left : child_[i].right) {     
       if (key < key_[i]) {
         if (child_[i].left == INVALID_IDX) {
-          if (size_ >= max_size()) {
+          if (!reserve()) {
             // container is full
             return false;
           }
@@ -281,7 +292,7 @@ public:
       }
       else {
         if (child_[i].right == INVALID_IDX) {
-          if (size_ >= max_size()) {
+          if (!reserve()) {
             // container is full
             return false;
           }
@@ -414,7 +425,12 @@ public:
       }
       else {
         const size_type parent = get_parent(node);
-        child_[parent].left == node ? child_[parent].left = right : child_[parent].right = right;
+        if (node == root_) {
+          root_ = right;
+        }
+        else {
+          child_[parent].left == node ? child_[parent].left = right : child_[parent].right = right;
+        }
 
         set_parent(right, parent);
 
@@ -423,7 +439,12 @@ public:
     }
     else if (right == INVALID_IDX) {
       const size_type parent = get_parent(node);
-      child_[parent].left == node ? child_[parent].left = left : child_[parent].right = left;
+      if (node == root_) {
+        root_ = left;
+      }
+      else {
+        child_[parent].left == node ? child_[parent].left = left : child_[parent].right = left;
+      }
 
       set_parent(left, parent);
 
@@ -561,6 +582,27 @@ public:
   // Helper functions
 private:
 
+  // make room for one more node, grows the storage if the container is dynamic
+  bool reserve()
+  {
+    if (size_ < max_size()) {
+      return true;
+    }
+    if constexpr (Dynamic) {
+      const size_type capacity = max_size() * 2;
+      key_.extend(capacity);
+      val_.extend(capacity);
+      balance_.extend(capacity);
+      child_.extend(capacity);
+      if constexpr (Fast) {
+        parent_.extend(capacity);
+      }
+      return true;
+    }
+    return false;
+  }
+
+
   // find parent element
   inline size_type get_parent(size_type node) const
   {
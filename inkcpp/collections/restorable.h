@@ -204,6 +204,26 @@ namespace ink::runtime::internal
 
 		bool is_empty() const { return _pos == 0; }
 
+		// Copies content and save state of another collection
+		// translate is called for every copied element
+		template<typename TranslateMethod>
+		void copy_from(const restorable& other, TranslateMethod translate)
+		{
+			// saved data may live behind the current position
+			size_t len = (! other.is_saved() || other._pos > other._save) ? other._pos : other._save;
+			while (_size < len)
+				overflow(_buffer, _size);
+
+			for (size_t i = 0; i < len; ++i)
+			{
+				_buffer[i] = other._buffer[i];
+				translate(_buffer[i]);
+			}
+			_pos = other._pos;
+			_jump = other._jump;
+			_save = other._save;
+		}
+
 		void clear()
 		{
 			_pos = 0;
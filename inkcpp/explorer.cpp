@@ -0,0 +1,265 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#include "explorer.h"
+
+#ifdef INK_ENABLE_STL
+#	include "globals_impl.h"
+#	include "runner_impl.h"
+#	include "story_impl.h"
+
+#	include <atomic>
+#	include <deque>
+#	include <exception>
+#	include <iterator>
+#	include <memory>
+#	include <mutex>
+#	include <thread>
+#	include <unordered_set>
+
+namespace ink::runtime
+{
+namespace
+{
+	using namespace internal;
+
+	// runner waiting at a choice point (or at the end) and the number of choices taken to reach it
+	struct node {
+		runner   thread;
+		unsigned depth = 0;
+	};
+
+	class explorer
+	{
+	public:
+		explorer(story_impl& ink, const explore_options& options)
+		    : _ink{ink}
+		    , _options{options}
+		{
+			unsigned threads = options.threads;
+			if (threads == 0) {
+				threads = std::thread::hardware_concurrency();
+			}
+			for (unsigned i = 0; i < (threads == 0 ? 1 : threads); ++i) {
+				_workers.emplace_back(new worker);
+				_workers.back()->visited.resize(_ink.num_containers());
+			}
+		}
+
+		explore_result run()
+		{
+			runner start = _ink.new_runner();
+			advance(*start);
+			push(0, node{start, 0});
+
+			// the calling thread works as worker 0
+			std::vector<std::thread> pool;
+			for (size_t i = 1; i < _workers.size(); ++i) {
+				pool.emplace_back(&explorer::work, this, i);
+			}
+			work(0);
+			for (std::thread& thread : pool) {
+				thread.join();
+			}
+			if (_error) {
+				std::rethrow_exception(_error);
+			}
+
+			explore_result result;
+			result.complete = ! _limited;
+			result.containers.resize(_ink.num_containers());
+			for (uint32_t id = 0; id < result.containers.size(); ++id) {
+				result.containers[id] = container_coverage{id, _ink.find_container_hash(id), 0};
+			}
+			for (const std::unique_ptr<worker>& w : _workers) {
+				result.states += w->states;
+				result.duplicates += w->duplicates;
+				result.endings += w->endings;
+				result.truncated += w->truncated;
+				for (size_t id = 0; id < w->visited.size(); ++id) {
+					result.containers[id].states += w->visited[id];
+				}
+			}
+			return result;
+		}
+
+	private:
+		struct worker {
+			std::mutex       lock;
+			std::deque<node> queue;
+
+			// statistics, summed up after all workers finished
+			size_t              states     = 0;
+			size_t              duplicates = 0;
+			size_t              endings    = 0;
+			size_t              truncated  = 0;
+			std::vector<size_t> visited;
+		};
+
+		// continues until the next choice or the end of the story
+		static void advance(runner_interface& thread)
+		{
+			while (thread.can_continue()) {
+				thread.getline();
+			}
+		}
+
+		void push(size_t w, node&& n)
+		{
+			++_pending;
+			std::lock_guard<std::mutex> guard(_workers[w]->lock);
+			_workers[w]->queue.push_back(std::move(n));
+		}
+
+		// takes work from the own queue, or steals the oldest state queued by another worker
+		bool pop(size_t w, node& n)
+		{
+			{
+				worker&                     self = *_workers[w];
+				std::lock_guard<std::mutex> guard(self.lock);
+				if (! self.queue.empty()) {
+					if (_options.breadth_first) {
+						n = std::move(self.queue.front());
+						self.queue.pop_front();
+					} else {
+						n = std::move(self.queue.back());
+						self.queue.pop_back();
+					}
+					return true;
+				}
+			}
+			for (size_t i = 1; i < _workers.size(); ++i) {
+				worker&                     victim = *_workers[(w + i) % _workers.size()];
+				std::lock_guard<std::mutex> guard(victim.lock);
+				if (! victim.queue.empty()) {
+					n = std::move(victim.queue.front());
+					victim.queue.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void work(size_t w)
+		{
+			while (! _stop) {
+				node n;
+				if (pop(w, n)) {
+					try {
+						expand(w, n);
+					} catch (...) {
+						std::lock_guard<std::mutex> guard(_error_lock);
+						if (! _error) {
+							_error = std::current_exception();
+						}
+						_stop = true;
+					}
+					--_pending;
+				} else if (_pending == 0) {
+					break;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		enum class visit_result {
+			new_state,
+			duplicate,
+			limit,
+		};
+
+		// records the state, the seen states are split into shards to reduce lock contention
+		visit_result visit(uint64_t hash)
+		{
+			shard&                      s = _seen[hash % std::size(_seen)];
+			std::lock_guard<std::mutex> guard(s.lock);
+			if (s.hashes.count(hash) != 0) {
+				return visit_result::duplicate;
+			}
+			if (_options.max_states != 0 && _states++ >= _options.max_states) {
+				_limited = true;
+				_stop    = true;
+				return visit_result::limit;
+			}
+			s.hashes.insert(hash);
+			return visit_result::new_state;
+		}
+
+		void expand(size_t w, node& n)
+		{
+			worker&             self   = *_workers[w];
+			runner_impl&        thread = static_cast<runner_impl&>(*n.thread);
+			const globals_impl& store  = thread.get_globals();
+
+			// the state hash includes the turn count, so each state is expanded once at the depth it
+			// was first reached
+			switch (visit(thread.state_hash())) {
+				case visit_result::duplicate: ++self.duplicates; return;
+				case visit_result::limit: return;
+				case visit_result::new_state: break;
+			}
+			++self.states;
+			for (uint32_t id = 0; id < self.visited.size(); ++id) {
+				if (store.visits(id) > 0) {
+					++self.visited[id];
+				}
+			}
+			if (! thread.has_choices()) {
+				++self.endings;
+			}
+
+			if (! thread.has_choices()) {
+				return;
+			}
+			if (_options.max_depth != 0 && n.depth >= _options.max_depth) {
+				++self.truncated;
+				_limited = true;
+				return;
+			}
+			for (size_t i = 0; i < thread.num_choices(); ++i) {
+				runner child = thread.fork();
+				child->choose(i);
+				advance(*child);
+				push(w, node{child, n.depth + 1});
+			}
+		}
+
+		struct shard {
+			std::mutex                   lock;
+			std::unordered_set<uint64_t> hashes;
+		};
+
+		story_impl&                          _ink;
+		const explore_options&               _options;
+		std::vector<std::unique_ptr<worker>> _workers;
+		shard                                _seen[64];
+		std::atomic<size_t>                  _pending{0}; // queued or currently expanded states
+		std::atomic<size_t>                  _states{0};
+		std::atomic<bool>                    _stop{false};
+		std::atomic<bool>                    _limited{false};
+		std::mutex                           _error_lock;
+		std::exception_ptr                   _error;
+	};
+} // namespace
+
+size_t explore_result::covered() const
+{
+	size_t count = 0;
+	for (const container_coverage& container : containers) {
+		if (container.states > 0) {
+			++count;
+		}
+	}
+	return count;
+}
+
+explore_result explore(story& ink, const explore_options& options)
+{
+	return explorer(static_cast<internal::story_impl&>(ink), options).run();
+}
+} // namespace ink::runtime
+#endif
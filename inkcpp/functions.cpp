@@ -43,6 +43,16 @@ void functions::add(hash_t name, function_base* func)
 	}
 }
 
+void functions::copy_from(const functions& other)
+{
+	for (const entry* iter = other._list; iter != nullptr; iter = iter->next) {
+		function_base* copy = iter->value->clone();
+		if (copy != nullptr) {
+			add(iter->name, copy);
+		}
+	}
+}
+
 function_base* functions::find(hash_t name)
 {
 	// find entry
@@ -26,6 +26,9 @@ public:
 	// Calls a function (if available)
 	function_base* find(hash_t name);
 
+	// Adds copies of all functions registered in other
+	void copy_from(const functions& other);
+
 private:
 	struct entry {
 		hash_t         name;
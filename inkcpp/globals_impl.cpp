@@ -8,11 +8,24 @@
 #include "story_impl.h"
 #include "runner_impl.h"
 #include "snapshot_impl.h"
+#include "state_hash.h"
 #include "system.h"
 #include "types.h"
 
+#include <atomic>
+
 namespace ink::runtime::internal
 {
+namespace
+{
+	// a new id for each store, so snapshots can tell which store they were taken from
+	uint64_t new_globals_id()
+	{
+		static std::atomic<uint64_t> next{1};
+		return next++;
+	}
+} // namespace
+
 globals_impl::globals_impl(const story_impl* story)
     : _num_containers(story->num_containers())
     , _turn_cnt{0}
@@ -21,10 +34,15 @@ globals_impl::globals_impl(const story_impl* story)
     , _owner(story)
     , _runners_start(nullptr)
     , _lists(story->list_meta(), story->get_header())
+    , _id{new_globals_id()}
     , _globals_initialized(false)
 {
 	_visit_counts.resize(_num_containers);
 	_visit_counts_backup.resize(_num_containers);
+	_visit_serials.resize((_num_containers + VISIT_CHUNK - 1) / VISIT_CHUNK);
+	for (uint64_t& serial : _visit_serials) {
+		serial = 0;
+	}
 	if (_lists) {
 		// initialize static lists
 		const list_flag* flags = story->lists();
@@ -46,15 +64,73 @@ globals_impl::globals_impl(const story_impl* story)
 	}
 }
 
+globals_impl::globals_impl(const globals_impl& other, string_table::mapping& strings)
+    : _num_containers(other._num_containers)
+    , _turn_cnt{other._turn_cnt}
+    , _visit_counts(other._visit_counts)
+    , _visit_counts_backup(other._visit_counts_backup)
+    , _owner(other._owner)
+    , _runners_start(nullptr)
+    , _lists(other._owner->list_meta(), other._owner->get_header())
+    , _id{new_globals_id()}
+    , _visit_serials(other._visit_serials)
+    , _globals_initialized(other._globals_initialized)
+{
+	_strings.copy_from(other._strings, strings);
+	_lists.copy_from(other._lists);
+	_variables.copy_from(other._variables, strings);
+	// strings and lists are hashed by content, so the copies have the same hashes
+	_visit_hash            = other._visit_hash;
+	_visit_hash_backup     = other._visit_hash_backup;
+	_variables_hash        = other._variables_hash;
+	_variables_hash_backup = other._variables_hash_backup;
+}
+
+globals globals_impl::fork() const
+{
+	string_table::mapping strings;
+	return globals(new globals_impl(*this, strings), _owner->block());
+}
+
 void globals_impl::visit(uint32_t container_id, bool entering_at_start)
 {
 	if ((! (_owner->container_flag(container_id) & CommandFlag::CONTAINER_MARKER_ONLY_FIRST))
 	    || entering_at_start) {
-		_visit_counts[container_id].visits += 1;
-		_visit_counts[container_id].turns = 0;
+		visit_count& count = _visit_counts[container_id];
+		_visit_hash ^= hash_visit_count(container_id, count);
+		count.visits += 1;
+		count.turns = 0;
+		_visit_hash ^= hash_visit_count(container_id, count);
+		visits_written(container_id);
 	}
 }
 
+void globals_impl::visits_written(uint32_t container_id)
+{
+	_visit_serials[container_id / VISIT_CHUNK] = _snapshot_serial;
+}
+
+uint64_t globals_impl::hash_visit_count(uint32_t container_id, const visit_count& count) const
+{
+	if (count.visits == 0 && count.turns == -1) {
+		return 0;
+	}
+	state_hasher hasher;
+	hasher.add(static_cast<uint64_t>(container_id));
+	hasher.add(static_cast<uint64_t>(count.visits));
+	hasher.add(static_cast<uint64_t>(count.turns == -1 ? ~0u : _turn_cnt - count.turns));
+	return hash_mix(hasher.get());
+}
+
+uint64_t globals_impl::hash_visit_counts(const managed_array<visit_count, true, 1>& counts) const
+{
+	uint64_t result = 0;
+	for (uint32_t i = 0; i < counts.size(); ++i) {
+		result ^= hash_visit_count(i, counts[i]);
+	}
+	return result;
+}
+
 uint32_t globals_impl::visits(uint32_t container_id) const
 {
 	return _visit_counts[container_id].visits;
@@ -68,6 +144,7 @@ void globals_impl::turn()
 	for (size_t i = 0; i < _visit_counts.size(); ++i) {
 		if (_visit_counts[i].turns != -1) {
 			_visit_counts[i].turns += 1;
+			visits_written(i);
 		}
 	}
 }
@@ -110,27 +187,101 @@ void globals_impl::remove_runner(const runner_impl* runner)
 	}
 }
 
+size_t globals_impl::first_callback(hash_t name) const
+{
+	size_t begin = 0;
+	size_t end   = _callbacks.size();
+	while (begin < end) {
+		size_t mid = begin + (end - begin) / 2;
+		if (_callbacks[mid].name < name) {
+			begin = mid + 1;
+		} else {
+			end = mid;
+		}
+	}
+	return begin;
+}
+
+void globals_impl::notify(
+    size_t first, const ink::runtime::value& new_val, const optional<ink::runtime::value>& old_val
+)
+{
+	hash_t name = _callbacks[first].name;
+	for (size_t i = first; i < _callbacks.size() && _callbacks[i].name == name; ++i) {
+		_callbacks[i].operation->call(new_val, old_val);
+	}
+}
+
+void globals_impl::write_variable(hash_t name, const value& val)
+{
+	const value* old_val = _variables.get(name);
+	if (old_val != nullptr) {
+		_variables_hash ^= basic_stack::hash_entry(name, *old_val, _lists);
+	}
+	_variables.set(name, val);
+	_variables_hash ^= basic_stack::hash_entry(name, val, _lists);
+	_variables_serial = _snapshot_serial;
+}
+
 void globals_impl::set_variable(hash_t name, const value& val)
 {
+	size_t first = first_callback(name);
+	if (first == _callbacks.size() || _callbacks[first].name != name) {
+		// nobody observes this variable
+		write_variable(name, val);
+		return;
+	}
+
 	ink::optional<value> old_var   = ink::nullopt;
 	value*               p_old_var = get_variable(name);
 	if (p_old_var != nullptr) {
 		old_var = *p_old_var;
 	}
 
-	_variables.set(name, val);
+	write_variable(name, val);
 
-	for (auto& callback : _callbacks) {
-		if (callback.name == name) {
-			if (old_var.has_value()) {
-				callback.operation->call(
-				    val.to_interface_value(lists()), {old_var->to_interface_value(lists())}
-				);
-			} else {
-				callback.operation->call(val.to_interface_value(lists()), ink::nullopt);
+	if (_coalesce_observers) {
+		// only the value before the first write is of interest
+		for (const Change& change : _changes) {
+			if (change.name == name) {
+				return;
 			}
 		}
+		_changes.push() = Change{name, old_var};
+		return;
+	}
+
+	if (old_var.has_value()) {
+		notify(first, val.to_interface_value(lists()), {old_var->to_interface_value(lists())});
+	} else {
+		notify(first, val.to_interface_value(lists()), ink::nullopt);
+	}
+}
+
+void globals_impl::flush_observers()
+{
+	for (const Change& change : _changes) {
+		const value* var = get_variable(change.name);
+		inkAssert(var != nullptr, "Observed variable was removed before notification.");
+		if (change.old_value.has_value()) {
+			notify(
+			    first_callback(change.name), var->to_interface_value(lists()),
+			    {change.old_value->to_interface_value(lists())}
+			);
+		} else {
+			notify(first_callback(change.name), var->to_interface_value(lists()), ink::nullopt);
+		}
+	}
+	_changes.clear();
+	_changes.forgett();
+}
+
+void globals_impl::coalesce_observers(bool enabled)
+{
+	if (! enabled) {
+		flush_observers();
 	}
+	_coalesce_observers = enabled;
 }
 
 const value* globals_impl::get_variable(hash_t name) const { return _variables.get(name); }
@@ -152,13 +303,17 @@ bool globals_impl::set_var(hash_t name, const ink::runtime::value& val)
 	if (! var) {
 		return false;
 	}
-	ink::runtime::value old_val = var->to_interface_value(lists());
+	size_t first    = first_callback(name);
+	bool   observed = first < _callbacks.size() && _callbacks[first].name == name;
+	ink::runtime::value old_val
+	    = observed ? var->to_interface_value(lists()) : ink::runtime::value{};
 
 	bool ret = false;
 	if (val.type == ink::runtime::value::Type::String) {
 		if (! (var->type() == value_type::none || var->type() == value_type::string)) {
 			return false;
 		}
+		_variables_hash ^= basic_stack::hash_entry(name, *var, _lists);
 		size_t size = 0;
 		char*  ptr;
 		for (const char* i = val.get<runtime::value::Type::String>(); *i; ++i) {
@@ -174,13 +329,14 @@ bool globals_impl::set_var(hash_t name, const ink::runtime::value& val)
 		*var = value{}.set<value_type::string>(static_cast<const char*>(new_string), true);
 		ret  = true;
 	} else {
+		_variables_hash ^= basic_stack::hash_entry(name, *var, _lists);
 		ret = var->set(val);
 	}
+	_variables_hash ^= basic_stack::hash_entry(name, *var, _lists);
+	_variables_serial = _snapshot_serial;
 
-	for (auto& callback : _callbacks) {
-		if (callback.name == name) {
-			callback.operation->call(val, {old_val});
-		}
+	if (observed) {
+		notify(first, val, {old_val});
 	}
 
 	return ret;
@@ -188,7 +344,12 @@ bool globals_impl::set_var(hash_t name, const ink::runtime::value& val)
 
 void globals_impl::internal_observe(hash_t name, callback_base* callback)
 {
-	_callbacks.push() = Callback{.name = name, .operation = callback};
+	// insert behind the existing observers of this variable
+	size_t position = first_callback(name);
+	while (position < _callbacks.size() && _callbacks[position].name == name) {
+		++position;
+	}
+	_callbacks.insert(position) = Callback{.name = name, .operation = callback};
 	if (_globals_initialized) {
 		value* p_var = _variables.get(name);
 		inkAssert(
@@ -212,6 +373,15 @@ void globals_impl::initialize_globals(runner_impl* run)
 	_globals_initialized = true;
 }
 
+uint64_t globals_impl::state_hash() const
+{
+	state_hasher hasher;
+	hasher.add(static_cast<uint64_t>(_turn_cnt));
+	hasher.add(_visit_hash);
+	hasher.add(_variables_hash);
+	return hasher.get();
+}
+
 void globals_impl::gc()
 {
 	// Mark all strings as unused
@@ -227,6 +397,16 @@ void globals_impl::gc()
 
 	// Mark our own strings
 	_variables.mark_used(_strings, _lists);
+	for (const Change& change : _changes) {
+		if (! change.old_value.has_value()) {
+			continue;
+		}
+		if (change.old_value->type() == value_type::string) {
+			_strings.mark_used(change.old_value->get<value_type::string>());
+		} else if (change.old_value->type() == value_type::list) {
+			_lists.mark_used(change.old_value->get<value_type::list>());
+		}
+	}
 
 	// run garbage collection
 	_strings.gc();
@@ -236,23 +416,55 @@ void globals_impl::gc()
 void globals_impl::save()
 {
 	for (uint32_t i = 0; i < _num_containers; ++i) {
-		_visit_counts_backup[i] = _visit_counts[i];
+		if (_visit_counts_backup[i] != _visit_counts[i]) {
+			_visit_counts_backup[i] = _visit_counts[i];
+			visits_written(i);
+		}
 	}
+	_visit_hash_backup     = _visit_hash;
+	_variables_hash_backup = _variables_hash;
 	_variables.save();
+	_changes.save();
 }
 
 void globals_impl::restore()
 {
 	for (uint32_t i = 0; i < _num_containers; ++i) {
-		_visit_counts[i] = _visit_counts_backup[i];
+		if (_visit_counts[i] != _visit_counts_backup[i]) {
+			_visit_counts[i] = _visit_counts_backup[i];
+			visits_written(i);
+		}
 	}
+	_visit_hash       = _visit_hash_backup;
+	_variables_hash   = _variables_hash_backup;
+	_variables_serial = _snapshot_serial;
 	_variables.restore();
+	_changes.restore();
 }
 
-void globals_impl::forget() { _variables.forget(); }
+void globals_impl::forget()
+{
+	_variables.forget();
+	_changes.forgett();
+}
 
 snapshot* globals_impl::create_snapshot() const { return new snapshot_impl(*this); }
 
+snapshot* globals_impl::create_snapshot(snapshot_format format) const
+{
+	if (format == snapshot_format::standard) {
+		return create_snapshot();
+	}
+	return snapshot_impl::create_compact(*this, format == snapshot_format::compressed);
+}
+
+void globals_impl::write_snapshot(snapshot_sink& sink) const { snapshot_impl::write(*this, sink); }
+
+snapshot* globals_impl::create_delta_snapshot(const snapshot& base) const
+{
+	return snapshot_impl::create_delta(*this, static_cast<const snapshot_impl&>(base));
+}
+
 size_t globals_impl::snap(unsigned char* data, const snapper& snapper) const
 {
 	unsigned char* ptr = data;
@@ -261,21 +473,71 @@ size_t globals_impl::snap(unsigned char* data, const snapper& snapper) const
 	    _globals_initialized,
 	    "Only support snapshot of globals with runner! or you don't need a snapshot for this state"
 	);
-	ptr = snap_write(ptr, _turn_cnt, data != nullptr);
-	ptr += _visit_counts.snap(data ? ptr : nullptr, snapper);
-	ptr += _visit_counts_backup.snap(data ? ptr : nullptr, snapper);
-	ptr += _strings.snap(data ? ptr : nullptr, snapper);
-	ptr += _lists.snap(data ? ptr : nullptr, snapper);
-	ptr += _variables.snap(data ? ptr : nullptr, snapper);
+	size_t section = 0;
+	if (snapper.compact) {
+		bool should_write = data != nullptr;
+		ptr               = snap_write_varint(ptr, static_cast<uint64_t>(_turn_cnt), should_write);
+		ptr               = snap_visit_counts(ptr, _visit_counts, should_write);
+		// the backup only differs while a runner is in the middle of a turn
+		bool backup = false;
+		for (size_t i = 0; i < _visit_counts.size() && ! backup; ++i) {
+			backup = _visit_counts[i] != _visit_counts_backup[i];
+		}
+		ptr = snap_write(ptr, backup, should_write);
+		if (backup) {
+			ptr = snap_visit_counts(ptr, _visit_counts_backup, should_write);
+		}
+		// the other sections are the same in both formats
+		section = 1;
+	}
+	for (; section < SNAP_SECTIONS; ++section) {
+		_snap_sections[section] = snap_section(section, data ? ptr : nullptr, snapper);
+		ptr += _snap_sections[section];
+	}
+	return ptr - data;
+}
+
+size_t globals_impl::snap_section(size_t section, unsigned char* data, const snapper& snapper) const
+{
+	unsigned char* ptr = data;
+	switch (section) {
+		case 0:
+			ptr = snap_write(ptr, _turn_cnt, data != nullptr);
+			ptr += _visit_counts.snap(data ? ptr : nullptr, snapper);
+			ptr += _visit_counts_backup.snap(data ? ptr : nullptr, snapper);
+			break;
+		case 1:
+			ptr += _strings.snap(data ? ptr : nullptr, snapper);
+			ptr += _lists.snap(data ? ptr : nullptr, snapper);
+			break;
+		default: ptr += _variables.snap(data ? ptr : nullptr, snapper); break;
+	}
 	return ptr - data;
 }
 
 const unsigned char* globals_impl::snap_load(const unsigned char* ptr, const loader& loader)
 {
 	_globals_initialized = true;
-	ptr                  = snap_read(ptr, _turn_cnt);
-	ptr                  = _visit_counts.snap_load(ptr, loader);
-	ptr                  = _visit_counts_backup.snap_load(ptr, loader);
+	// the loaded state has nothing in common with the snapshots taken so far
+	_id                  = new_globals_id();
+	if (loader.compact) {
+		uint64_t turn_cnt;
+		ptr       = snap_read_varint(ptr, turn_cnt, loader);
+		_turn_cnt = static_cast<uint32_t>(turn_cnt);
+		ptr       = snap_load_visit_counts(ptr, _visit_counts, loader);
+		bool backup;
+		inkAssert(loader.remaining(ptr) >= sizeof(backup), "Corrupted snapshot");
+		ptr = snap_read(ptr, backup);
+		if (backup) {
+			ptr = snap_load_visit_counts(ptr, _visit_counts_backup, loader);
+		} else {
+			_visit_counts_backup = _visit_counts;
+		}
+	} else {
+		ptr = snap_read(ptr, _turn_cnt);
+		ptr = _visit_counts.snap_load(ptr, loader);
+		ptr = _visit_counts_backup.snap_load(ptr, loader);
+	}
 	inkAssert(_visit_counts.size() == _visit_counts_backup.size(), "Data inconsitency");
 	inkAssert(
 	    _num_containers == _visit_counts.size(),
@@ -284,6 +546,69 @@ const unsigned char* globals_impl::snap_load(const unsigned char* ptr, const loa
 	ptr = _strings.snap_load(ptr, loader);
 	ptr = _lists.snap_load(ptr, loader);
 	ptr = _variables.snap_load(ptr, loader);
+
+	_visit_hash        = hash_visit_counts(_visit_counts);
+	_visit_hash_backup = hash_visit_counts(_visit_counts_backup);
+	// snapshots are taken between lines, without a saved state of the variables
+	_variables_hash        = _variables.hash_entries(_lists);
+	_variables_hash_backup = _variables_hash;
+	return ptr;
+}
+
+unsigned char* globals_impl::snap_visit_counts(
+    unsigned char* ptr, const managed_array<visit_count, true, 1>& counts, bool write
+)
+{
+	ptr = snap_write_varint(ptr, static_cast<uint64_t>(counts.size()), write);
+	for (size_t i = 0; i < counts.size();) {
+		size_t unvisited = i;
+		while (unvisited < counts.size() && counts[unvisited] == visit_count{}) {
+			++unvisited;
+		}
+		size_t visited = unvisited;
+		while (visited < counts.size() && counts[visited] != visit_count{}) {
+			++visited;
+		}
+		ptr = snap_write_varint(ptr, static_cast<uint64_t>(unvisited - i), write);
+		ptr = snap_write_varint(ptr, static_cast<uint64_t>(visited - unvisited), write);
+		for (i = unvisited; i < visited; ++i) {
+			ptr = snap_write_varint(ptr, static_cast<uint64_t>(counts[i].visits), write);
+			ptr = snap_write_varint(ptr, static_cast<int64_t>(counts[i].turns), write);
+		}
+	}
+	return ptr;
+}
+
+const unsigned char* globals_impl::snap_load_visit_counts(
+    const unsigned char* ptr, managed_array<visit_count, true, 1>& counts, const loader& loader
+) const
+{
+	uint64_t size;
+	ptr = snap_read_varint(ptr, size, loader);
+	inkAssert(
+	    size == _num_containers, "errer when loading visit counts, story file dont match snapshot!"
+	);
+	counts.resize(size);
+	for (size_t i = 0; i < size;) {
+		uint64_t unvisited, visited;
+		ptr = snap_read_varint(ptr, unvisited, loader);
+		ptr = snap_read_varint(ptr, visited, loader);
+		inkAssert(
+		    unvisited + visited > 0 && unvisited <= size - i && visited <= size - i - unvisited,
+		    "Corrupted snapshot"
+		);
+		for (size_t end = i + unvisited; i < end; ++i) {
+			counts[i] = visit_count{};
+		}
+		for (size_t end = i + visited; i < end; ++i) {
+			uint64_t visits;
+			int64_t  turns;
+			ptr              = snap_read_varint(ptr, visits, loader);
+			ptr              = snap_read_varint(ptr, turns, loader);
+			counts[i].visits = static_cast<uint32_t>(visits);
+			counts[i].turns  = static_cast<int32_t>(turns);
+		}
+	}
 	return ptr;
 }
 } // namespace ink::runtime::internal
@@ -35,10 +35,18 @@ public:
 	const unsigned char* snap_load(const unsigned char* data, const loader&);
 	// Initializes a new global store from the given story
 	globals_impl(const story_impl*);
+	// Creates an independent copy of a global store, strings maps the copied strings
+	globals_impl(const globals_impl& other, string_table::mapping& strings);
 
 	virtual ~globals_impl() {}
 
 	snapshot* create_snapshot() const override;
+	snapshot* create_snapshot(snapshot_format format) const override;
+	void      write_snapshot(snapshot_sink& sink) const override;
+	snapshot* create_delta_snapshot(const snapshot& base) const override;
+	globals   fork() const override;
+	uint64_t  state_hash() const override;
+	void      coalesce_observers(bool enabled) override;
 
 protected:
 	optional<ink::runtime::value> get_var(hash_t name) const override;
@@ -69,6 +77,9 @@ public:
 	// sets a global variable
 	void set_variable(hash_t name, const value&);
 
+	// delivers the observer notifications collected in coalesced mode
+	void flush_observers();
+
 	// gets a global variable
 	const value* get_variable(hash_t name) const;
 	value*       get_variable(hash_t name);
@@ -87,6 +98,8 @@ public:
 	// gets list entries
 	list_table& lists() { return _lists; }
 
+	const list_table& lists() const { return _lists; }
+
 	// run garbage collection
 	void gc();
 
@@ -117,6 +130,20 @@ private:
 	managed_array<visit_count, true, 1> _visit_counts;
 	managed_array<visit_count, true, 1> _visit_counts_backup;
 
+	// xor of hash_visit_count() of all containers, updated on each visit
+	uint64_t _visit_hash        = 0;
+	uint64_t _visit_hash_backup = 0;
+	// visits are hashed with the turn of the last visit, so a turn does not change the hash
+	uint64_t hash_visit_count(uint32_t container_id, const visit_count&) const;
+	uint64_t hash_visit_counts(const managed_array<visit_count, true, 1>&) const;
+
+	// compact encoding of visit counts, alternating runs of unvisited and visited containers
+	static unsigned char*
+	    snap_visit_counts(unsigned char* ptr, const managed_array<visit_count, true, 1>&, bool write);
+	const unsigned char* snap_load_visit_counts(
+	    const unsigned char* ptr, managed_array<visit_count, true, 1>&, const loader&
+	) const;
+
 	// Pointer back to owner story.
 	const story_impl* const _owner;
 
@@ -137,13 +164,55 @@ private:
 	// If I could create an avl tree with save/restore, that'd be great but seems super complex.
 	internal::stack < abs(config::limitGlobalVariables), config::limitGlobalVariables<0> _variables;
 
+	// xor of the hashes of all variables, updated on each write
+	uint64_t _variables_hash        = 0;
+	uint64_t _variables_hash_backup = 0;
+	void     write_variable(hash_t name, const value&);
+
+	// Writes are stamped with the serial of the next snapshot, so data with a stamp up to the serial
+	// of a snapshot is unchanged since then. Delta snapshots skip it, see snapshot_impl::origin.
+	static constexpr uint32_t        VISIT_CHUNK = 64;
+	// identifies this store in the snapshots taken from it
+	uint64_t                         _id;
+	mutable uint64_t                 _snapshot_serial  = 0;
+	uint64_t                         _variables_serial = 0;
+	// stamps of each VISIT_CHUNK visit counts and their backups
+	managed_array<uint64_t, true, 1> _visit_serials;
+	void                             visits_written(uint32_t container_id);
+
+	// the standard format is made of sections, which delta snapshots compare one by one:
+	// the turn and visit counts, the strings and lists, the variables
+	static constexpr size_t SNAP_SECTIONS = 3;
+	size_t                  snap_section(size_t section, unsigned char* data, const snapper&) const;
+	// lengths of the sections written by the last snap() in the standard format
+	mutable size_t          _snap_sections[SNAP_SECTIONS] = {};
+
 	struct Callback {
 		hash_t         name;
 		callback_base* operation;
 	};
 
+	// index of the first observer of `name` or of the next greater name
+	size_t first_callback(hash_t name) const;
+	// calls all observers of the variable, starting at `first`
+	void   notify(
+	      size_t first, const ink::runtime::value& new_val, const optional<ink::runtime::value>& old_val
+	  );
+
+	// sorted by name, observers of the same variable in order of registration
 	managed_array < Callback,
 	    config::limitGlobalVariableObservers<0, abs(config::limitGlobalVariableObservers)> _callbacks;
+
+	// observed variables written since the last flush, with their value before the first write
+	struct Change {
+		hash_t          name;
+		optional<value> old_value;
+	};
+
+	// writes of a discarded lookahead are dropped on restore
+	managed_restorable_array < Change,
+	    config::limitGlobalVariableObservers<0, abs(config::limitGlobalVariableObservers)> _changes;
+	bool _coalesce_observers = false;
 	bool _globals_initialized;
 };
 } // namespace ink::runtime::internal
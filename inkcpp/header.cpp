@@ -36,9 +36,27 @@ namespace ink::internal {
 			inkFail("Failed to parse endian encoding!");
 		}
 
-		if (res.ink_bin_version_number != InkBinVersion) {
+		if (res.ink_bin_version_number < InkBinVersionMin
+		    || res.ink_bin_version_number > InkBinVersion) {
 			inkFail("InkCpp-version mismatch: file was compiled with different InkCpp-version!");
 		}
+
+		// section directory follows directly after the header
+		if (res.has_directory()) {
+			ptr = data + Size;
+			auto read = [&res, &ptr]() {
+				uint32_t val = *reinterpret_cast<const uint32_t*>(ptr);
+				ptr += sizeof(uint32_t);
+				return res.endien == header::endian_types::differ ? swap_bytes(val) : val;
+			};
+			for (section_entry& entry : res.sections) {
+				entry.offset = read();
+				entry.size   = read();
+			}
+			res.num_containers      = read();
+			res.container_map_size  = read();
+			res.container_hash_size = read();
+		}
 		return res;
 	}
 }
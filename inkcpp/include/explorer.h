@@ -0,0 +1,77 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#pragma once
+
+#include "types.h"
+
+#ifdef INK_ENABLE_STL
+#	include <vector>
+
+namespace ink::runtime
+{
+class story;
+
+/** Limits and parallelism of ink::runtime::explore() */
+struct explore_options {
+	/** maximum number of choices taken along a path, 0 for no limit */
+	unsigned max_depth = 0;
+	/** stop after this many distinct states were explored, 0 for no limit */
+	size_t max_states = 0;
+	/** number of worker threads, 0 to use one per hardware thread */
+	unsigned threads = 0;
+	/** explore states closer to the start first, instead of following each path to its end.
+	 * Mostly relevant in combination with max_states.
+	 */
+	bool breadth_first = false;
+};
+
+/** Coverage of a single container */
+struct container_coverage {
+	uint32_t id;     ///< container id, the index into explore_result::containers
+	hash_t   name;   ///< hash of the containers path (e.g. `knot.stitch`), 0 if it has no name
+	size_t   states; ///< number of explored states in which the container was visited before
+};
+
+/** Result of ink::runtime::explore() */
+struct explore_result {
+	size_t states     = 0; ///< number of distinct states explored
+	size_t duplicates = 0; ///< number of paths which reached an already explored state
+	size_t endings    = 0; ///< number of explored states without choices
+	size_t truncated  = 0; ///< number of states not expanded because of explore_options::max_depth
+	bool   complete   = true; ///< false if a limit stopped the exploration
+	/** coverage of every container of the story, indexed by container id */
+	std::vector<container_coverage> containers;
+
+	/** number of containers visited in at least one state */
+	size_t covered() const;
+};
+
+/**
+ * Explores all choice sequences of a story.
+ *
+ * Starting from a new runner, each choice is taken on a fork of the runner
+ * (see runner_interface::fork()) and the story is continued to the next choice.
+ * States are identified by runner_interface::state_hash() (instruction pointer,
+ * callstack, evaluation stack, choices, visit counts, turn count, variables), each state
+ * reached again on a different path is only expanded once. Because the turn count is part of
+ * the state, all paths to a state take the same number of turns. Fallback choices count as
+ * turns too, so with explore_options::max_depth a state is limited by the number of choices
+ * on the path which reached it first. The states are distributed over a pool of worker
+ * threads, idle workers steal states queued by others.
+ *
+ * Stories calling external functions can not be explored, the story must not bind any.
+ * Errors while running the story are rethrown after all workers stopped.
+ *
+ * Requires STL.
+ *
+ * @param ink story to explore
+ * @param options limits of the exploration
+ * @return statistics and container coverage
+ */
+explore_result explore(story& ink, const explore_options& options = {});
+} // namespace ink::runtime
+#endif
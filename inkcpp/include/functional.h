@@ -141,6 +141,13 @@ public:
 
 	bool lookaheadSafe() const { return _lookaheadSafe; }
 
+	// if true the runner waits for the result to be passed to runner_interface::resume_external()
+	virtual bool is_async() const { return false; }
+
+	// creates a copy of this function object, used when forking a runner.
+	// Functions which can not be copied return nullptr and are not bound in the fork.
+	virtual function_base* clone() const { return nullptr; }
+
 protected:
 	bool _lookaheadSafe;
 	// used to hide basic_eval_stack and value definitions
@@ -179,10 +186,14 @@ public:
 		call(stack, length, strings, lists, GenSeq<traits::arity>());
 	}
 
-private:
+	virtual function_base* clone() const override { return new function(functor, _lookaheadSafe); }
+
+protected:
 	// Callable functor object
 	F functor;
 
+private:
+
 	// function traits
 	using traits = function_traits<F>;
 
@@ -276,6 +287,26 @@ private:
 	}
 };
 
+// Stores a Callable which only receives the arguments, the runner waits for the result
+template<typename F>
+class async_function final : public function<F>
+{
+	static_assert(
+	    is_same<void, typename function_traits<F>::return_type>::value,
+	    "The result of an asynchronous function is passed to resume_external()"
+	);
+
+public:
+	async_function(F functor)
+	    : function<F>(functor, false)
+	{
+	}
+
+	virtual bool is_async() const override { return true; }
+
+	virtual function_base* clone() const override { return new async_function(this->functor); }
+};
+
 #ifdef INK_ENABLE_UNREAL
 template<typename D>
 class function_array_delegate : public function_base
@@ -320,6 +351,11 @@ public:
 		}
 	}
 
+	virtual function_base* clone() const override
+	{
+		return new function_array_delegate(invocableDelegate, _lookaheadSafe);
+	}
+
 private:
 	D invocableDelegate;
 };
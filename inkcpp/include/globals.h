@@ -11,8 +11,6 @@
 
 namespace ink::runtime
 {
-class snapshot;
-
 /**
  * Represents a global store to be shared amongst ink runners.
  * Stores global variable values, visit counts, turn counts, etc.
@@ -51,7 +49,8 @@ public:
 	 *
 	 * Calls callback with `value` or with casted value if it is one of
 	 * values variants. The callback will also be called with the current value
-	 * when the observe is bind.
+	 * when the observe is bind. Stores created by story::new_globals() are already
+	 * initialized, so this also applies before the first runner is created.
 	 * @param name of variable to observe
 	 * @param callback functor with:
 	 * * 0 arguments
@@ -65,11 +64,78 @@ public:
 		internal_observe(hash_string(name), new internal::callback(callback));
 	}
 
+	/**
+	 * @brief Delivers observer notifications once per line.
+	 *
+	 * By default observers are called on every assignment, including assignments
+	 * executed while a runner looks ahead for glue. In coalesced mode each observed
+	 * variable which was written during `getline` is reported once at its end, with
+	 * the value before the first and after the last assignment.
+	 * Assignments through set() are always reported directly.
+	 * Disabling the mode delivers outstanding notifications.
+	 * @param enabled true to coalesce notifications
+	 */
+	virtual void coalesce_observers(bool enabled) = 0;
+
 	/** create a snapshot of the current runtime state.
 	 * (inclusive all runners assoziated with this globals)
 	 */
 	virtual snapshot* create_snapshot() const = 0;
 
+	/** create a snapshot of the current runtime state in the given format.
+	 * Compact snapshots are smaller, but take longer to create and load.
+	 * @param format encoding of the snapshot
+	 */
+	virtual snapshot* create_snapshot(snapshot_format format) const = 0;
+
+	/**
+	 * @brief Writes a snapshot of the current runtime state to a sink.
+	 *
+	 * Same content as create_snapshot(), but each part is passed to the sink as soon as it is
+	 * serialized instead of building the whole snapshot in memory first.
+	 * @param sink destination, e.g. @ref ink::runtime::stream_snapshot_sink
+	 * @sa snapshot_sink
+	 */
+	virtual void write_snapshot(snapshot_sink& sink) const = 0;
+
+	/**
+	 * @brief Creates a snapshot which only contains the changes since base.
+	 *
+	 * The size of the delta depends on how much changed, not on the size of the story,
+	 * e.g. for an autosave after each choice. It can only be loaded after reconstructing
+	 * the full snapshot with @ref ink::runtime::snapshot::from_deltas().
+	 *
+	 * If base was created by this store, writes to the visit counts and variables since then
+	 * are tracked, and only those are compared; strings, lists and runners are always
+	 * serialized and compared. Otherwise the whole state is serialized and compared with base,
+	 * which takes about twice as long as a full snapshot.
+	 * @param base full snapshot of the same story and runners
+	 * @return newly created delta snapshot
+	 */
+	virtual snapshot* create_delta_snapshot(const snapshot& base) const = 0;
+
+	/**
+	 * @brief Creates an independent copy of this global store.
+	 *
+	 * Visit counts, turn counts, variables, strings and lists are copied directly
+	 * without creating a snapshot. Observers are not copied and no runner is connected
+	 * to the copy.
+	 * @sa runner_interface::fork()
+	 * @return new global store
+	 */
+	virtual globals fork() const = 0;
+
+	/**
+	 * @brief 64 bit hash of the turn count, visit counts and variables.
+	 *
+	 * Equal global stores of the same story have the same hash, e.g. a fork or a store loaded
+	 * from a snapshot. Strings and lists are hashed by content, so the layout of the string and
+	 * list tables does not matter. The hash is updated on each change, so this is O(1) and can
+	 * be used as key for memoization tables. Different stores can have the same hash.
+	 * @sa runner_interface::state_hash()
+	 */
+	virtual uint64_t state_hash() const = 0;
+
 	virtual ~globals_interface() = default;
 
 protected:
@@ -15,6 +15,10 @@
 #	include "Containers/UnrealString.h"
 #endif
 
+#ifdef __cpp_impl_coroutine
+#	include <coroutine>
+#endif
+
 namespace ink::runtime
 {
 class choice;
@@ -76,6 +80,30 @@ public:
 	 */
 	virtual bool can_continue() const = 0;
 
+	/**
+	 * Is the runner waiting for the result of an asynchronous external function?
+	 *
+	 * The line which called the function is continued by the next
+	 * @ref ink::runtime::runner_interface::getline() "getline()" after
+	 * @ref ink::runtime::runner_interface::resume_external() "resume_external()".
+	 * @sa bind_async()
+	 */
+	virtual bool awaiting_external() const = 0;
+
+	/**
+	 * Passes the result of an asynchronous external function to the runner.
+	 *
+	 * @param result return value of the function, strings are copied
+	 * @sa bind_async()
+	 */
+	virtual void resume_external(const value& result) = 0;
+
+	/**
+	 * Finishes an asynchronous external function without result.
+	 * @sa bind_async()
+	 */
+	virtual void resume_external() = 0;
+
 #ifdef INK_ENABLE_CSTD
 	/**
 	 * Continue execution until the next newline, then allocate a c-style
@@ -86,6 +114,16 @@ public:
 	 * @return allocated c-style string with the output of a single line of execution
 	 */
 	virtual const char* getline_alloc() = 0;
+
+	/**
+	 * Like @ref ink::runtime::runner_interface::getline_alloc() "getline_alloc()", but writes the
+	 * line into buffer if it fits. Only longer lines are allocated by the runtime.
+	 *
+	 * @param buffer memory for the line and its terminator
+	 * @param capacity size of buffer in bytes
+	 * @return buffer, or an allocated c-style string if the line did not fit
+	 */
+	virtual const char* getline_alloc(char* buffer, size_t capacity) = 0;
 #endif
 
 	/**
@@ -95,13 +133,57 @@ public:
 	 */
 	virtual snapshot* create_snapshot() const = 0;
 
+	/**
+	 * @brief creates a snapshot like create_snapshot() in the given format.
+	 * @sa globals_interface::create_snapshot(snapshot_format)
+	 */
+	virtual snapshot* create_snapshot(snapshot_format format) const = 0;
+
+	/**
+	 * @brief writes the snapshot of create_snapshot() to a sink without keeping it in memory.
+	 * @sa globals_interface::write_snapshot()
+	 */
+	virtual void write_snapshot(snapshot_sink& sink) const = 0;
+
+	/**
+	 * @brief creates a snapshot which only contains the changes since base.
+	 * @sa globals_interface::create_delta_snapshot()
+	 */
+	virtual snapshot* create_delta_snapshot(const snapshot& base) const = 0;
+
+	/**
+	 * @brief creates an independent copy of this runner and its globals.
+	 *
+	 * The new runner continues at the same position with a copy of the global store,
+	 * changes on the copy do not affect this runner and vice versa.
+	 * Bound external functions are copied, global variable observers are not.
+	 * Custom subclasses of function_base are only copied if they implement clone().
+	 * Other runners connected to the globals are not copied.
+	 * @sa globals_interface::fork()
+	 * @return new runner
+	 */
+	virtual runner fork() const = 0;
+
+	/**
+	 * @brief 64 bit hash of the logical state of the runner and its globals.
+	 *
+	 * Covers the position in the story, callstack, evaluation stack, choices and
+	 * globals_interface::state_hash(), but no addresses, so a fork or a runner loaded from a
+	 * snapshot has the same hash. Runners of the same story with equal hashes continue
+	 * the same way, apart from hash collisions.
+	 * The runner part is computed once after the runner continued and then cached,
+	 * the globals part is updated on each change. Repeated calls are O(1).
+	 */
+	virtual uint64_t state_hash() const = 0;
+
 	/**
 	 * Execute the next line of the script.
 	 *
 	 * Continue execution until the next newline, then returns the output as an STL C++
 	 *`std::string` or Unreal's `FString`.
 	 *
-	 * @return string with the next line of output
+	 * @return string with the next line of output, empty while
+	 *         @ref ink::runtime::runner_interface::awaiting_external() "awaiting_external()"
 	 */
 	virtual line_type getline() = 0;
 
@@ -266,6 +348,10 @@ protected:
 	 * @private */
 	virtual void internal_bind(hash_t name, internal::function_base* function) = 0;
 
+	/** internal hook, called once after the next resume_external(). not for calling.
+	 * @private */
+	virtual void internal_on_resume(void (*callback)(void*), void* data) = 0;
+
 public:
 	/**
 	 * Binds an external callable to the runtime
@@ -307,6 +393,39 @@ public:
 		bind(ink::hash_string(name), function, lookaheadSafe);
 	}
 
+	/**
+	 * Binds an external callable which delivers its result later
+	 *
+	 * The callable receives the arguments like a function bound with bind() and
+	 * returns nothing. The runner stops at the call and reports
+	 * @ref ink::runtime::runner_interface::awaiting_external() "awaiting_external()"
+	 * until the result is passed to
+	 * @ref ink::runtime::runner_interface::resume_external() "resume_external()".
+	 * This allows one thread to drive many runners which wait for slow lookups.
+	 * The function is never called during the glue lookahead.
+	 *
+	 * @param name name hash
+	 * @param function callable
+	 */
+	template<typename F>
+	inline void bind_async(hash_t name, F function)
+	{
+		internal_bind(name, new internal::async_function(function));
+	}
+
+	/**
+	 * Binds an external callable which delivers its result later
+	 *
+	 * @param name name string
+	 * @param function callable
+	 * @sa bind_async(hash_t, F)
+	 */
+	template<typename F>
+	inline void bind_async(const char* name, F function)
+	{
+		bind_async(ink::hash_string(name), function);
+	}
+
 #ifdef INK_ENABLE_UNREAL
 	/** bind and unreal delegate
 	 * @param name hash of external function name in ink script
@@ -365,6 +484,63 @@ public:
 	 */
 	inline const choice* operator[](size_t index) { return get_choice(index); }
 
+#ifdef __cpp_impl_coroutine
+	/**
+	 * Awaitable for the next line, for usage in C++20 coroutines.
+	 *
+	 * If the line calls an asynchronous external function the coroutine is suspended
+	 * and resumed from @ref ink::runtime::runner_interface::resume_external()
+	 * "resume_external()" once the line is complete.
+	 * @sa next_line()
+	 */
+	class line_awaiter
+	{
+	public:
+		explicit line_awaiter(runner_interface& runner)
+		    : _runner(runner)
+		{
+		}
+
+		bool await_ready()
+		{
+			_line = _runner.getline();
+			return ! _runner.awaiting_external();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			_handle = handle;
+			_runner.internal_on_resume(&on_resume, this);
+		}
+
+		line_type await_resume() { return _line; }
+
+	private:
+		static void on_resume(void* data)
+		{
+			line_awaiter& self = *static_cast<line_awaiter*>(data);
+			self._line += self._runner.getline();
+			if (self._runner.awaiting_external()) {
+				self._runner.internal_on_resume(&on_resume, data);
+			} else {
+				self._handle.resume();
+			}
+		}
+
+		runner_interface&       _runner;
+		line_type               _line;
+		std::coroutine_handle<> _handle;
+	};
+
+	/**
+	 * Execute the next line of the script inside a coroutine.
+	 *
+	 * `std::string line = co_await thread->next_line();`
+	 * @return awaitable for the next line
+	 */
+	inline line_awaiter next_line() { return line_awaiter(*this); }
+#endif
+
 #pragma endregion
 };
 } // namespace ink::runtime
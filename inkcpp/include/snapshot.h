@@ -8,8 +8,77 @@
 
 #include "types.h"
 
+#ifdef INK_ENABLE_STL
+#	include <ostream>
+#endif
+#ifdef INK_ENABLE_CSTD
+#	include <cstdio>
+#endif
+
 namespace ink::runtime
 {
+/**
+ * Destination for snapshots written with @ref ink::runtime::globals_interface::write_snapshot().
+ *
+ * The snapshot is passed in order with write(). Its header and offset table are only known
+ * once everything is written, so they are written as zeros first and overwritten with patch()
+ * at the end. Implement it to write snapshots to a custom destination, e.g. in chunks.
+ */
+class snapshot_sink
+{
+public:
+	virtual ~snapshot_sink(){};
+
+	/** append data to the snapshot
+	 * @param data bytes to append
+	 * @param length number of bytes
+	 */
+	virtual void write(const unsigned char* data, size_t length) = 0;
+
+	/** overwrite already written data
+	 * @param offset position from the start of the snapshot
+	 * @param data bytes to write
+	 * @param length number of bytes
+	 */
+	virtual void patch(size_t offset, const unsigned char* data, size_t length) = 0;
+};
+
+#ifdef INK_ENABLE_STL
+/** Writes a snapshot to a seekable std::ostream, starting at its current position.
+ * @throws ink_exception if writing to the stream fails
+ */
+class stream_snapshot_sink : public snapshot_sink
+{
+public:
+	/** @param out stream to write to, must stay valid while writing */
+	stream_snapshot_sink(std::ostream& out);
+
+	void write(const unsigned char* data, size_t length) override;
+	void patch(size_t offset, const unsigned char* data, size_t length) override;
+
+private:
+	std::ostream&  _out;
+	std::streampos _start;
+};
+#endif
+
+#ifdef INK_ENABLE_CSTD
+/** Writes a snapshot to a seekable FILE, starting at its current position. */
+class file_snapshot_sink : public snapshot_sink
+{
+public:
+	/** @param file opened for binary writing, must stay valid while writing */
+	file_snapshot_sink(FILE* file);
+
+	void write(const unsigned char* data, size_t length) override;
+	void patch(size_t offset, const unsigned char* data, size_t length) override;
+
+private:
+	FILE* _file;
+	long  _start;
+};
+#endif
+
 /**
  * Container for an InkCPP runtime snapshot.
  * Each snapshot contains a @ref ink::runtime::globals_interface "globals store"
@@ -38,12 +107,23 @@ public:
 	 */
 	static snapshot* from_binary(const unsigned char* data, size_t length, bool freeOnDestroy = true);
 
+	/** Reconstruct a full snapshot from a chain of delta snapshots.
+	 * @param base full snapshot the first delta was created against
+	 * @param deltas delta snapshots, each created against the result of the previous ones
+	 * @param count number of deltas
+	 * @return newly created full snapshot
+	 * @sa ink::runtime::globals_interface::create_delta_snapshot()
+	 */
+	static snapshot* from_deltas(const snapshot& base, const snapshot* const* deltas, size_t count);
+
 	/** access blob inside snapshot */
 	virtual const unsigned char* get_data() const     = 0;
 	/** size of blob inside snapshot */
 	virtual size_t               get_data_len() const = 0;
 	/** number of runners which are stored inside this snapshot */
 	virtual size_t               num_runners() const  = 0;
+	/** if the snapshot only contains the difference to a base snapshot, see from_deltas() */
+	virtual bool                 is_delta() const     = 0;
 
 #ifdef INK_ENABLE_STL
 	/** deserialize snapshot from file.
@@ -51,6 +131,13 @@ public:
 	 * @throws ink_exception if it fails to open the file
 	 */
 	static snapshot* from_file(const char* filename);
+	/** deserialize snapshot from a memory mapped file.
+	 * Instead of reading the file into an allocated buffer, it is mapped read-only into memory
+	 * until the snapshot is destroyed. The file must not be modified while it is mapped.
+	 * @param filename of input file
+	 * @throws ink_exception if it fails to map the file or the file is not a valid snapshot
+	 */
+	static snapshot* from_mapped_file(const char* filename);
 	/** serialize snapshot to file
 	 * @param filename output file filename, if already exist it will be overwritten
 	 * @throws ink_exception if it fails to open the file
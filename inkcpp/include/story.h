@@ -19,6 +19,10 @@ namespace ink::runtime
  * share globals (variables, visit counts, etc). through the
  * globals object. By default, each runner gets its own newly
  * created globals store.
+ *
+ * A story may be used from multiple threads at the same time, e.g. to create runners
+ * and globals. Each runner and globals store must only be used by one thread at a time,
+ * so runners which share a globals store must run on the same thread.
  * @see ink::runtime::runner_interface
  * @see ink::runtime::globals_interface
  */
@@ -34,6 +38,11 @@ public:
 		 * creating new runners for this story. Note: Can not be
 		 * used for other stories. It is tied to this story.
 		 *
+		 * The store is a copy of an image initialized once per story, so the global
+		 * variables already hold their initial values before a runner is created.
+		 * Observers attached to it receive the initial value when they are attached
+		 * (see globals_interface::observe()), not when the first runner is created.
+		 *
 		 * @return managed pointer to a new global store
 		*/
 		virtual globals new_globals() = 0;
@@ -84,6 +93,21 @@ public:
 		*/
 		static story* from_file(const char* filename);
 
+		/**
+		 * Creates a new story object from a memory mapped file.
+		 *
+		 * Requires STL. Instead of reading the file into an allocated
+		 * buffer, the file is mapped read-only into memory. Pages are
+		 * loaded on first access and shared between all processes mapping
+		 * the same file. The mapping is released when the story is destroyed,
+		 * which also invalidates all runners and globals created from it.
+		 * The file must not be modified while it is mapped.
+		 *
+		 * @param filename filename of the binary ink data
+		 * @return new story object
+		*/
+		static story* from_mapped_file(const char* filename);
+
 		/**
 		 * Create a new story object from binary buffer
 		 *
@@ -97,6 +121,19 @@ public:
 		 * @return new story object
 		*/
 		static story* from_binary(unsigned char* data, size_t length, bool freeOnDestroy = true);
+
+		/**
+		 * Create a new story object from static binary data
+		 *
+		 * No extensions required. Intended for stories embedded into the
+		 * executable (see `inkcpp_cl --embed` and the `inkcpp_embed_story` CMake function).
+		 * The data is neither copied nor freed and must outlive the story.
+		 *
+		 * @param data binary data, should be aligned to 4 bytes
+		 * @param length of the binary data in bytes
+		 * @return new story object
+		*/
+		static story* from_static(const unsigned char* data, size_t length);
 #pragma endregion
 };
 }
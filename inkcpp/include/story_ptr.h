@@ -8,11 +8,15 @@
 
 #include "system.h"
 
+#include <atomic>
+
 namespace ink::runtime
 {
 namespace internal
 {
-	/** @private */
+	/** @private
+	 * reference counts are atomic, so pointers to the same story can be used on multiple threads
+	 */
 	struct ref_block {
 		ref_block()
 		    : references(0)
@@ -20,8 +24,8 @@ namespace internal
 		{
 		}
 
-		size_t references;
-		bool   valid;
+		std::atomic<size_t> references;
+		std::atomic<bool>   valid;
 
 		static void remove_reference(ref_block*&);
 	};
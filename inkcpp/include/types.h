@@ -15,6 +15,17 @@ namespace ink::runtime
 class globals_interface;
 class runner_interface;
 class snapshot;
+class snapshot_sink;
+
+/** Encoding of a snapshot.
+ * The encoding is stored in the snapshot, so snapshots of every format can be loaded.
+ * @sa ink::runtime::globals_interface::create_snapshot(snapshot_format)
+ */
+enum class snapshot_format {
+	standard,   ///< fixed size fields, fastest to create and load, required for delta snapshots
+	compact,    ///< variable length visit counts, an unchanged backup of them is omitted
+	compressed, ///< compact and additionally compressed with the built-in LZ compressor
+};
 
 /** alias for an managed @ref ink::runtime::globals_interface pointer */
 using globals = story_ptr<globals_interface>;
@@ -9,6 +9,7 @@
 #include "traits.h"
 #include "header.h"
 #include "random.h"
+#include "state_hash.h"
 #include "string_utils.h"
 #include "list_impl.h"
 
@@ -32,7 +33,8 @@ void list_table::copy_lists(const data_t* src, data_t* dst)
 }
 
 list_table::list_table(const char* data, const ink::internal::header& header)
-    : _valid{false}
+    : _entrySize{0}
+    , _valid{false}
 {
 	if (data == nullptr) {
 		return;
@@ -521,6 +523,11 @@ list_flag list_table::max(list l) const
 	return res;
 }
 
+void list_table::hash(state_hasher& hasher, list l) const
+{
+	hasher.add(getPtr(l.lid), sizeof(data_t) * _entrySize);
+}
+
 bool list_table::equal(list lh, list rh) const
 {
 	const data_t* l = getPtr(lh.lid);
@@ -838,4 +845,15 @@ const unsigned char* list_table::snap_load(const unsigned char* ptr, const loade
 	return ptr;
 }
 
+void list_table::copy_from(const list_table& other)
+{
+	inkAssert(
+	    _entrySize == other._entrySize,
+	    "Can only copy list entries from a list table of the same story."
+	);
+	_data        = other._data;
+	_entry_state = other._entry_state;
+	_list_handouts.clear();
+}
+
 } // namespace ink::runtime::internal
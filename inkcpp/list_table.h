@@ -22,6 +22,7 @@ struct header;
 namespace ink::runtime::internal
 {
 class prng;
+class state_hasher;
 
 // TODO: move to utils
 // memory segments
@@ -136,6 +137,14 @@ public:
 	size_t               snap(unsigned char* data, const snapper&) const;
 	const unsigned char* snap_load(const unsigned char* data, const loader&);
 
+	/** copies all list entries from other
+	 * @param other list table created from the same story
+	 */
+	void copy_from(const list_table& other);
+
+	/** adds the origins and flags contained in a list to the hash */
+	void hash(state_hasher&, list l) const;
+
 	/** special traitment when a list get assignet again
 	 * when a list get assigned and would have no origin, it gets the origin of the base with origin
 	 * eg. I072
@@ -302,11 +302,25 @@ void basic_stream::forget()
 	_save = npos;
 }
 
-template char* basic_stream::get_alloc<true>(string_table& strings, list_table& lists);
-template char* basic_stream::get_alloc<false>(string_table& strings, list_table& lists);
+void basic_stream::copy_from(const basic_stream& other, const string_table::mapping& strings)
+{
+	inkAssert(other._size <= _max, "Stream is to small to copy data into!");
+	for (size_t i = 0; i < other._size; ++i) {
+		_data[i] = other._data[i];
+		strings(_data[i]);
+	}
+	_size      = other._size;
+	_save      = other._save;
+	_last_char = other._last_char;
+}
+
+template char* basic_stream::get_alloc<true>(string_table&, list_table&, char*, size_t);
+template char* basic_stream::get_alloc<false>(string_table&, list_table&, char*, size_t);
 
 template<bool RemoveTail>
-char* basic_stream::get_alloc(string_table& strings, list_table& lists)
+char* basic_stream::get_alloc(
+    string_table& strings, list_table& lists, char* buffer, size_t capacity
+)
 {
 	size_t start = find_start();
 
@@ -328,12 +342,14 @@ char* basic_stream::get_alloc(string_table& strings, list_table& lists)
 		}
 	}
 
-	// Allocate
-	char* buffer = strings.create(length + 1);
-	char* end    = buffer + length + 1;
-	char* ptr    = buffer;
-	hasGlue      = false;
-	lastNewline  = false;
+	// Allocate, unless the string fits into the given buffer
+	if (length >= capacity) {
+		buffer = strings.create(length + 1);
+	}
+	char* end   = buffer + length + 1;
+	char* ptr   = buffer;
+	hasGlue     = false;
+	lastNewline = false;
 	for (size_t i = start; i < _size; i++) {
 		if (should_skip(i, hasGlue, lastNewline))
 			continue;
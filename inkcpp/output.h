@@ -8,6 +8,7 @@
 
 #include "value.h"
 #include "platform.h"
+#include "string_table.h"
 #include "snapshot_impl.h"
 
 namespace ink
@@ -16,7 +17,6 @@ namespace runtime
 {
 	namespace internal
 	{
-		class string_table;
 		class list_table;
 
 		class basic_stream : public snapshot_interface
@@ -56,11 +56,13 @@ namespace runtime
 			/** Extract to a newly allocated string
 			 * @param string_table place to allocate new string in
 			 * @param list_table needed do parse list values to string
+			 * @param buffer used instead of a new string if the string fits into it
+			 * @param capacity size of buffer
 			 * @tparam RemoveTail if we should remove a tailing space
-			 * @return newly allocated string
+			 * @return newly allocated string or buffer
 			 */
 			template<bool RemoveTail = true>
-			char* get_alloc(string_table&, list_table&);
+			char* get_alloc(string_table&, list_table&, char* buffer = nullptr, size_t capacity = 0);
 
 #ifdef INK_ENABLE_STL
 			// Extract into a string
@@ -117,6 +119,9 @@ namespace runtime
 			void restore();
 			void forget();
 
+			// Copies content and save point of other, strings are replaced with their duplicates
+			void copy_from(const basic_stream& other, const string_table::mapping& strings);
+
 			// add lists definitions, needed to print lists
 			void set_list_meta(const list_table& lists) { _lists_table = &lists; }
 
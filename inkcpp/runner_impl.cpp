@@ -206,87 +206,52 @@ void runner_impl::clear_choices()
 
 snap_tag& runner_impl::add_tag(const char* value, tags_level where)
 {
-	int end      = static_cast<int>(where) + 1;
-	int position = _tags_begin[end];
-	for (size_t i = end; i < _tags_begin.capacity(); ++i) {
-		_tags_begin.set(i, _tags_begin[i] + 1);
-	}
-	return _tags.insert(position) = value;
+	return _tags[static_cast<int>(where)].push() = value;
 }
 
 void runner_impl::copy_tags(tags_level src, tags_level dst)
 {
 	inkAssert(dst < src, "Only support copieng to higher state!");
-	size_t old_size = _tags.size();
-	size_t idx      = _tags_begin[static_cast<int>(src)];
-	size_t n        = _tags_begin[static_cast<int>(src) + 1] - idx;
-	size_t idy      = _tags_begin[static_cast<int>(dst) + 1];
-	for (size_t i = 0; i < n; ++i) {
-		_tags.insert(idy + n) = _tags[idx + i * 2];
-	}
-	for (size_t i = static_cast<int>(dst) + 1; i < _tags_begin.capacity(); ++i) {
-		_tags_begin.set(i, _tags_begin[i] + n);
+	const auto& from = _tags[static_cast<int>(src)];
+	auto&       to   = _tags[static_cast<int>(dst)];
+	for (size_t i = 0; i < from.size(); ++i) {
+		to.push() = from[i];
 	}
-	inkAssert(_tags.size() == old_size + n, "Expected n new elements");
 }
 
 void runner_impl::assign_tags(std::initializer_list<tags_level> wheres)
 {
-	size_t old_size = _tags.size();
-	size_t idy      = _tags_begin[static_cast<int>(tags_level::UNKNOWN)];
-	size_t end      = _tags_begin[static_cast<int>(tags_level::UNKNOWN) + 1];
-	size_t n        = end - idy;
-	if (n == 0) {
+	auto& unknown = _tags[static_cast<int>(tags_level::UNKNOWN)];
+	if (unknown.size() == 0) {
 		return;
 	}
 	for (const tags_level& where : wheres) {
-		size_t idx = _tags_begin[static_cast<int>(where) + 1];
-		idy        = _tags_begin[static_cast<int>(tags_level::UNKNOWN)];
-		end        = _tags_begin[static_cast<int>(tags_level::UNKNOWN) + 1];
-		inkAssert(n == end - idy, "Same size in each iteration");
-		for (size_t i = 0; i < n; ++i) {
-			const char* tag       = _tags[idy + i * 2];
-			_tags.insert(idx + i) = tag;
-		}
-		for (size_t i = static_cast<int>(where) + 1; i < _tags_begin.capacity(); ++i) {
-			_tags_begin.set(i, _tags_begin[i] + n);
+		auto& to = _tags[static_cast<int>(where)];
+		for (size_t i = 0; i < unknown.size(); ++i) {
+			to.push() = unknown[i];
 		}
 	}
-	_tags_begin.set(
-	    static_cast<int>(tags_level::UNKNOWN) + 1, _tags_begin[static_cast<int>(tags_level::UNKNOWN)]
-	);
-	_tags.resize(_tags_begin[static_cast<int>(tags_level::UNKNOWN)]);
-
-	inkAssert(_tags.size() == old_size + (wheres.size() - 1) * n, "Expected to preserve size!");
+	unknown.clear();
 }
 
 void runner_impl::clear_tags(tags_clear_level which)
 {
-	// clear all tags begin which we do not want to keep
-	//
-	// resize to first other field which begins which should not be cleared
+	// clear all levels which we do not want to keep
 	switch (which) {
 		case tags_clear_level::KEEP_NONE:
-			_tags.clear();
-			for (size_t i = 0; i < _tags_begin.capacity(); ++i) {
-				_tags_begin.set(i, 0);
+			for (auto& tags : _tags) {
+				tags.clear();
 			}
 			break;
 		case tags_clear_level::KEEP_GLOBAL_AND_UNKNOWN:
-			_tags.remove(
-			    _tags_begin[static_cast<int>(tags_level::KNOT)],
-			    _tags_begin[static_cast<int>(tags_level::UNKNOWN)]
-			);
-			for (size_t i = static_cast<int>(tags_level::KNOT); i < _tags_begin.capacity(); ++i) {
-				_tags_begin.set(i, _tags_begin[static_cast<int>(tags_level::KNOT)]);
-			}
-			_tags_begin.set(static_cast<int>(tags_level::UNKNOWN) + 1, _tags.size());
+			_tags[static_cast<int>(tags_level::KNOT)].clear();
+			_tags[static_cast<int>(tags_level::LINE)].clear();
+			_tags[static_cast<int>(tags_level::CHOICE)].clear();
 			break;
 		case tags_clear_level::KEEP_KNOT:
-			_tags.resize(_tags_begin[static_cast<int>(tags_level::KNOT) + 1]);
-			for (size_t i = static_cast<int>(tags_level::KNOT) + 2; i < _tags_begin.capacity(); ++i) {
-				_tags_begin.set(i, _tags_begin[static_cast<int>(tags_level::KNOT) + 1]);
-			}
+			_tags[static_cast<int>(tags_level::LINE)].clear();
+			_tags[static_cast<int>(tags_level::CHOICE)].clear();
+			_tags[static_cast<int>(tags_level::UNKNOWN)].clear();
 			break;
 		default: inkAssert(false, "Unhandeld clear type %d for tags.", static_cast<int>(which));
 	}
@@ -475,7 +440,6 @@ runner_impl::runner_impl(const story_impl* data, globals global)
     , _done(nullptr)
     , _evaluation_mode{false}
     , _choices()
-    , _tags_begin(0, ~0)
     , _container(ContainerData{})
     , _rng(time(NULL))
 {
@@ -509,6 +473,10 @@ runner_impl::line_type runner_impl::getline()
 {
 	// Advance interpreter one line and write to output
 	advance_line();
+	if (_awaiting_external) {
+		// the line continues after resume_external
+		return line_type{};
+	}
 
 #ifdef INK_ENABLE_STL
 	line_type result{_output.get()};
@@ -540,7 +508,9 @@ runner_impl::line_type runner_impl::getall()
 	while (can_continue()) {
 		result += getline();
 	}
-	inkAssert(_output.is_empty(), "Output should be empty after getall!");
+	inkAssert(
+	    _awaiting_external || _output.is_empty(), "Output should be empty after getall!"
+	);
 
 	return result;
 }
@@ -554,43 +524,110 @@ void runner_impl::getall(std::ostream& out)
 	while (can_continue()) {
 		out << getline();
 	}
-	inkAssert(_output.is_empty(), "Output should be empty after getall!");
+	inkAssert(
+	    _awaiting_external || _output.is_empty(), "Output should be empty after getall!"
+	);
 }
 #endif
 
 void runner_impl::advance_line()
 {
-	clear_tags(tags_clear_level::KEEP_KNOT);
+	_state_hash_valid = false;
+
+	// an interrupted line keeps its tags
+	if (! _resume_line) {
+		clear_tags(tags_clear_level::KEEP_KNOT);
+	}
+	_resume_line = false;
 
 	// Step while we still have instructions to execute
-	while (_ptr != nullptr) {
+	while (_ptr != nullptr && ! _awaiting_external) {
 		// Stop if we hit a new line
 		if (line_step()) {
 			break;
 		}
 	}
 
+	// Keep the state of the line until the external function returns
+	if (_awaiting_external) {
+		_resume_line = true;
+		return;
+	}
+
 	// can be in save state becaues of choice
 	// Garbage collection TODO: How often do we want to do this?
 	if (_saved) {
 		restore();
 	}
+	_globals->flush_observers();
 	_globals->gc();
 	if (_output.saved()) {
 		_output.restore();
 	}
 }
 
-bool runner_impl::can_continue() const { return _ptr != nullptr && ! has_choices(); }
+bool runner_impl::can_continue() const
+{
+	return _ptr != nullptr && ! has_choices() && ! _awaiting_external;
+}
+
+void runner_impl::resume_external(const ink::runtime::value& result)
+{
+	inkAssert(_awaiting_external, "No asynchronous external function to resume!");
+	internal::value val{};
+	if (result.type == ink::runtime::value::Type::String) {
+		// the string is owned by the caller, copy it to the string table
+		const char* src = result.get<ink::runtime::value::Type::String>();
+		size_t      len = 0;
+		while (src[len] != 0) {
+			++len;
+		}
+		char* str = _globals->strings().create(len + 1);
+		for (size_t i = 0; i <= len; ++i) {
+			str[i] = src[i];
+		}
+		val = value{}.set<value_type::string>(static_cast<const char*>(str), true);
+	} else if (! val.set(result)) {
+		inkFail("Unsupported type for external function result!");
+	}
+	_eval.push(val);
+	resumed_external();
+}
+
+void runner_impl::resume_external()
+{
+	inkAssert(_awaiting_external, "No asynchronous external function to resume!");
+	_eval.push(values::null);
+	resumed_external();
+}
+
+void runner_impl::resumed_external()
+{
+	_awaiting_external = false;
+	_state_hash_valid  = false;
+	if (_on_resume != nullptr) {
+		auto callback = _on_resume;
+		_on_resume    = nullptr;
+		callback(_on_resume_data);
+	}
+}
+
+void runner_impl::internal_on_resume(void (*callback)(void*), void* data)
+{
+	_on_resume      = callback;
+	_on_resume_data = data;
+}
 
 void runner_impl::choose(size_t index)
 {
+	inkAssert(! _awaiting_external, "Can not choose while waiting for an external function!");
 	if (has_choices()) {
 		inkAssert(index < _choices.size(), "Choice index out of range");
 	} else if (! _fallback_choice) {
 		inkAssert(false, "No choice and no Fallbackchoice!! can not choose");
 	}
 	_globals->turn();
+	_state_hash_valid = false;
 	// Get the choice
 	const auto& c = has_choices() ? _choices[index] : _fallback_choice.value();
 
@@ -628,11 +665,140 @@ void runner_impl::getline_silent()
 {
 	// advance and clear output stream
 	advance_line();
-	_output.clear();
+	if (! _awaiting_external) {
+		_output.clear();
+	}
 }
 
 snapshot* runner_impl::create_snapshot() const { return _globals->create_snapshot(); }
 
+snapshot* runner_impl::create_snapshot(snapshot_format format) const
+{
+	return _globals->create_snapshot(format);
+}
+
+void runner_impl::write_snapshot(snapshot_sink& sink) const { _globals->write_snapshot(sink); }
+
+snapshot* runner_impl::create_delta_snapshot(const snapshot& base) const
+{
+	return _globals->create_delta_snapshot(base);
+}
+
+void runner_impl::hash(state_hasher& hasher) const
+{
+	// instruction pointers are hashed as offsets, 0 is reserved for nullptr
+	auto offset = [this](ip_t ptr) -> uint64_t {
+		return ptr == nullptr ? 0 : ptr - _story->instructions() + 1;
+	};
+	const list_table& lists = _globals->lists();
+	hasher.add(offset(_ptr));
+	hasher.add(offset(_done));
+	hasher.add(static_cast<uint64_t>(_rng.get_state()));
+	hasher.add(
+	    static_cast<uint64_t>(_evaluation_mode) | _string_mode << 1 | _is_falling << 2
+	    | _entered_global << 3 | _awaiting_external << 4
+	);
+	hasher.add(static_cast<uint64_t>(_current_knot_id) << 32 | _entered_knot);
+	_stack.hash(hasher, lists);
+	_ref_stack.hash(hasher, lists);
+	_eval.hash(hasher, lists);
+
+	const ContainerData* container = nullptr;
+	while (_container.iter(container)) {
+		hasher.add(static_cast<uint64_t>(container->id) << 32 | offset(container->offset));
+	}
+
+	// the thread stack is cleared when choosing, only the ids are relevant
+	const thread_t* thread = nullptr;
+	while (_threads.iter(thread)) {
+		hasher.add(static_cast<uint64_t>(*thread));
+	}
+
+	for (const choice& c : _choices) {
+		hasher.add(static_cast<uint64_t>(c.path()) << 32 | c._thread);
+		hasher.add(c.text());
+	}
+	if (_fallback_choice) {
+		const choice& c = _fallback_choice.value();
+		hasher.add(static_cast<uint64_t>(c.path()) << 32 | c._thread);
+	}
+}
+
+uint64_t runner_impl::state_hash() const
+{
+	if (! _state_hash_valid) {
+		state_hasher hasher;
+		hash(hasher);
+		_state_hash       = hasher.get();
+		_state_hash_valid = true;
+	}
+	return _state_hash ^ hash_mix(_globals->state_hash());
+}
+
+runner runner_impl::fork() const
+{
+	string_table::mapping strings;
+	globals               store(new globals_impl(*_globals, strings), _story->block());
+	runner_impl*          run = new runner_impl(_story, store);
+	run->copy_from(*this, strings);
+	return runner(run, _story->block());
+}
+
+void runner_impl::copy_from(const runner_impl& other, const string_table::mapping& strings)
+{
+	_state_hash_valid       = false;
+	_ptr                    = other._ptr;
+	_backup                 = other._backup;
+	_done                   = other._done;
+	_rng                    = other._rng;
+	_evaluation_mode        = other._evaluation_mode;
+	_string_mode            = other._string_mode;
+	_saved_evaluation_mode  = other._saved_evaluation_mode;
+	_saved                  = other._saved;
+	_is_falling             = other._is_falling;
+	_awaiting_external      = other._awaiting_external;
+	_resume_line            = other._resume_line;
+	_entered_global         = other._entered_global;
+	_entered_knot           = other._entered_knot;
+	_current_knot_id        = other._current_knot_id;
+	_current_knot_id_backup = other._current_knot_id_backup;
+	_output.copy_from(other._output, strings);
+	_stack.copy_from(other._stack, strings);
+	_ref_stack.copy_from(other._ref_stack, strings);
+	_eval.copy_from(other._eval, strings);
+	for (size_t i = 0; i < std::size(_tags); ++i) {
+		_tags[i] = other._tags[i];
+		for (snap_tag& tag : _tags[i]) {
+			tag = strings(tag.text());
+		}
+	}
+	_container.copy_from(other._container);
+	_threads.copy_from(other._threads);
+
+	// choices point into the string table and the tag list
+	auto& tags        = _tags[static_cast<int>(tags_level::CHOICE)];
+	auto& other_tags  = other._tags[static_cast<int>(tags_level::CHOICE)];
+	auto  copy_choice = [&tags, &other_tags, &strings](snap_choice& c) {
+		c._text = strings(c._text);
+		if (c._tags_start != nullptr) {
+			c._tags_start = tags.begin() + (c._tags_start - other_tags.begin());
+			c._tags_end   = tags.begin() + (c._tags_end - other_tags.begin());
+		}
+	};
+	_fallback_choice = other._fallback_choice;
+	if (_fallback_choice) {
+		copy_choice(_fallback_choice.value());
+	}
+	_choices = other._choices;
+	for (snap_choice& c : _choices) {
+		copy_choice(c);
+	}
+	_functions.copy_from(other._functions);
+#ifdef INK_ENABLE_STL
+	_debug_stream = other._debug_stream;
+#endif
+}
+
 size_t runner_impl::snap(unsigned char* data, snapper& snapper) const
 {
 	unsigned char* ptr          = data;
@@ -649,18 +815,23 @@ size_t runner_impl::snap(unsigned char* data, snapper& snapper) const
 	ptr                         = snap_write(ptr, _saved_evaluation_mode, should_write);
 	ptr                         = snap_write(ptr, _saved, should_write);
 	ptr                         = snap_write(ptr, _is_falling, should_write);
+	ptr                         = snap_write(ptr, _awaiting_external, should_write);
+	ptr                         = snap_write(ptr, _resume_line, should_write);
 	ptr += _output.snap(data ? ptr : nullptr, snapper);
 	ptr += _stack.snap(data ? ptr : nullptr, snapper);
 	ptr += _ref_stack.snap(data ? ptr : nullptr, snapper);
 	ptr += _eval.snap(data ? ptr : nullptr, snapper);
-	ptr += _tags_begin.snap(data ? ptr : nullptr, snapper);
-	ptr += _tags.snap(data ? ptr : nullptr, snapper);
+	for (const auto& tags : _tags) {
+		ptr += tags.snap(data ? ptr : nullptr, snapper);
+	}
 	ptr = snap_write(ptr, _entered_global, should_write);
 	ptr = snap_write(ptr, _entered_knot, should_write);
 	ptr = snap_write(ptr, _current_knot_id, should_write);
 	ptr = snap_write(ptr, _current_knot_id_backup, should_write);
 	ptr += _container.snap(data ? ptr : nullptr, snapper);
 	ptr += _threads.snap(data ? ptr : nullptr, snapper);
+	// choice tags are stored as offsets into the choice tag list
+	snapper.runner_tags = _tags[static_cast<int>(tags_level::CHOICE)].data();
 	ptr = snap_write(ptr, _fallback_choice.has_value(), should_write);
 	if (_fallback_choice) {
 		ptr += _fallback_choice.value().snap(data ? ptr : nullptr, snapper);
@@ -671,6 +842,8 @@ size_t runner_impl::snap(unsigned char* data, snapper& snapper) const
 
 const unsigned char* runner_impl::snap_load(const unsigned char* data, loader& loader)
 {
+	_state_hash_valid = false;
+
 	auto           ptr = data;
 	std::uintptr_t offset;
 	ptr     = snap_read(ptr, offset);
@@ -687,12 +860,15 @@ const unsigned char* runner_impl::snap_load(const unsigned char* data, loader& l
 	ptr = snap_read(ptr, _saved_evaluation_mode);
 	ptr = snap_read(ptr, _saved);
 	ptr = snap_read(ptr, _is_falling);
+	ptr = snap_read(ptr, _awaiting_external);
+	ptr = snap_read(ptr, _resume_line);
 	ptr = _output.snap_load(ptr, loader);
 	ptr = _stack.snap_load(ptr, loader);
 	ptr = _ref_stack.snap_load(ptr, loader);
 	ptr = _eval.snap_load(ptr, loader);
-	ptr = _tags_begin.snap_load(ptr, loader);
-	ptr = _tags.snap_load(ptr, loader);
+	for (auto& tags : _tags) {
+		ptr = tags.snap_load(ptr, loader);
+	}
 	ptr = snap_read(ptr, _entered_global);
 	ptr = snap_read(ptr, _entered_knot);
 	ptr = snap_read(ptr, _current_knot_id);
@@ -711,10 +887,15 @@ const unsigned char* runner_impl::snap_load(const unsigned char* data, loader& l
 }
 
 #ifdef INK_ENABLE_CSTD
-const char* runner_impl::getline_alloc()
+const char* runner_impl::getline_alloc() { return getline_alloc(nullptr, 0); }
+
+const char* runner_impl::getline_alloc(char* buffer, size_t capacity)
 {
 	advance_line();
-	const char* res = _output.get_alloc(_globals->strings(), _globals->lists());
+	if (_awaiting_external) {
+		return "";
+	}
+	const char* res = _output.get_alloc(_globals->strings(), _globals->lists(), buffer, capacity);
 	if (! has_choices() && _fallback_choice) {
 		choose(~0);
 	}
@@ -752,7 +933,12 @@ runner_impl::change_type runner_impl::detect_change() const
 	// Check if the old newline is still present (hasn't been glu'd) and
 	//  if there is new text (non-whitespace) in the stream since saving
 	bool stillHasNewline = _output.ends_with(value_type::newline, _output.save_offset());
-	bool hasAddedNewText = _output.text_past_save() || _tags.last_size() < _tags.size();
+	size_t tags = 0, saved_tags = 0;
+	for (const auto& level : _tags) {
+		tags += level.size();
+		saved_tags += level.last_size();
+	}
+	bool hasAddedNewText = _output.text_past_save() || saved_tags < tags;
 
 	// Newline is still there and there's no new text
 	if (stillHasNewline && ! hasAddedNewText) {
@@ -1252,6 +1438,11 @@ void runner_impl::step()
 						_output.append(values::null);
 					} else {
 						fn->call(&_eval, numArguments, _globals->strings(), _globals->lists());
+						if (fn->is_async()) {
+							// the result is pushed by resume_external
+							_eval.pop();
+							_awaiting_external = true;
+						}
 					}
 				} break;
 
@@ -1366,11 +1557,27 @@ void runner_impl::step()
 
 					// Fetch tags related to the current choice
 
-					size_t start = _tags_begin[static_cast<int>(tags_level::CHOICE) + 1];
+					auto&           tags     = _tags[static_cast<int>(tags_level::CHOICE)];
+					size_t          start    = tags.size();
+					const snap_tag* old_data = tags.data();
 					assign_tags({tags_level::CHOICE});
-					const snap_tag* tags_start = _tags.data() + start;
-					const snap_tag* tags_end
-					    = _tags.data() + _tags_begin[static_cast<int>(tags_level::CHOICE) + 1];
+					if (tags.data() != old_data) {
+						// the tag list grew, point the earlier choices to the new storage
+						auto rebase = [&tags, old_data](snap_choice& c) {
+							if (c._tags_start != nullptr) {
+								c._tags_start = tags.data() + (c._tags_start - old_data);
+								c._tags_end   = tags.data() + (c._tags_end - old_data);
+							}
+						};
+						if (_fallback_choice) {
+							rebase(_fallback_choice.value());
+						}
+						for (snap_choice& c : _choices) {
+							rebase(c);
+						}
+					}
+					const snap_tag* tags_start = tags.data() + start;
+					const snap_tag* tags_end   = tags.data() + tags.size();
 
 					// Create choice and record it
 					choice* current_choice = nullptr;
@@ -1486,6 +1693,69 @@ void runner_impl::step()
 				case Command::TAG: {
 					add_tag(read<const char*>(), tags_level::UNKNOWN);
 				} break;
+
+				// == Superinstructions, behave like the sequence they replace
+				case Command::STR_NEWLINE: {
+					const char* str = read<const char*>();
+
+#ifdef INK_ENABLE_STL
+					if (_debug_stream != nullptr) {
+						*_debug_stream << "str \"" << str << "\"";
+					}
+#endif
+
+					if (_evaluation_mode) {
+						_eval.push(value{}.set<value_type::string>(str));
+						_eval.push(values::newline);
+					} else {
+						_output << value{}.set<value_type::string>(str);
+						if (! _output.ends_with(value_type::newline)) {
+							_output << values::newline;
+						}
+					}
+				} break;
+				case Command::OUTPUT_VARIABLE: {
+					hash_t       variableName = read<hash_t>();
+					const value* val          = get_var(variableName);
+
+#ifdef INK_ENABLE_STL
+					if (_debug_stream != nullptr) {
+						*_debug_stream << "variable_name ";
+						write_hash(*_debug_stream, variableName);
+					}
+#endif
+
+					inkAssert(val != nullptr, "Could not find variable!");
+					_evaluation_mode = true;
+					_output << *val;
+				} break;
+				case Command::DIVERT_IF_READ_COUNT:
+				case Command::DIVERT_IF_VARIABLE: {
+					uint32_t condition = read<uint32_t>();
+					uint32_t target    = read<uint32_t>();
+
+#ifdef INK_ENABLE_STL
+					if (_debug_stream != nullptr) {
+						*_debug_stream << "target " << target;
+					}
+#endif
+
+					_evaluation_mode = false;
+					bool divert;
+					if (cmd == Command::DIVERT_IF_READ_COUNT) {
+						divert = _globals->visits(condition) != 0;
+					} else {
+						const value* val = get_var(condition);
+						inkAssert(val != nullptr, "Could not find variable!");
+						divert = val->truthy(_globals->lists());
+					}
+					if (divert) {
+						inkAssert(
+						    _story->instructions() + target < _story->end(), "Diverting past end of story data!"
+						);
+						jump(_story->instructions() + target, true, false);
+					}
+				} break;
 				default: inkAssert(false, "Unrecognized command!"); break;
 			}
 		}
@@ -1553,12 +1823,15 @@ void runner_impl::reset()
 	_stack.clear();
 	_ref_stack.clear();
 	_threads.clear();
-	_evaluation_mode = false;
-	_saved           = false;
+	_evaluation_mode   = false;
+	_saved             = false;
+	_awaiting_external = false;
+	_resume_line       = false;
 	_choices.clear();
 	_ptr  = nullptr;
 	_done = nullptr;
 	_container.clear();
+	_state_hash_valid = false;
 }
 
 void runner_impl::mark_used(string_table& strings, list_table& lists) const
@@ -1570,8 +1843,10 @@ void runner_impl::mark_used(string_table& strings, list_table& lists) const
 	_eval.mark_used(strings, lists);
 
 	// Take into account tags
-	for (size_t i = 0; i < _tags.size(); ++i) {
-		strings.mark_used(_tags[i]);
+	for (const auto& tags : _tags) {
+		for (size_t i = 0; i < tags.size(); ++i) {
+			strings.mark_used(tags[i]);
+		}
 	}
 	// Take into account choice text
 	for (size_t i = 0; i < _choices.size(); i++) {
@@ -1593,8 +1868,9 @@ void runner_impl::save()
 	_eval.save();
 	_threads.save();
 	_choices.save();
-	_tags.save();
-	_tags_begin.save();
+	for (auto& tags : _tags) {
+		tags.save();
+	}
 	_saved_evaluation_mode  = _evaluation_mode;
 	_current_knot_id_backup = _current_knot_id;
 
@@ -1617,8 +1893,9 @@ void runner_impl::restore()
 	_eval.restore();
 	_threads.restore();
 	_choices.restore();
-	_tags.restore();
-	_tags_begin.restore();
+	for (auto& tags : _tags) {
+		tags.restore();
+	}
 	_evaluation_mode        = _saved_evaluation_mode;
 	_current_knot_id        = _current_knot_id_backup;
 	_current_knot_id_backup = ~0;
@@ -1643,8 +1920,9 @@ void runner_impl::forget()
 	_eval.forget();
 	_threads.forget();
 	_choices.forgett();
-	_tags.forgett();
-	_tags_begin.forget();
+	for (auto& tags : _tags) {
+		tags.forgett();
+	}
 	_current_knot_id_backup = ~0;
 	// Nothing to do for eval stack. It should just stay as it is
 
@@ -52,6 +52,12 @@ public:
 	// used by the globals object to do garbage collection
 	void mark_used(string_table&, list_table&) const;
 
+	// Adds the state which decides how the story continues to the hash, globals are not included
+	void hash(state_hasher&) const;
+
+	// globals used by this runner
+	const globals_impl& get_globals() const { return *_globals; }
+
 	// enable debugging when steppnig through the execution
 #ifdef INK_ENABLE_STL
 	void set_debug_enabled(std::ostream* debug_stream) { _debug_stream = debug_stream; }
@@ -60,11 +66,22 @@ public:
 #pragma region runner Implementation
 
 	// sets seed for prng in runner
-	virtual void set_rng_seed(uint32_t seed) override { _rng.srand(seed); }
+	virtual void set_rng_seed(uint32_t seed) override
+	{
+		_rng.srand(seed);
+		_state_hash_valid = false;
+	}
 
 	// Checks that the runner can continue
 	virtual bool can_continue() const override;
 
+	// Checks if the runner waits for an asynchronous external function
+	virtual bool awaiting_external() const override { return _awaiting_external; }
+
+	// Passes the result of the asynchronous external function
+	virtual void resume_external(const ink::runtime::value& result) override;
+	virtual void resume_external() override;
+
 	// Begin iterating choices
 	virtual const choice* begin() const override { return _choices.begin(); }
 
@@ -117,6 +134,12 @@ public:
 	virtual hash_t get_current_knot() const override;
 
 	snapshot* create_snapshot() const override;
+	snapshot* create_snapshot(snapshot_format format) const override;
+	void      write_snapshot(snapshot_sink& sink) const override;
+	snapshot* create_delta_snapshot(const snapshot& base) const override;
+
+	runner   fork() const override;
+	uint64_t state_hash() const override;
 
 	size_t               snap(unsigned char* data, snapper&) const;
 	const unsigned char* snap_load(const unsigned char* data, loader&);
@@ -124,6 +147,7 @@ public:
 #ifdef INK_ENABLE_CSTD
 	// c-style getline
 	virtual const char* getline_alloc() override;
+	virtual const char* getline_alloc(char* buffer, size_t capacity) override;
 #endif
 
 	// move to path
@@ -148,10 +172,16 @@ protected:
 	// bind external
 	virtual void internal_bind(hash_t name, internal::function_base* function) override;
 
+	// called after the next resume_external
+	virtual void internal_on_resume(void (*callback)(void*), void* data) override;
+
 private:
 	// Advances the interpreter by a line. This fills the output buffer
 	void advance_line();
 
+	// Continues after the result of an asynchronous external function is on the eval stack
+	void resumed_external();
+
 	// Steps the interpreter a single instruction and returns
 	//  when it has hit a new line
 	bool line_step();
@@ -162,6 +192,9 @@ private:
 	// Resets the runtime
 	void reset();
 
+	// Copies the complete state of other, strings maps strings to the forked globals
+	void copy_from(const runner_impl& other, const string_table::mapping& strings);
+
 	// == Save/Restore
 	void save();
 	void restore();
@@ -270,6 +303,12 @@ public:
 			_threadDone.forget();
 		}
 
+		void copy_from(const threads& other)
+		{
+			base::copy_from(other);
+			_threadDone.copy_from(other._threadDone);
+		}
+
 		void set(size_t index, const ip_t& value) { _threadDone.set(index, value); }
 
 		const ip_t& get(size_t index) const { return _threadDone.get(index); }
@@ -325,11 +364,9 @@ private:
 	managed_restorable_array < snap_choice, config::maxChoices<0, abs(config::maxChoices)> _choices;
 	optional<snap_choice> _fallback_choice;
 
-	// Tag list
-	managed_restorable_array < snap_tag,
-	    config::limitActiveTags<0, abs(config::limitActiveTags)>                     _tags;
-	// where to the different tags type start
-	internal::fixed_restorable_array<int, static_cast<int>(tags_level::UNKNOWN) + 2> _tags_begin;
+	// Tag lists, one per level, so adding and assigning tags only appends
+	managed_restorable_array < snap_tag, config::limitActiveTags<0,
+	    abs(config::limitActiveTags)> _tags[static_cast<int>(tags_level::UNKNOWN) + 1];
 
 	// TODO: Move to story? Both?
 	functions _functions;
@@ -351,8 +388,20 @@ private:
 
 	bool _saved = false;
 
+	// Waiting for the result of an asynchronous external function
+	bool _awaiting_external = false;
+	// The current line was interrupted by an asynchronous external function
+	bool _resume_line       = false;
+	// Called once after the next resume_external
+	void (*_on_resume)(void*) = nullptr;
+	void* _on_resume_data     = nullptr;
+
 	prng _rng;
 
+	// hash() of the current state, computed on demand and invalidated when the runner continues
+	mutable uint64_t _state_hash       = 0;
+	mutable bool     _state_hash_valid = false;
+
 #ifdef INK_ENABLE_STL
 	std::ostream* _debug_stream = nullptr;
 #endif
@@ -397,18 +446,16 @@ bool runner_impl::has_tags() const
 template<runner_impl::tags_level L>
 size_t runner_impl::num_tags() const
 {
-	return _tags_begin[static_cast<int>(L) + 1] - _tags_begin[static_cast<int>(L)];
+	return _tags[static_cast<int>(L)].size();
 }
 
 template<runner_impl::tags_level L>
 const char* runner_impl::get_tag(size_t index) const
 {
-	size_t begin = _tags_begin[static_cast<int>(L)];
-	size_t end   = _tags_begin[static_cast<int>(L) + 1];
-	if (begin + index >= end || begin + index < begin) {
+	if (index >= num_tags<L>()) {
 		return nullptr;
 	}
-	return _tags[begin + index];
+	return _tags[static_cast<int>(L)][index];
 }
 
 
@@ -44,6 +44,9 @@ public:
 	void restore();
 	void forget();
 
+	// Copies content and save state of another stack
+	void copy_from(const simple_restorable_stack<T>& other);
+
 	virtual size_t               snap(unsigned char* data, const snapper&) const;
 	virtual const unsigned char* snap_load(const unsigned char* data, const loader&);
 
@@ -285,6 +288,26 @@ inline void simple_restorable_stack<T>::forget()
 	_save = _jump = InvalidIndex;
 }
 
+template<typename T>
+inline void simple_restorable_stack<T>::copy_from(const simple_restorable_stack<T>& other)
+{
+	inkAssert(other._null == _null, "null value is different in copy source!");
+	size_t max = other._pos;
+	if (other._save != InvalidIndex && other._save > max) {
+		max = other._save;
+	}
+	// grow to the same capacity, derived classes may keep data in parallel to the stack
+	while (_size < other._size) {
+		overflow(_buffer, _size);
+	}
+	for (size_t i = 0; i < max; ++i) {
+		_buffer[i] = other._buffer[i];
+	}
+	_pos  = other._pos;
+	_save = other._save;
+	_jump = other._jump;
+}
+
 template<typename T>
 size_t simple_restorable_stack<T>::snap(unsigned char* data, const snapper&) const
 {
@@ -324,6 +347,7 @@ const unsigned char*
 	if (_jump != InvalidIndex && _jump > max) {
 		max = _jump;
 	}
+	inkAssert(max <= loader.remaining(ptr) / sizeof(T), "Corrupted snapshot");
 	while (_size < max) {
 		overflow(_buffer, _size);
 	}
@@ -17,9 +17,45 @@
 
 namespace ink::runtime
 {
+namespace
+{
+	// frees data when leaving the scope, unless it was released
+	struct data_guard {
+		const unsigned char* data;
+
+		~data_guard() { delete[] data; }
+
+		void release() { data = nullptr; }
+	};
+} // namespace
+
 snapshot* snapshot::from_binary(const unsigned char* data, size_t length, bool freeOnDestroy)
 {
-	return new internal::snapshot_impl(data, length, freeOnDestroy);
+	// the destructor does not run for snapshots which fail validation
+	data_guard guard{freeOnDestroy ? data : nullptr};
+	snapshot*  result = new internal::snapshot_impl(data, length, freeOnDestroy);
+	guard.release();
+	return result;
+}
+
+snapshot* snapshot::from_deltas(const snapshot& base, const snapshot* const* deltas, size_t count)
+{
+	using internal::snapshot_impl;
+	const snapshot_impl& full   = static_cast<const snapshot_impl&>(base);
+	snapshot_impl*       result = nullptr;
+	if (count == 0) {
+		unsigned char* data = new unsigned char[full.get_data_len()];
+		memcpy(data, full.get_data(), full.get_data_len());
+		return new snapshot_impl(data, full.get_data_len(), true);
+	}
+	for (size_t i = 0; i < count; ++i) {
+		snapshot_impl* next = snapshot_impl::apply_delta(
+		    result ? *result : full, static_cast<const snapshot_impl&>(*deltas[i])
+		);
+		delete result;
+		result = next;
+	}
+	return result;
 }
 
 #ifdef INK_ENABLE_STL
@@ -39,6 +75,19 @@ snapshot* snapshot::from_file(const char* filename)
 	return from_binary(data, length);
 }
 
+snapshot* snapshot::from_mapped_file(const char* filename)
+{
+	size_t         length = 0;
+	unsigned char* data   = internal::map_file_into_memory(filename, &length);
+	try {
+		return new internal::snapshot_impl(data, length, false, true);
+	} catch (...) {
+		// the destructor does not run for snapshots which fail validation
+		internal::unmap_file_from_memory(data, length);
+		throw;
+	}
+}
+
 void snapshot::write_to_file(const char* filename) const
 {
 	std::ofstream ofs(filename, std::ios::binary);
@@ -47,11 +96,461 @@ void snapshot::write_to_file(const char* filename) const
 	}
 	ofs.write(reinterpret_cast<const char*>(get_data()), get_data_len());
 }
+
+stream_snapshot_sink::stream_snapshot_sink(std::ostream& out)
+    : _out{out}
+    , _start{out.tellp()}
+{
+}
+
+void stream_snapshot_sink::write(const unsigned char* data, size_t length)
+{
+	_out.write(reinterpret_cast<const char*>(data), length);
+	if (! _out) {
+		throw ink_exception("Failed to write snapshot to stream");
+	}
+}
+
+void stream_snapshot_sink::patch(size_t offset, const unsigned char* data, size_t length)
+{
+	std::streampos end = _out.tellp();
+	_out.seekp(_start + static_cast<std::streamoff>(offset));
+	_out.write(reinterpret_cast<const char*>(data), length);
+	_out.seekp(end);
+	if (! _out) {
+		throw ink_exception("Failed to write snapshot to stream");
+	}
+}
+#endif
+
+#ifdef INK_ENABLE_CSTD
+file_snapshot_sink::file_snapshot_sink(FILE* file)
+    : _file{file}
+    , _start{ftell(file)}
+{
+}
+
+void file_snapshot_sink::write(const unsigned char* data, size_t length)
+{
+	size_t written = fwrite(data, 1, length, _file);
+	inkAssert(written == length, "Failed to write snapshot to file");
+}
+
+void file_snapshot_sink::patch(size_t offset, const unsigned char* data, size_t length)
+{
+	long end = ftell(_file);
+	fseek(_file, _start + static_cast<long>(offset), SEEK_SET);
+	size_t written = fwrite(data, 1, length, _file);
+	fseek(_file, end, SEEK_SET);
+	inkAssert(written == length, "Failed to write snapshot to file");
+}
 #endif
 } // namespace ink::runtime
 
 namespace ink::runtime::internal
 {
+namespace
+{
+	// collects a snapshot in memory
+	class buffer_sink : public snapshot_sink
+	{
+	public:
+		~buffer_sink() { delete[] _data; }
+
+		void write(const unsigned char* data, size_t length) override
+		{
+			memcpy(append(length), data, length);
+		}
+
+		void patch(size_t offset, const unsigned char* data, size_t length) override
+		{
+			memcpy(_data + offset, data, length);
+		}
+
+		// grows the buffer by length uninitialized bytes
+		unsigned char* append(size_t length)
+		{
+			if (_length + length > _capacity) {
+				reserve(_capacity * 2 > _length + length ? _capacity * 2 : _length + length);
+			}
+			_length += length;
+			return _data + _length - length;
+		}
+
+		void reserve(size_t capacity)
+		{
+			if (capacity <= _capacity) {
+				return;
+			}
+			unsigned char* data = new unsigned char[capacity];
+			if (_data) {
+				memcpy(data, _data, _length);
+			}
+			delete[] _data;
+			_data     = data;
+			_capacity = capacity;
+		}
+
+		const unsigned char* data() const { return _data; }
+
+		size_t length() const { return _length; }
+
+		// hands the buffer over to the caller
+		unsigned char* release()
+		{
+			unsigned char* data = _data;
+			_data               = nullptr;
+			_length = _capacity = 0;
+			return data;
+		}
+
+	private:
+		unsigned char* _data     = nullptr;
+		size_t         _length   = 0;
+		size_t         _capacity = 0;
+	};
+
+	// FNV-1a over 8 byte words, to detect deltas applied to the wrong base
+	uint64_t checksum(const unsigned char* data, size_t length)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		size_t   i    = 0;
+		for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, data + i, sizeof(word));
+			hash = (hash ^ word) * 1099511628211ull;
+		}
+		for (; i < length; ++i) {
+			hash = (hash ^ data[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// granularity in which parts are compared with the base
+	constexpr size_t DELTA_BLOCK = 32;
+
+	// marks the blocks of data which are equal to base, aligned at the start or at the end
+	void compare_blocks(
+	    bool* same, const unsigned char* data, size_t length, const unsigned char* base,
+	    size_t base_length, bool align_end
+	)
+	{
+		size_t blocks = (length + DELTA_BLOCK - 1) / DELTA_BLOCK;
+		for (size_t i = 0; i < blocks;) {
+			// most data is unchanged, so compare multiple blocks at once first
+			size_t span = i + 8 <= blocks ? 8 : 1;
+			for (; span > 0; span = span == 8 ? 1 : 0) {
+				size_t begin = i * DELTA_BLOCK;
+				size_t end = (i + span) * DELTA_BLOCK < length ? (i + span) * DELTA_BLOCK : length;
+				bool   equal
+				    = align_end
+				        ? begin + base_length >= length
+				              && memcmp(data + begin, base + begin + base_length - length, end - begin) == 0
+				        : end <= base_length && memcmp(data + begin, base + begin, end - begin) == 0;
+				if (equal || span == 1) {
+					for (size_t j = i; j < i + span; ++j) {
+						same[j] = equal;
+					}
+					i += span;
+					break;
+				}
+			}
+		}
+	}
+
+	// size of the block of data at offset
+	size_t block_size(size_t offset, size_t length)
+	{
+		return offset + DELTA_BLOCK < length ? DELTA_BLOCK : length - offset;
+	}
+
+	// offset of the first block at or after offset which differs from base, or length
+	size_t skip_equal(
+	    const unsigned char* data, const unsigned char* base, size_t offset, size_t length
+	)
+	{
+		// most data is unchanged, so compare large spans first and narrow down on a difference
+		for (size_t span = DELTA_BLOCK * 256; span >= DELTA_BLOCK; span /= 16) {
+			while (offset < length) {
+				size_t size = offset + span < length ? span : length - offset;
+				if (memcmp(data + offset, base + offset, size) != 0) {
+					break;
+				}
+				offset += size;
+			}
+		}
+		return offset;
+	}
+
+	void write_size(buffer_sink& out, size_t value)
+	{
+		out.write(reinterpret_cast<const unsigned char*>(&value), sizeof(value));
+	}
+
+	// a patch replaces size bytes at offset with data
+	void write_patch(buffer_sink& out, size_t offset, const unsigned char* data, size_t size)
+	{
+		write_size(out, offset);
+		write_size(out, size);
+		out.write(data, size);
+	}
+
+	// A section of a part is stored as its length, a split position and a list of patches.
+	// Before the split the section is compared with the base aligned at the start, after the split
+	// aligned at the end, so one insertion or removal in the section does not shift the rest.
+	// Only blocks which differ are stored.
+	void write_delta(
+	    buffer_sink& out, const unsigned char* base, size_t base_length, const unsigned char* data,
+	    size_t length
+	)
+	{
+		if (length == base_length) {
+			// both alignments are the same, so the patches are found in one pass without a split
+			write_size(out, length);
+			write_size(out, 0);
+			size_t count_offset = out.length();
+			size_t patches      = 0;
+			write_size(out, patches);
+			size_t offset = skip_equal(data, base, 0, length);
+			while (offset < length) {
+				size_t end = offset;
+				do {
+					end += block_size(end, length);
+				} while (end < length && memcmp(data + end, base + end, block_size(end, length)) != 0);
+				write_patch(out, offset, data + offset, end - offset);
+				offset = skip_equal(data, base, end, length);
+				++patches;
+			}
+			out.patch(count_offset, reinterpret_cast<const unsigned char*>(&patches), sizeof(patches));
+			return;
+		}
+		size_t                        blocks = (length + DELTA_BLOCK - 1) / DELTA_BLOCK;
+		managed_array<bool, true, 64> front;
+		managed_array<bool, true, 64> back;
+		front.resize(blocks);
+		back.resize(blocks);
+		compare_blocks(front.data(), data, length, base, base_length, false);
+		compare_blocks(back.data(), data, length, base, base_length, true);
+		size_t cost = 0;
+		for (size_t i = 0; i < blocks; ++i) {
+			cost += ! back[i];
+		}
+		// choose the split with the fewest changed blocks
+		size_t split    = 0;
+		size_t min_cost = cost;
+		for (size_t i = 0; i < blocks; ++i) {
+			cost = cost + ! front[i] - ! back[i];
+			if (cost < min_cost) {
+				min_cost = cost;
+				split    = i + 1;
+			}
+		}
+
+		size_t split_offset = split * DELTA_BLOCK < length ? split * DELTA_BLOCK : length;
+		size_t patches      = 0;
+		for (size_t i = 0; i < blocks; ++i) {
+			bool same = i < split ? front[i] : back[i];
+			patches += ! same && (i == 0 || (i - 1 < split ? front[i - 1] : back[i - 1]));
+		}
+		write_size(out, length);
+		write_size(out, split_offset);
+		write_size(out, patches);
+		for (size_t i = 0; i < blocks;) {
+			if (i < split ? front[i] : back[i]) {
+				++i;
+				continue;
+			}
+			size_t end = i + 1;
+			while (end < blocks && ! (end < split ? front[end] : back[end])) {
+				++end;
+			}
+			size_t offset = i * DELTA_BLOCK;
+			size_t size   = (end * DELTA_BLOCK < length ? end * DELTA_BLOCK : length) - offset;
+			write_patch(out, offset, data + offset, size);
+			i = end;
+		}
+	}
+
+	// A part is stored as its number of sections, each with the length of its counterpart in the
+	// base followed by the difference to it. Most parts are a single section.
+	void write_section(
+	    buffer_sink& out, const unsigned char* base, size_t base_length, const unsigned char* data,
+	    size_t length
+	)
+	{
+		write_size(out, base_length);
+		write_delta(out, base, base_length, data, length);
+	}
+
+	// a section which is the same as its counterpart in the base
+	void write_unchanged(buffer_sink& out, size_t length)
+	{
+		write_size(out, length);
+		write_size(out, length);
+		write_size(out, 0);
+		write_size(out, 0);
+	}
+
+	// reconstructs a section written by write_delta
+	const unsigned char* read_delta(
+	    buffer_sink& out, const unsigned char* base, size_t base_length, const unsigned char* ptr,
+	    const unsigned char* end
+	)
+	{
+		size_t length, split, patches;
+		inkAssert(
+		    static_cast<size_t>(end - ptr) >= 3 * sizeof(size_t), "Corrupted delta snapshot"
+		);
+		ptr                 = snapshot_interface::snap_read(ptr, length);
+		ptr                 = snapshot_interface::snap_read(ptr, split);
+		ptr                 = snapshot_interface::snap_read(ptr, patches);
+		inkAssert(
+		    length <= base_length + static_cast<size_t>(end - ptr), "Corrupted delta snapshot"
+		);
+		unsigned char* data = out.append(length);
+		// bytes without counterpart in the base are always patched
+		inkZeroMemory(data, length);
+		memcpy(data, base, split < base_length ? split : base_length);
+		size_t shifted = length > base_length ? length - base_length : 0;
+		size_t begin   = split > shifted ? split : shifted;
+		if (begin < length) {
+			memcpy(data + begin, base + begin + base_length - length, length - begin);
+		}
+		for (size_t i = 0; i < patches; ++i) {
+			size_t offset, size;
+			inkAssert(
+			    static_cast<size_t>(end - ptr) >= 2 * sizeof(size_t), "Corrupted delta snapshot"
+			);
+			ptr = snapshot_interface::snap_read(ptr, offset);
+			ptr = snapshot_interface::snap_read(ptr, size);
+			inkAssert(
+			    offset <= length && size <= length - offset
+			        && size <= static_cast<size_t>(end - ptr),
+			    "Corrupted delta snapshot"
+			);
+			ptr = snapshot_interface::snap_read(ptr, data + offset, size);
+		}
+		return ptr;
+	}
+
+	// LZ77 compression in the style of LZ4. A sequence is a token with the number of literals in
+	// the high and the match length in the low nibble, the literals, the 2 byte offset of the match
+	// and the remaining match length. The last sequence only contains literals.
+	constexpr size_t LZ_MIN_MATCH = 4;
+	constexpr size_t LZ_HASH_BITS = 12;
+
+	// lengths which do not fit into a nibble are continued in bytes, 255 means another byte follows
+	void lz_write_length(buffer_sink& out, size_t length)
+	{
+		for (; length >= 255; length -= 255) {
+			*out.append(1) = 255;
+		}
+		*out.append(1) = static_cast<unsigned char>(length);
+	}
+
+	void lz_write_sequence(
+	    buffer_sink& out, const unsigned char* literals, size_t count, size_t offset, size_t match
+	)
+	{
+		size_t match_code = match ? match - LZ_MIN_MATCH : 0;
+		*out.append(1)    = static_cast<unsigned char>(
+        (count < 15 ? count : 15) << 4 | (match_code < 15 ? match_code : 15)
+    );
+		if (count >= 15) {
+			lz_write_length(out, count - 15);
+		}
+		out.write(literals, count);
+		if (match) {
+			unsigned char* ptr = out.append(2);
+			ptr[0]             = static_cast<unsigned char>(offset & 0xFF);
+			ptr[1]             = static_cast<unsigned char>(offset >> 8);
+			if (match_code >= 15) {
+				lz_write_length(out, match_code - 15);
+			}
+		}
+	}
+
+	void lz_compress(buffer_sink& out, const unsigned char* data, size_t length)
+	{
+		// last position + 1 of each hashed 4 byte sequence
+		managed_array<uint32_t, true, 1> table;
+		table.resize(1 << LZ_HASH_BITS);
+		inkZeroMemory(table.data(), table.size() * sizeof(uint32_t));
+		size_t anchor = 0;
+		size_t pos    = 0;
+		while (pos + LZ_MIN_MATCH <= length) {
+			uint32_t word;
+			memcpy(&word, data + pos, sizeof(word));
+			size_t slot      = (word * 2654435761u) >> (32 - LZ_HASH_BITS);
+			size_t candidate = table[slot];
+			table[slot]      = static_cast<uint32_t>(pos + 1);
+			if (candidate == 0 || pos + 1 - candidate > 0xFFFF
+			    || memcmp(data + candidate - 1, data + pos, LZ_MIN_MATCH) != 0) {
+				++pos;
+				continue;
+			}
+			size_t from  = candidate - 1;
+			size_t match = LZ_MIN_MATCH;
+			while (pos + match < length && data[from + match] == data[pos + match]) {
+				++match;
+			}
+			lz_write_sequence(out, data + anchor, pos - anchor, pos - from, match);
+			pos += match;
+			anchor = pos;
+		}
+		lz_write_sequence(out, data + anchor, length - anchor, 0, 0);
+	}
+
+	const unsigned char* lz_read_length(size_t& length, const unsigned char* ptr, const unsigned char* end)
+	{
+		if (length == 15) {
+			unsigned char byte;
+			do {
+				inkAssert(ptr < end, "Corrupted compressed snapshot");
+				byte = *ptr++;
+				length += byte;
+			} while (byte == 255);
+		}
+		return ptr;
+	}
+
+	void lz_decompress(
+	    unsigned char* out, size_t length, const unsigned char* ptr, const unsigned char* end
+	)
+	{
+		size_t pos = 0;
+		while (true) {
+			inkAssert(ptr < end, "Corrupted compressed snapshot");
+			unsigned char token    = *ptr++;
+			size_t        literals = token >> 4;
+			ptr                    = lz_read_length(literals, ptr, end);
+			inkAssert(
+			    literals <= static_cast<size_t>(end - ptr) && literals <= length - pos,
+			    "Corrupted compressed snapshot"
+			);
+			memcpy(out + pos, ptr, literals);
+			pos += literals;
+			ptr += literals;
+			if (ptr == end) {
+				break;
+			}
+			inkAssert(end - ptr >= 2, "Corrupted compressed snapshot");
+			size_t offset = ptr[0] | ptr[1] << 8;
+			size_t match  = token & 0x0F;
+			ptr           = lz_read_length(match, ptr + 2, end);
+			match += LZ_MIN_MATCH;
+			inkAssert(
+			    offset > 0 && offset <= pos && match <= length - pos, "Corrupted compressed snapshot"
+			);
+			// the match may overlap with the bytes it produces
+			for (size_t i = 0; i < match; ++i, ++pos) {
+				out[pos] = out[pos - offset];
+			}
+		}
+		inkAssert(pos == length, "Corrupted compressed snapshot");
+	}
+} // namespace
+
 size_t snapshot_impl::file_size(size_t serialization_length, size_t runner_cnt)
 {
 	return serialization_length + sizeof(header) + (runner_cnt + 1) * sizeof(size_t);
@@ -98,16 +597,339 @@ snapshot_impl::snapshot_impl(const globals_impl& globals)
 	for (auto node = globals._runners_start; node; node = node->next) {
 		ptr += node->object->snap(ptr, snapper);
 	}
+	_data        = _file;
+	_data_length = _length;
+
+	static_assert(sizeof(_origin.sections) == sizeof(globals._snap_sections));
+	_origin.globals = globals._id;
+	_origin.serial  = globals._snapshot_serial++;
+	_origin.strings = globals.strings().changes();
+	memcpy(_origin.sections, globals._snap_sections, sizeof(_origin.sections));
 }
 
-snapshot_impl::snapshot_impl(const unsigned char* data, size_t length, bool managed)
+void snapshot_impl::write(const globals_impl& globals, snapshot_sink& sink, bool compact)
+{
+	snapshot_interface::snapper snapper{
+	    globals.strings(), globals._owner->string(0), nullptr, compact
+	};
+	header                      head{0, 0};
+	for (auto node = globals._runners_start; node; node = node->next) {
+		++head.num_runners;
+	}
+	managed_array<size_t, true, 8>          offsets;
+	managed_array<unsigned char, true, 512> buffer;
+	offsets.resize(head.num_runners + 1);
+
+	// header and offset table are back-patched once the size of each part is known
+	size_t table_length = file_size(0, head.num_runners);
+	buffer.resize(table_length);
+	inkZeroMemory(buffer.data(), table_length);
+	sink.write(buffer.data(), table_length);
+	head.length = table_length;
+
+	// a part is measured and serialized into the buffer, which is reused for the next part
+	size_t idx   = 0;
+	auto   write = [&](const auto& part) {
+		offsets[idx++] = head.length;
+		buffer.resize(part.snap(nullptr, snapper));
+		part.snap(buffer.data(), snapper);
+		sink.write(buffer.data(), buffer.size());
+		head.length += buffer.size();
+	};
+	write(globals);
+	for (auto node = globals._runners_start; node; node = node->next) {
+		write(*node->object);
+	}
+
+	buffer.resize(table_length);
+	memcpy(buffer.data(), &head, sizeof(head));
+	memcpy(buffer.data() + sizeof(head), offsets.data(), offsets.size() * sizeof(size_t));
+	sink.patch(0, buffer.data(), table_length);
+}
+
+snapshot_impl* snapshot_impl::create_compact(const globals_impl& globals, bool compress)
+{
+	buffer_sink data;
+	write(globals, data, true);
+
+	buffer_sink    out;
+	compact_header head{COMPACT_MARKER, 0, data.length(), compress ? COMPRESSED : 0};
+	out.reserve(sizeof(head) + data.length());
+	out.write(reinterpret_cast<const unsigned char*>(&head), sizeof(head));
+	if (compress) {
+		lz_compress(out, data.data(), data.length());
+	} else {
+		out.write(data.data(), data.length());
+	}
+	head.length = out.length();
+	out.patch(0, reinterpret_cast<const unsigned char*>(&head), sizeof(head));
+	size_t length = out.length();
+	return new snapshot_impl(out.release(), length, true);
+}
+
+snapshot_impl* snapshot_impl::create_delta(const globals_impl& globals, const snapshot_impl& base)
+{
+	inkAssert(! base._delta, "The base of a delta snapshot must be a full snapshot.");
+	inkAssert(! base._compact, "The base of a delta snapshot must be in the standard format.");
+	buffer_sink  out;
+	delta_header head{DELTA_MARKER, 0, 0, base._length, base.checksum()};
+	out.write(reinterpret_cast<const unsigned char*>(&head), sizeof(head));
+	if (base._origin.globals != globals._id) {
+		// the state is usually about as large as the base
+		buffer_sink current;
+		current.reserve(base._length);
+		write(globals, current);
+		snapshot_impl full(current.data(), current.length(), false);
+		head.num_runners = full.num_runners();
+		for (size_t i = 0; i < full.num_parts(); ++i) {
+			const unsigned char* part        = full._file + full.part_begin(i);
+			size_t               part_length = full.part_begin(i + 1) - full.part_begin(i);
+			write_size(out, 1);
+			if (i < base.num_parts()) {
+				size_t begin = base.part_begin(i);
+				write_section(out, base._file + begin, base.part_begin(i + 1) - begin, part, part_length);
+			} else {
+				write_section(out, nullptr, 0, part, part_length);
+			}
+		}
+	} else {
+		// the base was taken from this store, so only sections written since then are compared
+		const origin&               since = base._origin;
+		snapshot_interface::snapper snapper{globals.strings(), globals._owner->string(0)};
+		const unsigned char*        old = base._file + base.part_begin(1);
+		inkAssert(
+		    since.sections[0] + since.sections[1] + since.sections[2]
+		        == base.part_begin(2) - base.part_begin(1),
+		    "Snapshot does not match its origin."
+		);
+
+		// the strings come first, because the variables and runners refer to their ids
+		buffer_sink current;
+		size_t      shared = globals.snap_section(1, nullptr, snapper);
+		globals.snap_section(1, current.append(shared), snapper);
+		bool   variables_written = globals._variables_serial > since.serial
+		                        || globals.strings().changes() != since.strings;
+		size_t variables         = since.sections[2];
+		if (variables_written) {
+			variables = globals.snap_section(2, nullptr, snapper);
+			globals.snap_section(2, current.append(variables), snapper);
+		}
+
+		// header and offset table of the current state
+		for (auto node = globals._runners_start; node; node = node->next) {
+			++head.num_runners;
+		}
+		header                         table{head.num_runners, 0};
+		managed_array<size_t, true, 8> offsets;
+		offsets.resize(head.num_runners + 1);
+		size_t offset = file_size(0, head.num_runners);
+		offsets[0]    = offset;
+		offset += since.sections[0] + shared + variables;
+		size_t runner = 1;
+		for (auto node = globals._runners_start; node; node = node->next) {
+			size_t length = node->object->snap(nullptr, snapper);
+			node->object->snap(current.append(length), snapper);
+			offsets[runner++] = offset;
+			offset += length;
+		}
+		table.length = offset;
+		buffer_sink table_part;
+		table_part.write(reinterpret_cast<const unsigned char*>(&table), sizeof(table));
+		table_part.write(
+		    reinterpret_cast<const unsigned char*>(offsets.data()), offsets.size() * sizeof(size_t)
+		);
+		write_size(out, 1);
+		write_section(out, base._file, base.part_begin(1), table_part.data(), table_part.length());
+
+		// the globals part: visit counts, strings and lists, variables
+		write_size(out, 3);
+		write_size(out, since.sections[0]);
+		write_size(out, since.sections[0]);
+		write_size(out, 0);
+		size_t patches      = 0;
+		size_t count_offset = out.length();
+		write_size(out, patches);
+		if (memcmp(old, &globals._turn_cnt, sizeof(globals._turn_cnt)) != 0) {
+			write_patch(
+			    out, 0, reinterpret_cast<const unsigned char*>(&globals._turn_cnt),
+			    sizeof(globals._turn_cnt)
+			);
+			++patches;
+		}
+		// both arrays are stored as their size followed by the counts, only chunks with a write since
+		// the base can differ
+		using visit_count           = globals_impl::visit_count;
+		const visit_count* arrays[] = {
+		    globals._visit_counts.data(), globals._visit_counts_backup.data()
+		};
+		size_t at = sizeof(globals._turn_cnt);
+		for (const visit_count* counts : arrays) {
+			at += sizeof(size_t);
+			for (size_t chunk = 0; chunk < globals._visit_serials.size(); ++chunk) {
+				if (globals._visit_serials[chunk] <= since.serial) {
+					continue;
+				}
+				size_t first = chunk * globals_impl::VISIT_CHUNK;
+				size_t count = globals._num_containers - first < globals_impl::VISIT_CHUNK
+				                 ? globals._num_containers - first
+				                 : globals_impl::VISIT_CHUNK;
+				auto*  data  = reinterpret_cast<const unsigned char*>(counts + first);
+				size_t begin = at + first * sizeof(visit_count);
+				if (memcmp(old + begin, data, count * sizeof(visit_count)) != 0) {
+					write_patch(out, begin, data, count * sizeof(visit_count));
+					++patches;
+				}
+			}
+			at += globals._num_containers * sizeof(visit_count);
+		}
+		inkAssert(at == since.sections[0], "Snapshot does not match its origin.");
+		out.patch(count_offset, reinterpret_cast<const unsigned char*>(&patches), sizeof(patches));
+		write_section(out, old + since.sections[0], since.sections[1], current.data(), shared);
+		if (variables_written) {
+			write_section(
+			    out, old + since.sections[0] + since.sections[1], since.sections[2],
+			    current.data() + shared, variables
+			);
+		} else {
+			write_unchanged(out, variables);
+		}
+
+		// runners are compared as a whole
+		const unsigned char* part = current.data() + shared + (variables_written ? variables : 0);
+		for (size_t i = 0; i < head.num_runners; ++i) {
+			size_t length = (i + 1 < head.num_runners ? offsets[i + 2] : table.length) - offsets[i + 1];
+			write_size(out, 1);
+			if (i + 2 < base.num_parts()) {
+				size_t begin = base.part_begin(i + 2);
+				write_section(out, base._file + begin, base.part_begin(i + 3) - begin, part, length);
+			} else {
+				write_section(out, nullptr, 0, part, length);
+			}
+			part += length;
+		}
+	}
+	head.length = out.length();
+	out.patch(0, reinterpret_cast<const unsigned char*>(&head), sizeof(head));
+	size_t length = out.length();
+	return new snapshot_impl(out.release(), length, true);
+}
+
+snapshot_impl* snapshot_impl::apply_delta(const snapshot_impl& base, const snapshot_impl& delta)
+{
+	inkAssert(! base._delta, "The base of a delta snapshot must be a full snapshot.");
+	inkAssert(! base._compact, "The base of a delta snapshot must be in the standard format.");
+	inkAssert(delta._delta, "Only delta snapshots can be applied.");
+	delta_header head;
+	memcpy(&head, delta._file, sizeof(head));
+	inkAssert(
+	    head.base_length == base._length && head.base_checksum == base.checksum(),
+	    "Delta snapshot was created against a different base."
+	);
+	buffer_sink          out;
+	const unsigned char* ptr = delta._file + sizeof(head);
+	const unsigned char* end = delta._file + delta._length;
+	for (size_t i = 0; i < head.num_runners + 2; ++i) {
+		size_t begin = i < base.num_parts() ? base.part_begin(i) : 0;
+		size_t left  = i < base.num_parts() ? base.part_begin(i + 1) - begin : 0;
+		size_t sections;
+		inkAssert(static_cast<size_t>(end - ptr) >= sizeof(size_t), "Corrupted delta snapshot");
+		ptr = snapshot_interface::snap_read(ptr, sections);
+		for (size_t j = 0; j < sections; ++j) {
+			size_t base_length;
+			inkAssert(static_cast<size_t>(end - ptr) >= sizeof(size_t), "Corrupted delta snapshot");
+			ptr = snapshot_interface::snap_read(ptr, base_length);
+			inkAssert(base_length <= left, "Corrupted delta snapshot");
+			ptr = read_delta(out, base._file + begin, base_length, ptr, end);
+			begin += base_length;
+			left -= base_length;
+		}
+		inkAssert(left == 0, "Corrupted delta snapshot");
+	}
+	inkAssert(ptr == end, "Corrupted delta snapshot");
+	size_t length = out.length();
+	return new snapshot_impl(out.release(), length, true);
+}
+
+uint64_t snapshot_impl::checksum() const
+{
+	if (! _has_checksum) {
+		_checksum     = internal::checksum(_file, _length);
+		_has_checksum = true;
+	}
+	return _checksum;
+}
+
+snapshot_impl::snapshot_impl(
+    const unsigned char* data, size_t length, bool managed, bool mapped
+)
     : _file{data}
     , _length{length}
     , _managed{managed}
+    , _mapped{mapped}
 {
-	const unsigned char* ptr = data;
-	memcpy(&_header, ptr, sizeof(_header));
+	// the data may come from a file, so every offset is checked before it is used
+	_data        = data;
+	_data_length = length;
+	inkAssert(_length >= sizeof(_header), "Snapshot is too small");
+	memcpy(&_header, data, sizeof(_header));
 	inkAssert(_header.length == _length, "Corrupted file length");
+	if (_header.num_runners == COMPACT_MARKER) {
+		compact_header head;
+		inkAssert(_length >= sizeof(head), "Snapshot is too small");
+		memcpy(&head, data, sizeof(head));
+		inkAssert((head.flags & ~COMPRESSED) == 0, "Unknown snapshot format");
+		_compact = true;
+		if (head.flags & COMPRESSED) {
+			// an LZ sequence produces at most 255 bytes per byte of input
+			inkAssert(head.data_length / 256 <= _length, "Corrupted compressed snapshot");
+			_decoded.resize(head.data_length);
+			lz_decompress(_decoded.data(), head.data_length, data + sizeof(head), data + _length);
+			_data = _decoded.data();
+		} else {
+			inkAssert(head.data_length == _length - sizeof(head), "Corrupted file length");
+			_data = data + sizeof(head);
+		}
+		_data_length = head.data_length;
+		inkAssert(_data_length >= sizeof(_header), "Snapshot is too small");
+		memcpy(&_header, _data, sizeof(_header));
+		inkAssert(
+		    _header.length == _data_length && _header.num_runners != DELTA_MARKER,
+		    "Corrupted file length"
+		);
+	} else if (_header.num_runners == DELTA_MARKER) {
+		delta_header head;
+		inkAssert(_length >= sizeof(head), "Snapshot is too small");
+		memcpy(&head, data, sizeof(head));
+		_delta              = true;
+		_header.num_runners = head.num_runners;
+		inkAssert(_header.num_runners < _length, "Corrupted snapshot header");
+		return;
+	}
+	inkAssert(
+	    _header.num_runners < _data_length / sizeof(size_t)
+	        && file_size(0, _header.num_runners) <= _data_length,
+	    "Corrupted snapshot offset table"
+	);
+	// parts are stored in order, the globals start right after the offset table
+	size_t last = file_size(0, _header.num_runners);
+	for (size_t i = 0; i <= _header.num_runners; ++i) {
+		size_t offset = get_offset(i);
+		inkAssert(offset >= last && offset <= _data_length, "Corrupted snapshot offset table");
+		last = offset;
+	}
+}
+
+snapshot_impl::~snapshot_impl()
+{
+#ifdef INK_ENABLE_STL
+	if (_mapped) {
+		unmap_file_from_memory(const_cast<unsigned char*>(_file), _length);
+		return;
+	}
+#endif
+	if (_managed) {
+		delete[] _file;
+	}
 }
 
 size_t snap_choice::snap(unsigned char* data, const snapper& snapper) const
@@ -70,12 +70,7 @@ static_assert(sizeof(snap_tag) == sizeof(const char*));
 class snapshot_impl : public snapshot
 {
 public:
-	~snapshot_impl() override
-	{
-		if (_managed) {
-			delete[] _file;
-		}
-	};
+	~snapshot_impl() override;
 
 	managed_array<const char*, true, 5>& strings() const { return string_table; }
 
@@ -83,18 +78,36 @@ public:
 	size_t               get_data_len() const override;
 
 	snapshot_impl(const globals_impl&);
+	// serialize globals and runners part by part into the sink
+	static void write(const globals_impl&, snapshot_sink&, bool compact = false);
+	// snapshot in the compact format, optionally compressed
+	static snapshot_impl* create_compact(const globals_impl&, bool compress);
+	// difference of the current state to base
+	static snapshot_impl* create_delta(const globals_impl&, const snapshot_impl& base);
+	// reconstruct the full snapshot from which delta was created
+	static snapshot_impl* apply_delta(const snapshot_impl& base, const snapshot_impl& delta);
 	// write down all allocated strings
 	// replace pointer with idx
 	// reconsrtuct static strings index
 	// list_table _data & _entry_state
-	snapshot_impl(const unsigned char* data, size_t length, bool managed);
+	// if mapped is true, data is a file mapping which is released on destruction
+	snapshot_impl(const unsigned char* data, size_t length, bool managed, bool mapped = false);
+
+	const unsigned char* get_globals_snap() const { return _data + get_offset(0); }
+
+	const unsigned char* get_globals_end() const { return _data + part_begin(2); }
+
+	const unsigned char* get_runner_snap(size_t idx) const { return _data + get_offset(idx + 1); }
 
-	const unsigned char* get_globals_snap() const { return _file + get_offset(0); }
+	const unsigned char* get_runner_end(size_t idx) const { return _data + part_begin(idx + 3); }
 
-	const unsigned char* get_runner_snap(size_t idx) const { return _file + get_offset(idx + 1); }
+	// the parts were written with snapper::compact
+	bool is_compact() const { return _compact; }
 
 	size_t num_runners() const override { return _header.num_runners; }
 
+	bool is_delta() const override { return _delta; }
+
 private:
 	// file information
 	// only populated when loading snapshots
@@ -102,6 +115,14 @@ private:
 	const unsigned char*                        _file;
 	size_t                                      _length;
 	bool                                        _managed;
+	bool                                        _mapped  = false;
+	bool                                        _delta   = false;
+	bool                                        _compact = false;
+	// header, offset table and parts, behind the compact_header in compact snapshots
+	const unsigned char*                        _data        = nullptr;
+	size_t                                      _data_length = 0;
+	// decompressed data of compressed snapshots
+	managed_array<unsigned char, true, 1>       _decoded;
 	static size_t                               file_size(size_t, size_t);
 
 	struct header {
@@ -110,10 +131,59 @@ private:
 
 	} _header;
 
+	// a delta snapshot starts with DELTA_MARKER where the header contains the number of runners
+	// followed by one entry per part, see create_delta()
+	static constexpr size_t DELTA_MARKER = ~static_cast<size_t>(0);
+
+	struct delta_header {
+		size_t   marker;
+		size_t   length;
+		size_t   num_runners;
+		size_t   base_length;
+		uint64_t base_checksum;
+	};
+
+	// a compact snapshot starts with COMPACT_MARKER where the header contains the number of runners
+	// followed by a standard snapshot, which parts were written with snapper::compact
+	static constexpr size_t COMPACT_MARKER = ~static_cast<size_t>(1);
+	// flag of compact snapshots which standard snapshot is compressed with lz_compress()
+	static constexpr size_t COMPRESSED     = 1;
+
+	struct compact_header {
+		size_t marker;
+		size_t length;
+		size_t data_length;
+		size_t flags;
+	};
+
+	// the store a standard snapshot was taken from, so a delta against it only compares the
+	// sections of the globals which were written since, see create_delta()
+	struct origin {
+		uint64_t globals = 0; // id of the store, 0 if the snapshot was loaded
+		uint64_t serial  = 0; // writes with a greater serial happened after the snapshot
+		size_t   strings = 0; // string_table::changes() of the store at the time
+		// lengths of the sections of the globals part
+		size_t   sections[3] = {};
+	} _origin;
+
+	// checksum of the data, computed once when a delta is created against or applied to it
+	uint64_t         checksum() const;
+	mutable uint64_t _checksum     = 0;
+	mutable bool     _has_checksum = false;
+
 	size_t get_offset(size_t idx) const
 	{
+		inkAssert(! _delta, "Delta snapshots must be applied to their base with from_deltas().");
 		inkAssert(idx <= _header.num_runners, "Out of Bound access for runner in snapshot.");
-		return reinterpret_cast<const size_t*>(_file + sizeof(header))[idx];
+		return reinterpret_cast<const size_t*>(_data + sizeof(header))[idx];
+	}
+
+	// parts are the header with offset table, the globals and each runner
+	size_t num_parts() const { return _header.num_runners + 2; }
+
+	size_t part_begin(size_t idx) const
+	{
+		return idx == 0 ? 0 : idx == num_parts() ? _data_length : get_offset(idx - 1);
 	}
 };
 } // namespace ink::runtime::internal
@@ -53,14 +53,72 @@ public:
 		const string_table& strings;
 		const char*         story_string_table;
 		const snap_tag*     runner_tags = nullptr;
+		// write the compact encoding, see snapshot_format::compact
+		bool                compact     = false;
 	};
 
 	struct loader {
 		managed_array<const char*, true, 5>& string_table; /// FIXME: make configurable
 		const char*                          story_string_table;
 		const snap_tag*                      runner_tags = nullptr;
+		// end of the part which is loaded, nullptr if unknown
+		const unsigned char*                 end         = nullptr;
+		// the part was written with snapper::compact
+		bool                                 compact     = false;
+
+		// size of story_string_table, offsets into it are checked against it
+		size_t story_string_table_size = ~static_cast<size_t>(0);
+
+		// number of bytes left to read
+		size_t remaining(const unsigned char* ptr) const
+		{
+			return end == nullptr ? ~static_cast<size_t>(0) : static_cast<size_t>(end - ptr);
+		}
 	};
 
+	// unsigned integer in 7 bit groups, the highest bit marks that another group follows
+	static unsigned char* snap_write_varint(unsigned char* ptr, uint64_t value, bool write)
+	{
+		do {
+			unsigned char byte = value & 0x7F;
+			value >>= 7;
+			if (write) {
+				*ptr = byte | (value ? 0x80 : 0);
+			}
+			++ptr;
+		} while (value);
+		return ptr;
+	}
+
+	static const unsigned char*
+	    snap_read_varint(const unsigned char* ptr, uint64_t& value, const loader& loader)
+	{
+		value = 0;
+		for (unsigned shift = 0;; shift += 7) {
+			inkAssert(shift < 64 && loader.remaining(ptr) > 0, "Corrupted snapshot");
+			value |= static_cast<uint64_t>(*ptr & 0x7F) << shift;
+			if (! (*ptr++ & 0x80)) {
+				return ptr;
+			}
+		}
+	}
+
+	// signed integers are interleaved with positive ones, so small negative numbers stay short
+	static unsigned char* snap_write_varint(unsigned char* ptr, int64_t value, bool write)
+	{
+		uint64_t bits = static_cast<uint64_t>(value);
+		return snap_write_varint(ptr, value < 0 ? ~(bits << 1) : bits << 1, write);
+	}
+
+	static const unsigned char*
+	    snap_read_varint(const unsigned char* ptr, int64_t& value, const loader& loader)
+	{
+		uint64_t bits;
+		ptr   = snap_read_varint(ptr, bits, loader);
+		value = (bits & 1) ? static_cast<int64_t>(~(bits >> 1)) : static_cast<int64_t>(bits >> 1);
+		return ptr;
+	}
+
 	size_t snap(unsigned char* data, snapper&) const
 	{
 		inkFail("Snap function not implemented");
@@ -387,6 +387,40 @@ namespace ink::runtime::internal
 		});
 	}
 
+	void basic_stack::hash(state_hasher& hasher, const list_table& lists) const
+	{
+		base::for_each(
+		    [&hasher, &lists](const entry& elem) {
+			    hasher.add(static_cast<uint64_t>(elem.name));
+			    elem.data.hash(hasher, lists);
+		    },
+		    [](const entry& elem) { return elem.name == NulledHashId; }
+		);
+	}
+
+	uint64_t basic_stack::hash_entries(const list_table& lists) const
+	{
+		uint64_t result = 0;
+		// entries written while the stack was saved shadow older entries of the same name
+		base::for_each(
+		    [this, &result, &lists](const entry& elem) {
+			    if (get(elem.name) == &elem.data) {
+				    result ^= hash_entry(elem.name, elem.data, lists);
+			    }
+		    },
+		    [](const entry& elem) { return elem.name == NulledHashId; }
+		);
+		return result;
+	}
+
+	uint64_t basic_stack::hash_entry(hash_t name, const value& val, const list_table& lists)
+	{
+		state_hasher hasher;
+		hasher.add(static_cast<uint64_t>(name));
+		val.hash(hasher, lists);
+		return hash_mix(hasher.get());
+	}
+
 	thread_t basic_stack::fork_thread()
 	{
 		// TODO create unique thread ID
@@ -499,6 +533,13 @@ namespace ink::runtime::internal
 		base::forget([](entry& elem) { elem.name = ~0; });
 	}
 
+	void basic_stack::copy_from(const basic_stack& other, const string_table::mapping& strings)
+	{
+		base::copy_from(other, [&strings](entry& elem) { strings(elem.data); });
+		_next_thread = other._next_thread;
+		_backup_next_thread = other._backup_next_thread;
+	}
+
 	entry& basic_stack::add(hash_t name, const value& val)
 	{
 		return base::push({ name, val });
@@ -555,6 +596,14 @@ namespace ink::runtime::internal
 			});
 	}
 
+	void basic_eval_stack::hash(state_hasher& hasher, const list_table& lists) const
+	{
+		base::for_each(
+		    [&hasher, &lists](const value& elem) { elem.hash(hasher, lists); },
+		    [](const value& elem) { return elem.type() == value_type::none; }
+		);
+	}
+
 	void basic_eval_stack::save()
 	{
 		base::save();
@@ -573,6 +622,13 @@ namespace ink::runtime::internal
 		base::forget([&none](value& elem) { elem = none; });
 	}
 
+	void basic_eval_stack::copy_from(
+	    const basic_eval_stack& other, const string_table::mapping& strings
+	)
+	{
+		base::copy_from(other, [&strings](value& elem) { strings(elem); });
+	}
+
 	void basic_stack::fetch_values(basic_stack& stack) {
 		auto itr  = base::begin();
 		auto predicat = [](entry& e)
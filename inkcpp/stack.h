@@ -9,7 +9,9 @@
 #include "value.h"
 #include "collections/restorable.h"
 #include "array.h"
+#include "string_table.h"
 #include "snapshot_impl.h"
+#include "state_hash.h"
 
 namespace ink
 {
@@ -17,8 +19,6 @@ namespace runtime
 {
 	namespace internal
 	{
-		class string_table;
-
 		struct entry {
 			hash_t name = 0;
 			value  data;
@@ -66,6 +66,15 @@ namespace runtime
 			// Garbage collection
 			void mark_used(string_table&, list_table&) const;
 
+			// Adds names and values of all live entries to the hash
+			void hash(state_hasher&, const list_table&) const;
+
+			// Order independent hash of the visible entries, the xor of their hash_entry()
+			uint64_t hash_entries(const list_table&) const;
+
+			// Hash of a single entry
+			static uint64_t hash_entry(hash_t name, const value& val, const list_table&);
+
 			// == Threading ==
 
 			// Forks a new thread from the current callstack and returns that thread's unique id
@@ -83,6 +92,9 @@ namespace runtime
 			void restore();
 			void forget();
 
+			// Copies all entries of other, strings are replaced with their duplicates
+			void copy_from(const basic_stack& other, const string_table::mapping& strings);
+
 			// replace all pointer in current frame with values from _stack
 			void fetch_values(basic_stack& _stack);
 			// push all values to other _stack
@@ -188,11 +200,17 @@ namespace runtime
 			/** Mark used strings and lists for garbage collection */
 			void mark_used(string_table&, list_table&) const;
 
+			// Adds all live values to the hash
+			void hash(state_hasher&, const list_table&) const;
+
 			// == Save/Restore ==
 			void save();
 			void restore();
 			void forget();
 
+			// Copies all values of other, strings are replaced with their duplicates
+			void copy_from(const basic_eval_stack& other, const string_table::mapping& strings);
+
 			// snapshot interface
 			size_t snap(unsigned char* data, const snapper& snapper) const
 			{
@@ -0,0 +1,52 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#pragma once
+
+#include "system.h"
+
+namespace ink::runtime::internal
+{
+/**
+ * 64bit FNV-1a hash over the logical state of runners and globals.
+ * Only values are hashed, never addresses, so equal states of different runners (e.g. forks)
+ * result in the same hash.
+ */
+class state_hasher
+{
+public:
+	void add(const void* data, size_t length)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < length; ++i) {
+			_hash = (_hash ^ bytes[i]) * 1099511628211ull;
+		}
+	}
+
+	// adds the content of a zero terminated string
+	void add(const char* string)
+	{
+		do {
+			_hash = (_hash ^ static_cast<unsigned char>(*string)) * 1099511628211ull;
+		} while (*string++ != 0);
+	}
+
+	void add(uint64_t number) { add(&number, sizeof(number)); }
+
+	uint64_t get() const { return _hash; }
+
+private:
+	uint64_t _hash = 14695981039346656037ull;
+};
+
+// finalizer of splitmix64, spreads the bits of hash so that hashes can be combined with xor
+constexpr uint64_t hash_mix(uint64_t hash)
+{
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+	return hash ^ (hash >> 31);
+}
+} // namespace ink::runtime::internal
@@ -13,16 +13,44 @@
 #include "snapshot_interface.h"
 #include "version.h"
 
+#ifdef INK_ENABLE_STL
+#	if defined(_WIN32) || defined(_WIN64)
+#		ifndef WIN32_LEAN_AND_MEAN
+#			define WIN32_LEAN_AND_MEAN
+#		endif
+#		ifndef NOMINMAX
+#			define NOMINMAX
+#		endif
+#		include <windows.h>
+#	else
+#		include <fcntl.h>
+#		include <sys/mman.h>
+#		include <sys/stat.h>
+#		include <unistd.h>
+#	endif
+#endif
+
 namespace ink::runtime
 {
 #ifdef INK_ENABLE_STL
 story* story::from_file(const char* filename) { return new internal::story_impl(filename); }
+
+story* story::from_mapped_file(const char* filename)
+{
+	return new internal::story_impl(filename, true);
+}
 #endif
 
 story* story::from_binary(unsigned char* data, size_t length, bool freeOnDestroy)
 {
 	return new internal::story_impl(data, length, freeOnDestroy);
 }
+
+story* story::from_static(const unsigned char* data, size_t length)
+{
+	// story data is only read, never written
+	return new internal::story_impl(const_cast<unsigned char*>(data), length, false);
+}
 } // namespace ink::runtime
 
 namespace ink::runtime::internal
@@ -50,15 +78,76 @@ unsigned char* read_file_into_memory(const char* filename, size_t* read)
 	return data;
 }
 
-story_impl::story_impl(const char* filename)
+unsigned char* map_file_into_memory(const char* filename, size_t* read)
+{
+	unsigned char* data = nullptr;
+#	if defined(_WIN32) || defined(_WIN64)
+	HANDLE file = CreateFileA(
+	    filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+	);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw ink_exception("Failed to open file: " + std::string(filename));
+	}
+	LARGE_INTEGER size;
+	HANDLE        mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	if (mapping != nullptr) {
+		data = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		// the view keeps the mapping alive
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+	if (data == nullptr) {
+		throw ink_exception("Failed to map file: " + std::string(filename));
+	}
+	*read = static_cast<size_t>(size.QuadPart);
+#	else
+	int file = open(filename, O_RDONLY);
+	if (file < 0) {
+		throw ink_exception("Failed to open file: " + std::string(filename));
+	}
+	struct stat info;
+	void*       mapping = MAP_FAILED;
+	if (fstat(file, &info) == 0 && info.st_size > 0) {
+		mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+	}
+	// the mapping stays valid after closing the file
+	close(file);
+	if (mapping == MAP_FAILED) {
+		throw ink_exception("Failed to map file: " + std::string(filename));
+	}
+	data  = static_cast<unsigned char*>(mapping);
+	*read = static_cast<size_t>(info.st_size);
+#	endif
+	return data;
+}
+
+void unmap_file_from_memory(unsigned char* data, size_t length)
+{
+#	if defined(_WIN32) || defined(_WIN64)
+	UnmapViewOfFile(data);
+#	else
+	munmap(data, length);
+#	endif
+}
+
+story_impl::story_impl(const char* filename, bool mapped)
     : _file(nullptr)
     , _length(0)
     , _string_table(nullptr)
+    , _string_table_size(0)
     , _instruction_data(nullptr)
     , _managed(true)
+    , _mapped(mapped)
 {
-	// Load file into memory
-	_file = read_file_into_memory(filename, &_length);
+	// Load or map file into memory
+	if (_mapped) {
+		_file = map_file_into_memory(filename, &_length);
+	} else {
+		_file = read_file_into_memory(filename, &_length);
+	}
 
 	// Find all the right data sections
 	setup_pointers();
@@ -84,14 +173,26 @@ story_impl::story_impl(unsigned char* binary, size_t len, bool manage /*= true*/
 
 story_impl::~story_impl()
 {
+	// cached globals may reference story data
+	delete _globals_image.exchange(nullptr);
+
+#ifdef INK_ENABLE_STL
+	// release file mapping
+	if (_file != nullptr && _mapped) {
+		unmap_file_from_memory(_file, _length);
+		_file = nullptr;
+	}
+#endif
+
 	// delete file memory if we're responsible for it
 	if (_file != nullptr && _managed)
 		delete[] _file;
 
 	// clear pointers
-	_file             = nullptr;
-	_instruction_data = nullptr;
-	_string_table     = nullptr;
+	_file              = nullptr;
+	_instruction_data  = nullptr;
+	_string_table      = nullptr;
+	_string_table_size = 0;
 
 	// clear out our reference block
 	_block->valid = false;
@@ -179,6 +280,13 @@ CommandFlag story_impl::container_flag(container_t id) const
 }
 
 hash_t story_impl::container_hash(container_t id) const
+{
+	hash_t hash = find_container_hash(id);
+	inkAssert(hash != InvalidHash, "Did not find hash entry for container!");
+	return hash;
+}
+
+hash_t story_impl::find_container_hash(container_t id) const
 {
 	const uint32_t* iter = nullptr;
 	ip_t            offset;
@@ -192,14 +300,14 @@ hash_t story_impl::container_hash(container_t id) const
 	}
 	inkAssert(hit, "Unable to find container for id!");
 	hash_t* h_iter = _container_hash_start;
-	while (iter != _container_hash_end) {
+	while (h_iter != _container_hash_end) {
 		if (instructions() + *( offset_t* ) (h_iter + 1) == offset) {
 			return *h_iter;
 		}
 		h_iter += 2;
 	}
-	inkAssert(false, "Did not find hash entry for container!");
-	return 0;
+	// container without name
+	return InvalidHash;
 }
 
 ip_t story_impl::find_offset_for(hash_t path) const
@@ -219,23 +327,45 @@ ip_t story_impl::find_offset_for(hash_t path) const
 
 globals story_impl::new_globals()
 {
-	// create the new globals store
-	return globals(new globals_impl(this), _block);
+	// initialize the image once, the runner executes "global decl" on construction
+	globals_impl* image = _globals_image.load(std::memory_order_acquire);
+	if (image == nullptr) {
+		globals initialized(new globals_impl(this), _block);
+		{
+			runner_impl init(this, initialized);
+		}
+		string_table::mapping strings;
+		globals_impl*         created = new globals_impl(*initialized.cast<globals_impl>(), strings);
+		// threads may race to create the image, only the first one is kept
+		if (_globals_image.compare_exchange_strong(image, created, std::memory_order_acq_rel)) {
+			image = created;
+		} else {
+			delete created;
+		}
+	}
+
+	// create the new globals store as copy of the initialized image
+	string_table::mapping strings;
+	return globals(new globals_impl(*image, strings), _block);
 }
 
 globals story_impl::new_globals_from_snapshot(const snapshot& data)
 {
 	const snapshot_impl& snapshot = reinterpret_cast<const snapshot_impl&>(data);
 	auto*                globs    = new globals_impl(this);
-	auto                 end      = globs->snap_load(
-      snapshot.get_globals_snap(),
-      snapshot_interface::loader{
-          snapshot.strings(),
-          _string_table,
-      }
-  );
-	inkAssert(end == snapshot.get_runner_snap(0), "not all data were used for global reconstruction");
-	return globals(globs, _block);
+	// owned before loading, so the globals are freed if the snapshot turns out to be corrupted
+	globals result(globs, _block);
+	auto    loader = snapshot_interface::loader{
+      snapshot.strings(),
+      _string_table,
+      nullptr,
+      snapshot.get_globals_end(),
+      snapshot.is_compact(),
+      _string_table_size,
+  };
+	auto end = globs->snap_load(snapshot.get_globals_snap(), loader);
+	inkAssert(end == snapshot.get_globals_end(), "not all data were used for global reconstruction");
+	return result;
 }
 
 runner story_impl::new_runner(globals store)
@@ -248,29 +378,82 @@ runner story_impl::new_runner(globals store)
 runner story_impl::new_runner_from_snapshot(const snapshot& data, globals store, unsigned idx)
 {
 	const snapshot_impl& snapshot = reinterpret_cast<const snapshot_impl&>(data);
+	inkAssert(idx < data.num_runners(), "Out of Bound access for runner in snapshot.");
 	if (store == nullptr)
 		store = new_globals_from_snapshot(snapshot);
-	auto* run    = new runner_impl(this, store);
-	auto  loader = snapshot_interface::loader{
+	auto*  run = new runner_impl(this, store);
+	runner result(run, _block);
+	// snapshot id is inverso of creation time, but creation time is the more intouitve numbering to
+	// use
+	idx         = (data.num_runners() - idx - 1);
+	auto loader = snapshot_interface::loader{
       snapshot.strings(),
       _string_table,
+      nullptr,
+      snapshot.get_runner_end(idx),
+      snapshot.is_compact(),
+      _string_table_size,
   };
-	// snapshot id is inverso of creation time, but creation time is the more intouitve numbering to
-	// use
-	idx      = (data.num_runners() - idx - 1);
 	auto end = run->snap_load(snapshot.get_runner_snap(idx), loader);
-	inkAssert(
-	    (idx + 1 < snapshot.num_runners() && end == snapshot.get_runner_snap(idx + 1))
-	        || end == snapshot.get_data() + snapshot.get_data_len(),
-	    "not all data were used for runner reconstruction"
-	);
-	return runner(run, _block);
+	inkAssert(end == snapshot.get_runner_end(idx), "not all data were used for runner reconstruction");
+	return result;
 }
 
 void story_impl::setup_pointers()
 {
 	using header = ink::internal::header;
 	_header      = header::parse_header(reinterpret_cast<char*>(_file));
+	inkAssert(
+	    _header.ink_bin_version_number >= ink::InkBinVersionMin
+	        && _header.ink_bin_version_number <= ink::InkBinVersion,
+	    "invalid InkBinVerison! currently: %i you used %i", ink::InkBinVersion,
+	    _header.ink_bin_version_number
+	);
+	inkAssert(
+	    _header.endien == header::endian_types::same, "different endien support not yet implemented"
+	);
+
+	if (_header.has_directory()) {
+		setup_pointers_from_directory();
+	} else {
+		setup_pointers_legacy();
+	}
+}
+
+void story_impl::setup_pointers_from_directory()
+{
+	using header  = ink::internal::header;
+	using section = header::section;
+	inkAssert(
+	    _header.get(section::instructions).offset + _header.get(section::instructions).size
+	        <= _length,
+	    "story file is truncated, sections exceed file size"
+	);
+
+	_string_table      = reinterpret_cast<const char*>(_file + _header.get(section::strings).offset);
+	_string_table_size = _header.get(section::strings).size;
+
+	if (_header.get(section::list_meta).size > 0) {
+		_list_meta = reinterpret_cast<const char*>(_file + _header.get(section::list_meta).offset);
+		_lists     = reinterpret_cast<const list_flag*>(_file + _header.get(section::lists).offset);
+	} else {
+		_list_meta = nullptr;
+		_lists     = nullptr;
+	}
+
+	_num_containers = _header.num_containers;
+	_container_list
+	    = reinterpret_cast<uint32_t*>(_file + _header.get(section::container_map).offset);
+	_container_list_size = _header.container_map_size;
+	_container_hash_start
+	    = reinterpret_cast<hash_t*>(_file + _header.get(section::container_hash).offset);
+	_container_hash_end = _container_hash_start + _header.container_hash_size * 2;
+	_instruction_data   = _file + _header.get(section::instructions).offset;
+}
+
+void story_impl::setup_pointers_legacy()
+{
+	using header = ink::internal::header;
 
 	// String table is after the header
 	_string_table = ( char* ) _file + header::Size;
@@ -295,6 +478,7 @@ void story_impl::setup_pointers()
 				break;
 			}
 		}
+	_string_table_size = ptr - _string_table;
 
 	// check if lists are defined
 	_list_meta = ptr;
@@ -329,15 +513,6 @@ void story_impl::setup_pointers()
 		_list_meta = nullptr;
 		_lists     = nullptr;
 	}
-	inkAssert(
-	    _header.ink_bin_version_number == ink::InkBinVersion,
-	    "invalid InkBinVerison! currently: %i you used %i", ink::InkBinVersion,
-	    _header.ink_bin_version_number
-	);
-	inkAssert(
-	    _header.endien == header::endian_types::same, "different endien support not yet implemented"
-	);
-
 
 	_num_containers = *( uint32_t* ) (ptr);
 	ptr += sizeof(uint32_t);
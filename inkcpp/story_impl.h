@@ -14,14 +14,29 @@
 #include "header.h"
 #include "list_table.h"
 
+#include <atomic>
+
 namespace ink::runtime::internal
 {
-// Ink story. Constant once constructed. Can be shared safely between multiple runner instances
+class globals_impl;
+
+#ifdef INK_ENABLE_STL
+// reads a whole file into a new[] buffer
+unsigned char* read_file_into_memory(const char* filename, size_t* read);
+// maps a file read-only into memory, release it with unmap_file_from_memory
+unsigned char* map_file_into_memory(const char* filename, size_t* read);
+void           unmap_file_from_memory(unsigned char* data, size_t length);
+#endif
+
+// Ink story. Constant once constructed. Can be shared safely between multiple runner instances,
+//  also on different threads
 class story_impl : public story
 {
 public:
 #ifdef INK_ENABLE_STL
-	story_impl(const char* filename);
+	// Load story from file. If mapped is true, the file is memory mapped read-only instead of
+	//  copied, the mapping lives until the story is destroyed
+	story_impl(const char* filename, bool mapped = false);
 #endif
 	// Create story from allocated binary data in memory. If manage is true, this class will delete
 	//  the pointers on destruction
@@ -47,7 +62,10 @@ public:
 	/// Get container flag from container offset (either start or end)
 	CommandFlag container_flag(ip_t offset) const;
 	CommandFlag container_flag(container_t id) const;
+	/// hash of the containers path, the container must be named
 	hash_t      container_hash(container_t id) const;
+	/// hash of the containers path, InvalidHash if the container is not named
+	hash_t      find_container_hash(container_t id) const;
 
 	ip_t find_offset_for(hash_t path) const;
 
@@ -60,8 +78,15 @@ public:
 
 	const ink::internal::header& get_header() const { return _header; }
 
+	// lifetime block of this story, used to create pointers to runners and globals
+	ref_block* block() const { return _block; }
+
 private:
 	void setup_pointers();
+	// O(1) setup for files with a section directory
+	void setup_pointers_from_directory();
+	// scans files written before the section directory was introduced
+	void setup_pointers_legacy();
 
 private:
 	// file information
@@ -72,6 +97,7 @@ private:
 
 	// string table
 	const char* _string_table;
+	size_t      _string_table_size;
 
 	const char*      _list_meta;
 	const list_flag* _lists;
@@ -93,5 +119,12 @@ private:
 
 	// whether we need to delete our binary data after we destruct
 	bool _managed;
+
+	// whether our binary data is a file mapping instead of an allocation
+	bool _mapped = false;
+
+	// globals after running "global decl", created on first new_globals and copied by all later
+	//  calls
+	std::atomic<globals_impl*> _globals_image = nullptr;
 };
 } // namespace ink::runtime::internal
@@ -13,16 +13,11 @@ void ref_block::remove_reference(ref_block*& block)
 	if (block == nullptr)
 		return;
 
-	// If we only have one references left
-	if (block->references <= 1) {
-		// delete the block
+	// Decrement references, the thread releasing the last one deletes the block
+	if (block->references.fetch_sub(1, std::memory_order_acq_rel) <= 1) {
 		delete block;
 		block = nullptr;
-		return;
 	}
-
-	// Otherwise, decrement references
-	block->references--;
 }
 
 story_ptr_base::story_ptr_base(internal::ref_block* story)
@@ -5,6 +5,7 @@
  * https://github.com/JBenda/inkcpp for full license details.
  */
 #include "string_table.h"
+#include "value.h"
 
 namespace ink::runtime::internal
 {
@@ -12,10 +13,25 @@ string_table::~string_table()
 {
 	// Delete all allocated strings
 	for (auto iter = _table.begin(); iter != _table.end(); ++iter)
-		delete[] iter.key();
+		release(iter.key());
 	_table.clear();
 }
 
+void string_table::release(const char* string)
+{
+	for (size_t i = 0; i < _arenas.size(); ++i) {
+		arena& block = _arenas[i];
+		if (string >= block.begin && string < block.end) {
+			if (--block.live == 0) {
+				delete[] block.begin;
+				_arenas.remove(i, i + 1);
+			}
+			return;
+		}
+	}
+	delete[] string;
+}
+
 char* string_table::duplicate(const char* str)
 {
 	int len = 0;
@@ -46,6 +62,7 @@ char* string_table::create(size_t length)
 		delete[] data;
 		return nullptr;
 	}
+	++_changes;
 
 	// Return allocated string
 	return data;
@@ -78,8 +95,9 @@ void string_table::gc()
 		// If the string is not used
 		if (! *iter) {
 			// Delete it
-			delete[] iter.key();
+			release(iter.key());
 			_table.erase(iter);
+			++_changes;
 
 			// Re-establish iterator at last position
 			// TODO: BAD. We need inline delete that doesn't invalidate pointers
@@ -99,22 +117,44 @@ void string_table::gc()
 	}
 }
 
+namespace
+{
+	// slot of a string in a hash map with a power of two capacity
+	size_t hash_slot(const char* string, size_t mask)
+	{
+		uint64_t bits = reinterpret_cast<std::uintptr_t>(string);
+		bits ^= bits >> 4;
+		return static_cast<size_t>((bits * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+	}
+} // namespace
+
 size_t string_table::snap(unsigned char* data, const snapper&) const
 {
 	unsigned char* ptr          = data;
 	bool           should_write = data != nullptr;
-	for (size_t i = 0; i < _table.size(); ++i) {
-		for (auto itr = _table.begin(); itr != _table.end(); ++itr) {
-			if (itr.temp_identifier() == i) {
-				size_t length = strlen(itr.key()) + 1;
-				if (length == 1) {
-					ptr = snap_write(ptr, EMPTY_STRING, 2, should_write);
-				} else {
-					ptr = snap_write(ptr, itr.key(), length, should_write);
-				}
-				break;
-			}
+	// keep the map at most half full, so lookups stay short
+	size_t         capacity     = 8;
+	while (capacity < _table.size() * 2) {
+		capacity *= 2;
+	}
+	_snap_ids.resize(capacity);
+	for (snap_id& entry : _snap_ids) {
+		entry = {};
+	}
+	// strings are numbered in the order they are written, like the loader does
+	size_t id = 0;
+	for (auto itr = _table.begin(); itr != _table.end(); ++itr, ++id) {
+		size_t length = strlen(itr.key()) + 1;
+		if (length == 1) {
+			ptr = snap_write(ptr, EMPTY_STRING, 2, should_write);
+		} else {
+			ptr = snap_write(ptr, itr.key(), length, should_write);
 		}
+		size_t slot = hash_slot(itr.key(), capacity - 1);
+		while (_snap_ids[slot].string != nullptr) {
+			slot = (slot + 1) & (capacity - 1);
+		}
+		_snap_ids[slot] = {itr.key(), id};
 	}
 	ptr = snap_write(ptr, "\0", 1, should_write);
 	return ptr - data;
@@ -122,28 +162,93 @@ size_t string_table::snap(unsigned char* data, const snapper&) const
 
 const unsigned char* string_table::snap_load(const unsigned char* data, const loader& loader)
 {
-	auto* ptr = data;
-	int   i   = 0;
-	while (*ptr) {
-		size_t len = 0;
-		for (; ptr[len]; ++len)
-			;
-		++len;
-		auto str                   = create(len);
-		loader.string_table.push() = str;
-		ptr                        = snap_read(ptr, str, len);
+	// find the end of the strings first, so they can be imported with one allocation
+	const unsigned char* ptr       = data;
+	size_t               count     = 0;
+	size_t               remaining = loader.remaining(data);
+	while (true) {
+		inkAssert(remaining > 0, "Snapshot string table is not terminated");
+		if (*ptr == 0) {
+			break;
+		}
+		size_t len;
+		if (loader.end == nullptr) {
+			len = strlen(reinterpret_cast<const char*>(ptr)) + 1;
+		} else {
+			const void* end = memchr(ptr, 0, remaining);
+			inkAssert(end != nullptr, "Snapshot string table is not terminated");
+			len = static_cast<const unsigned char*>(end) - ptr + 1;
+		}
+		ptr += len;
+		remaining -= len;
+		++count;
+	}
+	loader.string_table.clear();
+	if (count == 0) {
+		return ptr + 1;
+	}
+
+	size_t size  = ptr - data;
+	char*  block = new char[size];
+	memcpy(block, data, size);
+	_arenas.push() = {block, block + size, count};
+	loader.string_table.resize(count);
+	char* str = block;
+	for (size_t i = 0; i < count; ++i) {
+		size_t len = strlen(str) + 1;
 		if (len == 2 && str[0] == EMPTY_STRING[0]) {
 			str[0] = 0;
 		}
-		mark_used(str);
+		bool success = _table.insert(str, true);
+		inkAssert(success, "String table is full, unable to add new data.");
+		++_changes;
+		loader.string_table[i] = str;
+		str += len;
 	}
 	return ptr + 1;
 }
 
+void string_table::copy_from(const string_table& other, mapping& strings)
+{
+	inkAssert(_table.empty(), "Can only copy strings into an empty string table.");
+	strings._source = &other;
+	strings._copies.resize(other._table.size());
+	for (auto iter = other._table.begin(); iter != other._table.end(); ++iter) {
+		strings._copies[iter.temp_identifier()] = duplicate(iter.key());
+	}
+}
+
+const char* string_table::mapping::operator()(const char* string) const
+{
+	if (_source == nullptr || string == nullptr) {
+		return string;
+	}
+	auto iter = _source->_table.find(string);
+	if (iter == _source->_table.end()) {
+		return string;
+	}
+	return _copies[iter.temp_identifier()];
+}
+
+void string_table::mapping::operator()(value& val) const
+{
+	if (val.type() == value_type::string) {
+		string_type str = val.get<value_type::string>();
+		val.set<value_type::string>(operator()(str.str), str.allocated);
+	}
+}
+
 size_t string_table::get_id(const char* string) const
 {
-	auto iter = _table.find(string);
-	inkAssert(iter != _table.end(), "Try to fetch not contained string!");
-	return iter.temp_identifier();
+	inkAssert(_snap_ids.size() > 0, "String ids are only available after snap()");
+	size_t mask = _snap_ids.size() - 1;
+	for (size_t slot = hash_slot(string, mask); _snap_ids[slot].string != nullptr;
+	     slot       = (slot + 1) & mask) {
+		if (_snap_ids[slot].string == string) {
+			return _snap_ids[slot].id;
+		}
+	}
+	inkFail("Try to fetch not contained string!");
+	return 0;
 }
 } // namespace ink::runtime::internal
@@ -12,10 +12,28 @@
 
 namespace ink::runtime::internal
 {
+class value;
+
 // hash tree sorted by string pointers
 class string_table final : public snapshot_interface
 {
 public:
+	// maps strings of a table to their duplicates in a copied table
+	class mapping
+	{
+	public:
+		// returns the duplicate of string, or string itself if it is not part of the source table
+		const char* operator()(const char* string) const;
+		// replaces string values with their duplicate
+		void        operator()(value& val) const;
+
+	private:
+		friend string_table;
+
+		const string_table*                 _source = nullptr;
+		managed_array<const char*, true, 5> _copies;
+	};
+
 	virtual ~string_table();
 
 	// Create a dynamic string of a particular length
@@ -35,13 +53,46 @@ public:
 
 	// get position of string when iterate through data
 	// used to enable storing a string table references
+	// only valid after snap() until the table changes
 	size_t get_id(const char* string) const;
 
 	// deletes all unused strings
 	void gc();
 
+	// duplicates all strings of other into this (empty) table
+	void copy_from(const string_table& other, mapping& strings);
+
+	// number of strings added or removed so far, the ids only change with it
+	size_t changes() const { return _changes; }
+
 private:
-	avl_array<const char*, bool, ink::size_t, 100> _table;
-	static constexpr const char*                   EMPTY_STRING = "\x03";
+	avl_array<
+	    const char*, bool, ink::size_t, abs(config::limitStringTable), true,
+	    (config::limitStringTable < 0)>
+	                             _table;
+	static constexpr const char* EMPTY_STRING = "\x03";
+
+	// position of a string in the last snapshot
+	struct snap_id {
+		const char* string = nullptr;
+		size_t      id     = 0;
+	};
+
+	// open addressing hash map from string to position, filled by snap()
+	mutable managed_array<snap_id, true, 1> _snap_ids;
+
+	// strings loaded from a snapshot share one allocation, which is deleted with its last string
+	struct arena {
+		char*  begin = nullptr;
+		char*  end   = nullptr;
+		size_t live  = 0;
+	};
+
+	managed_array<arena, true, 1> _arenas;
+
+	size_t _changes = 0;
+
+	// frees a string of the table, whether created alone or as part of an arena
+	void release(const char* string);
 };
 } // namespace ink::runtime::internal
@@ -11,6 +11,7 @@
 #include "list_table.h"
 #include "string_utils.h"
 #include "string_table.h"
+#include "state_hash.h"
 #include "system.h"
 
 namespace ink::runtime::internal
@@ -112,6 +113,43 @@ bool truthy_impl<value_type::divert>(const value& v, const list_table& lists)
 
 bool value::truthy(const list_table& lists) const { return truthy_impl(*this, lists); }
 
+void value::hash(state_hasher& hasher, const list_table& lists) const
+{
+	hasher.add(static_cast<uint64_t>(type()));
+	switch (type()) {
+		case value_type::divert:
+		case value_type::uint32:
+		case value_type::thread_end: hasher.add(static_cast<uint64_t>(uint32_value)); break;
+		case value_type::boolean: hasher.add(static_cast<uint64_t>(bool_value)); break;
+		case value_type::int32: hasher.add(static_cast<uint64_t>(int32_value)); break;
+		case value_type::float32: hasher.add(&float_value, sizeof(float_value)); break;
+		case value_type::list: lists.hash(hasher, list_value); break;
+		case value_type::list_flag:
+			hasher.add(
+			    static_cast<uint64_t>(static_cast<uint16_t>(list_flag_value.list_id)) << 16
+			    | static_cast<uint16_t>(list_flag_value.flag)
+			);
+			break;
+		case value_type::string: hasher.add(get_string().str); break;
+		case value_type::value_pointer: {
+			pointer_data ptr = get<value_type::value_pointer>();
+			hasher.add(static_cast<uint64_t>(ptr.name) << 32 | static_cast<uint32_t>(ptr.ci));
+		} break;
+		case value_type::jump_marker:
+		case value_type::thread_start: {
+			jump_data jump = get_jump();
+			hasher.add(static_cast<uint64_t>(jump.jump) << 32 | jump.thread_id);
+		} break;
+		case value_type::tunnel_frame:
+		case value_type::function_frame:
+		case value_type::thread_frame: {
+			frame_data frame = get_frame();
+			hasher.add(static_cast<uint64_t>(frame.addr) << 1 | frame.eval);
+		} break;
+		default: break;
+	}
+}
+
 
 #ifdef INK_ENABLE_STL
 template<value_type ty = value_type::PRINT_BEGIN>
@@ -240,9 +278,21 @@ size_t value::snap(unsigned char* data, const snapper& snapper) const
 {
 	unsigned char* ptr          = data;
 	bool           should_write = data != nullptr;
-	ptr                         = snap_write(ptr, _type, should_write);
+#ifdef INK_COMPACT_VALUE
+	// strings are stored as id in the string table or as offset in the story string table
+	value stored = *this;
+	if (type() == value_type::string) {
+		auto str            = get<value_type::string>();
+		stored.uint32_value = static_cast<uint32_t>(
+		    str.allocated ? snapper.strings.get_id(str.str) : str.str - snapper.story_string_table
+		);
+		stored._extra = 0;
+	}
+	ptr = snap_write(ptr, stored, should_write);
+#else
+	ptr = snap_write(ptr, _type, should_write);
 	if (_type == value_type::string) {
-		unsigned char buf[max_value_size];
+		unsigned char buf[max_value_size] = {};
 		string_type*  res = reinterpret_cast<string_type*>(buf);
 		auto          str = get<value_type::string>();
 		res->allocated    = str.allocated;
@@ -260,20 +310,44 @@ size_t value::snap(unsigned char* data, const snapper& snapper) const
 		// TODO more space efficent?
 		ptr = snap_write(ptr, &bool_value, max_value_size, should_write);
 	}
+#endif
 	return ptr - data;
 }
 
+namespace
+{
+	// string stored in a snapshot as id in its string table or as offset in the story string table
+	const char*
+	    load_string(const snapshot_interface::loader& loader, std::uintptr_t id, bool allocated)
+	{
+		if (allocated) {
+			inkAssert(id < loader.string_table.size(), "Corrupted snapshot, unknown string id");
+			return loader.string_table[id];
+		}
+		inkAssert(id < loader.story_string_table_size, "Corrupted snapshot, string outside of story");
+		return loader.story_string_table + id;
+	}
+} // namespace
+
 const unsigned char* value::snap_load(const unsigned char* ptr, const loader& loader)
 {
+#ifdef INK_COMPACT_VALUE
+	inkAssert(loader.remaining(ptr) >= sizeof(*this), "Corrupted snapshot");
+	ptr = snap_read(ptr, *this);
+	if (type() == value_type::string) {
+		const bool allocated = _flag != 0;
+		set_string({load_string(loader, uint32_value, allocated), allocated});
+	}
+#else
+	inkAssert(loader.remaining(ptr) >= sizeof(_type) + max_value_size, "Corrupted snapshot");
 	ptr = snap_read(ptr, _type);
 	ptr = snap_read(ptr, &bool_value, max_value_size);
 	if (_type == value_type::string) {
-		if (string_value.allocated) {
-			string_value.str = loader.string_table[(std::uintptr_t)(string_value.str)];
-		} else {
-			string_value.str = loader.story_string_table + (std::uintptr_t)(string_value.str);
-		}
+		string_value.str = load_string(
+		    loader, reinterpret_cast<std::uintptr_t>(string_value.str), string_value.allocated
+		);
 	}
+#endif
 	return ptr;
 }
 } // namespace ink::runtime::internal
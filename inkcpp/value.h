@@ -26,6 +26,7 @@
 namespace ink::runtime::internal
 {
 class basic_stream;
+class state_hasher;
 
 /// different existing value_types
 enum class value_type {
@@ -92,6 +93,24 @@ struct string_type {
 
 class value;
 
+/// target of a jump marker or thread start and the number of stack entries to skip
+struct jump_data {
+	uint32_t jump;
+	uint32_t thread_id;
+};
+
+/// return address of a tunnel, function or thread frame
+struct frame_data {
+	uint32_t addr;
+	bool     eval; // was eval mode active in frame above
+};
+
+/// reference to a variable, ci is the call index of its frame
+struct pointer_data {
+	hash_t name;
+	int    ci;
+};
+
 template<value_type ty, typename T, typename ENV>
 class redefine
 {
@@ -117,6 +136,24 @@ public:
 		using type = void;
 	};
 
+#ifdef INK_COMPACT_VALUE
+	constexpr value()
+	    : snapshot_interface()
+	    , uint32_value{0}
+	    , _extra{0}
+	    , _flag{0}
+	    , _type{static_cast<uint32_t>(value_type::none)}
+	{
+	}
+
+	constexpr explicit value(value_type type)
+	    : uint32_value{0}
+	    , _extra{0}
+	    , _flag{0}
+	    , _type{static_cast<uint32_t>(type)}
+	{
+	}
+#else
 	constexpr value()
 	    : snapshot_interface()
 	    , bool_value{0}
@@ -129,6 +166,7 @@ public:
 	    , _type{type}
 	{
 	}
+#endif
 
 	explicit value(const ink::runtime::value& val);
 	bool                set(const ink::runtime::value& val);
@@ -153,12 +191,19 @@ public:
 	}
 
 	/// get type of value
-	constexpr value_type type() const { return _type; }
+	constexpr value_type type() const
+	{
+#ifdef INK_COMPACT_VALUE
+		return static_cast<value_type>(_type);
+#else
+		return _type;
+#endif
+	}
 
 	/// returns if type is printable (see value_type)
 	constexpr bool printable() const
 	{
-		return _type >= value_type::PRINT_BEGIN && _type < value_type::PRINT_END;
+		return type() >= value_type::PRINT_BEGIN && type() < value_type::PRINT_END;
 	}
 
 	friend basic_stream& operator<<(basic_stream& os, const value&);
@@ -170,6 +215,9 @@ public:
 	std::ostream& write(std::ostream&, const list_table* lists = nullptr) const;
 #endif
 
+	/// adds type and content to the hash, strings and lists are hashed by content
+	void hash(state_hasher&, const list_table& lists) const;
+
 	/// execute the type exclusive overwrite function and return a new value with
 	/// this new type
 	template<typename... T>
@@ -190,6 +238,92 @@ private:
 		}
 	}
 
+	constexpr void set_type(value_type type)
+	{
+#ifdef INK_COMPACT_VALUE
+		_type = static_cast<uint32_t>(type);
+#else
+		_type = type;
+#endif
+	}
+
+	// access to the members which are stored differently in the compact layout
+	inline void            set_string(string_type str);
+	inline string_type     get_string() const;
+	inline void            set_jump(jump_data jump);
+	constexpr jump_data    get_jump() const;
+	constexpr void         set_frame(frame_data frame);
+	constexpr frame_data   get_frame() const;
+	inline void            set_pointer(pointer_data pointer);
+	constexpr pointer_data get_pointer() const;
+
+#ifdef INK_COMPACT_VALUE
+	/// actual storage, 8 bytes: a 32bit payload, 24bit extra payload, a flag and the type.
+	/// Strings keep the lower 32bits of their address in the payload and the upper bits in
+	/// extra, therefore string addresses must fit into 56bits.
+	union {
+		bool             bool_value;
+		int32_t          int32_value;
+		uint32_t         uint32_value;
+		float            float_value;
+		list_table::list list_value;
+		list_flag        list_flag_value;
+	};
+
+	uint32_t _extra : 24; // upper address bits, call index or number of entries to skip
+	uint32_t _flag : 1;   // string is allocated, eval mode was active in frame
+	uint32_t _type : 7;   // value_type
+};
+
+static_assert(sizeof(value) == 8, "compact values must fit into 8 bytes");
+
+inline void value::set_string(string_type str)
+{
+	const uint64_t address = reinterpret_cast<std::uintptr_t>(str.str);
+	inkAssert(address >> 56 == 0, "String address does not fit into a compact value!");
+	uint32_value = static_cast<uint32_t>(address);
+	_extra       = static_cast<uint32_t>(address >> 32);
+	_flag        = str.allocated;
+}
+
+inline string_type value::get_string() const
+{
+	const uint64_t address = static_cast<uint64_t>(_extra) << 32 | uint32_value;
+	return {reinterpret_cast<const char*>(static_cast<std::uintptr_t>(address)), _flag != 0};
+}
+
+inline void value::set_jump(jump_data jump)
+{
+	inkAssert(jump.thread_id < 1u << 24, "Too many stack entries to skip for a compact value!");
+	uint32_value = jump.jump;
+	_extra       = jump.thread_id;
+}
+
+constexpr jump_data value::get_jump() const { return {uint32_value, _extra}; }
+
+constexpr void value::set_frame(frame_data frame)
+{
+	uint32_value = frame.addr;
+	_flag        = frame.eval;
+}
+
+constexpr frame_data value::get_frame() const { return {uint32_value, _flag != 0}; }
+
+inline void value::set_pointer(pointer_data pointer)
+{
+	inkAssert(
+	    pointer.ci >= -(1 << 23) && pointer.ci < 1 << 23, "Call index does not fit into a compact value!"
+	);
+	uint32_value = pointer.name;
+	_extra       = static_cast<uint32_t>(pointer.ci) & 0xFFFFFF;
+}
+
+constexpr pointer_data value::get_pointer() const
+{
+	// sign extend the 24bit call index
+	return {uint32_value, static_cast<int>(_extra ^ 0x800000) - 0x800000};
+}
+#else
 	/// actual storage
 	union {
 		bool        bool_value;
@@ -198,23 +332,14 @@ private:
 		uint32_t    uint32_value;
 		float       float_value;
 
-		struct {
-			uint32_t jump;
-			uint32_t thread_id;
-		} jump;
+		jump_data jump;
 
 		list_table::list list_value;
 		list_flag        list_flag_value;
 
-		struct {
-			uint32_t addr;
-			bool     eval; // was eval mode active in frame above
-		} frame_value;
+		frame_data frame_value;
 
-		struct {
-			hash_t name;
-			int    ci;
-		} pointer;
+		pointer_data pointer;
 	};
 
 	static constexpr size_t max_value_size = sizeof_largest_type<
@@ -224,6 +349,23 @@ private:
 	value_type _type;
 };
 
+inline void value::set_string(string_type str) { string_value = str; }
+
+inline string_type value::get_string() const { return string_value; }
+
+inline void value::set_jump(jump_data v) { jump = v; }
+
+constexpr jump_data value::get_jump() const { return jump; }
+
+constexpr void value::set_frame(frame_data frame) { frame_value = frame; }
+
+constexpr frame_data value::get_frame() const { return frame_value; }
+
+inline void value::set_pointer(pointer_data v) { pointer = v; }
+
+constexpr pointer_data value::get_pointer() const { return pointer; }
+#endif
+
 template<value_type ty, typename T, typename ENV>
 value redefine<ty, T, ENV>::operator()(const T& lh, const T& rh)
 {
@@ -246,7 +388,7 @@ template<>
 inline constexpr value& value::set<value_type::int32, int32_t>(int32_t v)
 {
 	int32_value = v;
-	_type       = value_type::int32;
+	set_type(value_type::int32);
 	return *this;
 }
 
@@ -266,7 +408,7 @@ template<>
 inline constexpr value& value::set<value_type::uint32, uint32_t>(uint32_t v)
 {
 	uint32_value = v;
-	_type        = value_type::uint32;
+	set_type(value_type::uint32);
 	return *this;
 }
 
@@ -286,7 +428,7 @@ template<>
 inline constexpr value& value::set<value_type::divert, uint32_t>(uint32_t v)
 {
 	uint32_value = v;
-	_type        = value_type::divert;
+	set_type(value_type::divert);
 	return *this;
 }
 
@@ -306,7 +448,7 @@ template<>
 inline constexpr value& value::set<value_type::float32, float>(float v)
 {
 	float_value = v;
-	_type       = value_type::float32;
+	set_type(value_type::float32);
 	return *this;
 }
 
@@ -326,7 +468,7 @@ template<>
 inline constexpr value& value::set<value_type::boolean, bool>(bool v)
 {
 	bool_value = v;
-	_type      = value_type::boolean;
+	set_type(value_type::boolean);
 	return *this;
 }
 
@@ -334,7 +476,7 @@ template<>
 inline constexpr value& value::set<value_type::boolean, int>(int v)
 {
 	bool_value = static_cast<bool>(v);
-	_type      = value_type::boolean;
+	set_type(value_type::boolean);
 	return *this;
 }
 
@@ -354,7 +496,7 @@ template<>
 inline constexpr value& value::set<value_type::list, list_table::list>(list_table::list list)
 {
 	list_value = list;
-	_type      = value_type::list;
+	set_type(value_type::list);
 	return *this;
 }
 
@@ -374,7 +516,7 @@ template<>
 inline constexpr value& value::set<value_type::list_flag, list_flag>(list_flag flag)
 {
 	list_flag_value = flag;
-	_type           = value_type::list_flag;
+	set_type(value_type::list_flag);
 	return *this;
 }
 
@@ -387,130 +529,122 @@ struct value::ret<value_type::string> {
 template<>
 inline string_type value::get<value_type::string>() const
 {
-	return string_value;
+	return get_string();
 }
 
 template<>
-inline constexpr value& value::set<value_type::string, const char*>(const char* v)
+inline value& value::set<value_type::string, const char*>(const char* v)
 {
-	string_value = {v};
-	_type        = value_type::string;
+	set_string({v});
+	set_type(value_type::string);
 	return *this;
 }
 
 template<>
-inline constexpr value& value::set<value_type::string, char*>(char* v)
+inline value& value::set<value_type::string, char*>(char* v)
 {
-	string_value = {v};
-	_type        = value_type::string;
+	set_string({v});
+	set_type(value_type::string);
 	return *this;
 }
 
 template<>
-inline constexpr value&
-    value::set<value_type::string, const char*, bool>(const char* v, bool allocated)
+inline value& value::set<value_type::string, const char*, bool>(const char* v, bool allocated)
 {
-	string_value = {v, allocated};
-	_type        = value_type::string;
+	set_string({v, allocated});
+	set_type(value_type::string);
 	return *this;
 }
 
 template<>
-inline constexpr value& value::set<value_type::string, char*, bool>(char* v, bool allocated)
+inline value& value::set<value_type::string, char*, bool>(char* v, bool allocated)
 {
-	string_value = {v, allocated};
-	_type        = value_type::string;
+	set_string({v, allocated});
+	set_type(value_type::string);
 	return *this;
 }
 
 template<>
-inline constexpr value& value::set<value_type::string, string_type>(string_type str)
+inline value& value::set<value_type::string, string_type>(string_type str)
 {
-	string_value = str;
-	_type        = value_type::string;
+	set_string(str);
+	set_type(value_type::string);
 	return *this;
 }
 
 // define get and set for pointer
 template<>
 struct value::ret<value_type::value_pointer> {
-	using type = decltype(value::pointer);
+	using type = pointer_data;
 };
 
 template<>
 inline value::ret<value_type::value_pointer>::type value::get<value_type::value_pointer>() const
 {
-	return pointer;
+	return get_pointer();
 }
 
 template<>
-inline constexpr value& value::set<value_type::value_pointer, hash_t, int>(hash_t name, int ci)
+inline value& value::set<value_type::value_pointer, hash_t, int>(hash_t name, int ci)
 {
-	_type        = value_type::value_pointer;
-	pointer.name = name;
-	pointer.ci   = ci;
+	set_pointer({name, ci});
+	set_type(value_type::value_pointer);
 	return *this;
 }
 
 // define getter and setter for jump_marker
 template<>
 struct value::ret<value_type::jump_marker> {
-	using type = decltype(value::jump);
+	using type = jump_data;
 };
 
 template<>
 inline value::ret<value_type::jump_marker>::type value::get<value_type::jump_marker>() const
 {
-	return jump;
+	return get_jump();
 }
 
 template<>
-inline constexpr value&
-    value::set<value_type::jump_marker, decltype(value::jump)>(decltype(value::jump) v)
+inline value& value::set<value_type::jump_marker, jump_data>(jump_data v)
 {
-	jump  = v;
-	_type = value_type::jump_marker;
+	set_jump(v);
+	set_type(value_type::jump_marker);
 	return *this;
 }
 
 template<>
-inline constexpr value&
-    value::set<value_type::jump_marker, uint32_t, uint32_t>(uint32_t v, uint32_t j)
+inline value& value::set<value_type::jump_marker, uint32_t, uint32_t>(uint32_t v, uint32_t j)
 {
-	jump.jump      = v;
-	jump.thread_id = j;
-	_type          = value_type::jump_marker;
+	set_jump({v, j});
+	set_type(value_type::jump_marker);
 	return *this;
 }
 
 // define getter and setter for thread_start
 template<>
 struct value::ret<value_type::thread_start> {
-	using type = decltype(value::jump);
+	using type = jump_data;
 };
 
 template<>
 inline value::ret<value_type::thread_start>::type value::get<value_type::thread_start>() const
 {
-	return jump;
+	return get_jump();
 }
 
 template<>
-inline constexpr value&
-    value::set<value_type::thread_start, decltype(value::jump)>(decltype(value::jump) v)
+inline value& value::set<value_type::thread_start, jump_data>(jump_data v)
 {
-	jump  = v;
-	_type = value_type::thread_start;
+	set_jump(v);
+	set_type(value_type::thread_start);
 	return *this;
 }
 
 template<>
-inline constexpr value&
-    value::set<value_type::thread_start, uint32_t, uint32_t>(uint32_t v, uint32_t j)
+inline value& value::set<value_type::thread_start, uint32_t, uint32_t>(uint32_t v, uint32_t j)
 {
-	jump.jump      = v;
-	jump.thread_id = j;
-	_type          = value_type::thread_start;
+	set_jump({v, j});
+	set_type(value_type::thread_start);
 	return *this;
 }
 
@@ -530,7 +664,7 @@ template<>
 inline constexpr value& value::set<value_type::thread_end, uint32_t>(uint32_t v)
 {
 	uint32_value = v;
-	_type        = value_type::thread_end;
+	set_type(value_type::thread_end);
 	return *this;
 }
 
@@ -538,28 +672,28 @@ inline constexpr value& value::set<value_type::thread_end, uint32_t>(uint32_t v)
 template<>
 inline constexpr value& value::set<value_type::marker>()
 {
-	_type = value_type::marker;
+	set_type(value_type::marker);
 	return *this;
 }
 
 template<>
 inline constexpr value& value::set<value_type::glue>()
 {
-	_type = value_type::glue;
+	set_type(value_type::glue);
 	return *this;
 }
 
 template<>
 inline constexpr value& value::set<value_type::ex_fn_not_found>()
 {
-	_type = value_type::ex_fn_not_found;
+	set_type(value_type::ex_fn_not_found);
 	return *this;
 }
 
 template<>
 inline constexpr value& value::set<value_type::newline>()
 {
-	_type = value_type::newline;
+	set_type(value_type::newline);
 	return *this;
 }
 
@@ -578,28 +712,28 @@ inline const char* value::get<value_type::newline>() const
 template<>
 inline constexpr value& value::set<value_type::func_start>()
 {
-	_type = value_type::func_start;
+	set_type(value_type::func_start);
 	return *this;
 }
 
 template<>
 inline constexpr value& value::set<value_type::func_end>()
 {
-	_type = value_type::func_end;
+	set_type(value_type::func_end);
 	return *this;
 }
 
 template<>
 inline constexpr value& value::set<value_type::null>()
 {
-	_type = value_type::null;
+	set_type(value_type::null);
 	return *this;
 }
 
 template<>
 inline constexpr value& value::set<value_type::none>()
 {
-	_type = value_type::none;
+	set_type(value_type::none);
 	return *this;
 }
 
@@ -607,22 +741,21 @@ inline constexpr value& value::set<value_type::none>()
 // FIXME: the getter are not used?
 template<>
 struct value::ret<value_type::function_frame> {
-	using type = decltype(frame_value);
+	using type = frame_data;
 };
 
 template<>
 inline typename value::ret<value_type::function_frame>::type
     value::get<value_type::function_frame>() const
 {
-	return frame_value;
+	return get_frame();
 }
 
 template<>
 inline constexpr value& value::set<value_type::function_frame, uint32_t>(uint32_t v, bool evalOn)
 {
-	frame_value.addr = v;
-	frame_value.eval = evalOn;
-	_type            = value_type::function_frame;
+	set_frame({v, evalOn});
+	set_type(value_type::function_frame);
 	return *this;
 }
 
@@ -633,9 +766,8 @@ inline constexpr value& value::set<value_type::function_frame, uint32_t>(uint32_
 template<>
 inline constexpr value& value::set<value_type::tunnel_frame, uint32_t>(uint32_t v, bool evalOn)
 {
-	frame_value.addr = v;
-	frame_value.eval = evalOn;
-	_type            = value_type::tunnel_frame;
+	set_frame({v, evalOn});
+	set_type(value_type::tunnel_frame);
 	return *this;
 }
 
@@ -646,9 +778,8 @@ inline constexpr value& value::set<value_type::tunnel_frame, uint32_t>(uint32_t
 template<>
 inline constexpr value& value::set<value_type::thread_frame, uint32_t>(uint32_t v, bool evalOn)
 {
-	frame_value.addr = v;
-	frame_value.eval = evalOn;
-	_type            = value_type::thread_frame;
+	set_frame({v, evalOn});
+	set_type(value_type::thread_frame);
 	return *this;
 }
 
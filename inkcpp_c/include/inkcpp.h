@@ -295,6 +295,33 @@ typedef struct HInkSTory    HInkStory;
 	 * @param self
 	 */
 	void              ink_runner_choose(HInkRunner* self, int index);
+	/** @memberof HInkRunner
+	 * Continues the story until the next choice (or the end) and writes the whole turn into a
+	 * caller provided arena with one call.
+	 *
+	 * The block consists of `uint32_t` fields and zero terminated strings, each string is
+	 * prefixed with its length (without terminator) and padded with zeros to a multiple of 4
+	 * bytes, so all fields stay aligned if the arena is:
+	 * @code
+	 * uint32_t size;        // size of the block in bytes
+	 * uint32_t num_lines;
+	 *   uint32_t len; char text[]; uint32_t num_tags; { uint32_t len; char tag[]; } * num_tags
+	 * uint32_t num_choices;
+	 *   uint32_t index; uint32_t len; char text[]; uint32_t num_tags; { uint32_t len; char tag[]; }
+	 * @endcode
+	 * `index` is the value to pass to ::ink_runner_choose(). The block does not point into the
+	 * runtime and stays valid after the next call. Lines are written directly into the arena,
+	 * the runtime only allocates lines which do not fit. Tags and choices are copied.
+	 * @attention if the block does not fit into the arena, the story is still continued but the
+	 * content which did not fit is lost. Only complete lines are written, `size` and the return
+	 * value contain the capacity which would have been required.
+	 * @param self
+	 * @param arena memory to write the block to, should be aligned to 4 bytes
+	 * @param capacity size of the arena in bytes
+	 * @return size of the block in bytes, if it is larger than capacity the block is incomplete
+	 */
+	uint32_t
+	    ink_runner_continue_until_choice(HInkRunner* self, void* arena, uint32_t capacity);
 
 	/** @memberof HInkRunner
 	 * Binds a external function which is called form the runtime, with no return value.
@@ -425,6 +452,21 @@ typedef struct HInkSTory    HInkStory;
 	void
 	    ink_compile_json(const char* input_filename, const char* output_filename, const char** error);
 
+	/**
+	 * @ingroup clib
+	 * Compiles a .ink.json file to an inkCPP .bin file, reusing unchanged knots from a cache.
+	 * @param input_filename path to file contaning input data (.ink.json)
+	 * @param output_filename path to file output data will be written (.bin)
+	 * @param cache_directory directory to store compiled knots in, knots stored by previous calls
+	 * are reused if their json did not change. NULL disables the cache
+	 * @param error if not NULL will contain a error message if an error occures (else will be set to
+	 * NULL)
+	 */
+	void ink_compile_json_cached(
+	    const char* input_filename, const char* output_filename, const char* cache_directory,
+	    const char** error
+	);
+
 
 #ifdef __cplusplus
 }
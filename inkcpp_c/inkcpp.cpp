@@ -68,6 +68,85 @@ value inkvar_from_c(InkValue& val)
 	return value{};
 }
 
+namespace
+{
+// writes the block of ink_runner_continue_until_choice, past the capacity only the size is counted
+class batch_writer
+{
+public:
+	batch_writer(void* arena, uint32_t capacity)
+	    : _data{static_cast<unsigned char*>(arena)}
+	    , _capacity{capacity}
+	{
+	}
+
+	uint32_t size() const { return _size; }
+
+	// appends a field and returns its offset
+	uint32_t write(uint32_t field)
+	{
+		uint32_t offset = _size;
+		set(offset, field);
+		_size += sizeof(field);
+		return offset;
+	}
+
+	// appends a length prefixed string, zero padded to keep the next field aligned
+	void write(const char* str) { write_text(write(uint32_t{0}), str); }
+
+	// appends the text of a string behind its length field, str may already be in place at tail()
+	void write_text(uint32_t length_field, const char* str)
+	{
+		uint32_t length = static_cast<uint32_t>(strlen(str));
+		set(length_field, length);
+		uint32_t padded = (length + sizeof(uint32_t)) & ~uint32_t(sizeof(uint32_t) - 1);
+		if (padded <= _capacity && _size <= _capacity - padded) {
+			if (str != tail()) {
+				memcpy(_data + _size, str, length);
+			}
+			memset(_data + _size + length, 0, padded - length);
+		}
+		_size += padded;
+	}
+
+	// free space behind everything written so far, nullptr if the arena is full
+	char* tail() const
+	{
+		return _size < _capacity ? reinterpret_cast<char*>(_data + _size) : nullptr;
+	}
+
+	// size of tail(), a string and its terminator which fit into it also fit with their padding
+	uint32_t room() const
+	{
+		return _size < _capacity ? (_capacity - _size) & ~uint32_t(sizeof(uint32_t) - 1) : 0;
+	}
+
+	// discards everything written from offset on
+	void rewind(uint32_t offset) { _size = offset; }
+
+	// overwrites a field if it lies inside the arena
+	void set(uint32_t offset, uint32_t field)
+	{
+		if (offset <= _capacity && sizeof(field) <= _capacity - offset) {
+			memcpy(_data + offset, &field, sizeof(field));
+		}
+	}
+
+	// true while everything written so far fits into the arena
+	bool fits()
+	{
+		_complete = _complete && _size <= _capacity;
+		return _complete;
+	}
+
+private:
+	unsigned char* _data;
+	uint32_t       _capacity;
+	uint32_t       _size     = 0;
+	bool           _complete = true;
+};
+} // namespace
+
 extern "C" {
 	HInkSnapshot* ink_snapshot_from_file(const char* filename)
 	{
@@ -231,6 +310,50 @@ extern "C" {
 		return reinterpret_cast<runner*>(self)->get()->choose(choice_id);
 	}
 
+	uint32_t ink_runner_continue_until_choice(HInkRunner* self, void* arena, uint32_t capacity)
+	{
+		runner_interface* run = reinterpret_cast<runner*>(self)->get();
+		batch_writer      out(arena, capacity);
+		uint32_t          size_field  = out.write(uint32_t{0});
+		uint32_t          lines_field = out.write(uint32_t{0});
+		uint32_t          num_lines   = 0;
+		while (run->can_continue()) {
+			// the line is written directly into the arena if it fits
+			uint32_t    length_field = out.write(uint32_t{0});
+			const char* line         = run->getline_alloc(out.tail(), out.room());
+			if (run->awaiting_external()) {
+				out.rewind(length_field);
+				break;
+			}
+			out.write_text(length_field, line);
+			out.write(static_cast<uint32_t>(run->num_tags()));
+			for (size_t i = 0; i < run->num_tags(); ++i) {
+				out.write(run->get_tag(i));
+			}
+			// only count lines which are completely inside the arena
+			if (out.fits()) {
+				out.set(lines_field, ++num_lines);
+			}
+		}
+
+		uint32_t choices_field = out.write(uint32_t{0});
+		uint32_t num_choices   = 0;
+		for (size_t i = 0; i < run->num_choices(); ++i) {
+			const choice* c = run->get_choice(i);
+			out.write(static_cast<uint32_t>(i));
+			out.write(c->text());
+			out.write(static_cast<uint32_t>(c->num_tags()));
+			for (size_t j = 0; j < c->num_tags(); ++j) {
+				out.write(c->get_tag(j));
+			}
+			if (out.fits()) {
+				out.set(choices_field, ++num_choices);
+			}
+		}
+		out.set(size_field, out.size());
+		return out.size();
+	}
+
 	void ink_runner_bind_void(
 	    HInkRunner* self, const char* function_name, InkExternalFunctionVoid callback,
 	    int lookaheadSafe
@@ -360,10 +483,22 @@ extern "C" {
 	}
 
 	void ink_compile_json(const char* input_filename, const char* output_filename, const char** error)
+	{
+		ink_compile_json_cached(input_filename, output_filename, nullptr, error);
+	}
+
+	void ink_compile_json_cached(
+	    const char* input_filename, const char* output_filename, const char* cache_directory,
+	    const char** error
+	)
 	{
 		ink::compiler::compilation_results result;
-		ink::compiler::run(input_filename, output_filename, &result);
-		if (error != nullptr && ! result.errors.empty() || ! result.warnings.empty()) {
+		ink::compiler::compilation_options options;
+		if (cache_directory != nullptr) {
+			options.cache_directory = cache_directory;
+		}
+		ink::compiler::run(input_filename, output_filename, &result, options);
+		if (error != nullptr && (! result.errors.empty() || ! result.warnings.empty())) {
 			std::string str{};
 			for (auto& warn : result.warnings) {
 				str += "WARNING: " + warn + '\n';
@@ -0,0 +1,90 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <inkcpp.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+static const uint32_t* read_string(const uint32_t* ptr, const char** str)
+{
+	uint32_t len = *ptr++;
+	*str         = ( const char* ) ptr;
+	assert(strlen(*str) == len);
+	return ptr + (len + 4) / 4;
+}
+
+static const uint32_t* expect_line(const uint32_t* ptr, const char* text, uint32_t num_tags)
+{
+	const char* str;
+	ptr = read_string(ptr, &str);
+	assert(strcmp(str, text) == 0);
+	assert(*ptr++ == num_tags);
+	for (uint32_t i = 0; i < num_tags; ++i) {
+		ptr = read_string(ptr, &str);
+	}
+	return ptr;
+}
+
+int main()
+{
+	uint32_t     arena[256];
+	HInkStory*   story  = ink_story_from_file(INK_TEST_RESOURCE_DIR "TagsStory.bin");
+	HInkGlobals* store  = ink_story_new_globals(story);
+	HInkRunner*  runner = ink_story_new_runner(story, store);
+
+	uint32_t size = ink_runner_continue_until_choice(runner, arena, sizeof(arena));
+	assert(size <= sizeof(arena));
+	assert(arena[0] == size);
+	assert(arena[1] == 6);
+	const uint32_t* ptr = arena + 2;
+	const char*     str;
+	ptr                 = expect_line(ptr, "First line has global tags only\n", 1);
+	ptr                 = expect_line(ptr, "Second line has one tag\n", 1);
+	ptr                 = expect_line(ptr, "Third line has two tags\n", 2);
+	ptr                 = expect_line(ptr, "Fourth line has three tags\n", 3);
+	ptr                 = read_string(ptr, &str);
+	assert(strcmp(str, "Hello\n") == 0);
+	assert(*ptr++ == 4);
+	ptr = read_string(ptr, &str);
+	assert(strcmp(str, "knot_tag_start") == 0);
+	ptr = read_string(ptr, &str);
+	ptr = read_string(ptr, &str);
+	ptr = read_string(ptr, &str);
+	assert(strcmp(str, "output_tag_h") == 0);
+	ptr = expect_line(ptr, "Second line has no tags\n", 0);
+
+	assert(*ptr++ == 2);
+	assert(*ptr++ == 0);
+	ptr = read_string(ptr, &str);
+	assert(strcmp(str, "a") == 0);
+	assert(*ptr++ == 0);
+	assert(*ptr++ == 1);
+	ptr = read_string(ptr, &str);
+	assert(strcmp(str, "b") == 0);
+	assert(*ptr++ == 2);
+	ptr = read_string(ptr, &str);
+	assert(strcmp(str, "choice_tag_b") == 0);
+	ptr = read_string(ptr, &str);
+	assert(strcmp(str, "choice_tag_b_2") == 0);
+	assert(( const char* ) ptr - ( const char* ) arena == size);
+	assert(! ink_runner_can_continue(runner));
+
+	ink_runner_choose(runner, 1);
+	size = ink_runner_continue_until_choice(runner, arena, sizeof(arena));
+	assert(arena[0] == size);
+	assert(arena[1] == 1);
+	ptr = expect_line(arena + 2, "Knot2\n", 2);
+	assert(*ptr++ == 3);
+
+	// a too small arena only contains complete lines and reports the required size
+	HInkRunner* other = ink_story_new_runner(story, ink_story_new_globals(story));
+	uint32_t    small = ink_runner_continue_until_choice(other, arena, 72);
+	assert(small > 72);
+	assert(arena[0] == small);
+	assert(arena[1] == 1);
+	expect_line(arena + 2, "First line has global tags only\n", 1);
+	assert(! ink_runner_can_continue(other));
+	assert(ink_runner_num_choices(other) == 2);
+}
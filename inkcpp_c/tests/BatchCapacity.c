@@ -0,0 +1,104 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <inkcpp.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+#define ARENA_SIZE 1024
+#define UNTOUCHED 0xAB
+
+// offset of the field behind the length prefixed string at offset
+static uint32_t skip_string(const uint32_t* block, uint32_t offset)
+{
+	uint32_t len = block[offset / 4];
+	return offset + 4 + ((len + 4) & ~3u);
+}
+
+// offset of the field behind the line at offset
+static uint32_t skip_line(const uint32_t* block, uint32_t offset)
+{
+	offset            = skip_string(block, offset);
+	uint32_t num_tags = block[offset / 4];
+	offset += 4;
+	for (uint32_t i = 0; i < num_tags; ++i) {
+		offset = skip_string(block, offset);
+	}
+	return offset;
+}
+
+// a new runner which made the given choice after the first turn, -1 stays at the first turn
+static HInkRunner* start(HInkStory* story, HInkGlobals* store, int choice)
+{
+	uint32_t    arena[ARENA_SIZE];
+	HInkRunner* runner = ink_story_new_runner(story, store);
+	if (choice >= 0) {
+		ink_runner_continue_until_choice(runner, arena, sizeof(arena));
+		ink_runner_choose(runner, choice);
+	}
+	return runner;
+}
+
+// continues a turn with every capacity up to its size and compares the result with the complete
+// block, returns the number of lines in the turn
+static uint32_t check_turn(HInkStory* story, int choice)
+{
+	uint32_t     expected[ARENA_SIZE];
+	uint32_t     arena[ARENA_SIZE];
+	HInkGlobals* store  = ink_story_new_globals(story);
+	HInkRunner*  runner = start(story, store, choice);
+	uint32_t     size   = ink_runner_continue_until_choice(runner, expected, sizeof(expected));
+	assert(size <= sizeof(expected));
+	assert(expected[0] == size);
+	ink_runner_delete(runner);
+	ink_globals_delete(store);
+
+	for (uint32_t capacity = 0; capacity <= size + 8; ++capacity) {
+		store  = ink_story_new_globals(story);
+		runner = start(story, store, choice);
+		memset(arena, UNTOUCHED, sizeof(arena));
+		assert(ink_runner_continue_until_choice(runner, arena, capacity) == size);
+
+		// nothing is written past the capacity
+		const unsigned char* bytes = ( const unsigned char* ) arena;
+		for (uint32_t i = capacity; i < sizeof(arena); ++i) {
+			assert(bytes[i] == UNTOUCHED);
+		}
+		if (capacity >= 8) {
+			// all lines which fit completely are written and equal those of the complete block
+			assert(arena[0] == size);
+			uint32_t end       = 8;
+			uint32_t num_lines = 0;
+			while (num_lines < expected[1] && skip_line(expected, end) <= capacity) {
+				end = skip_line(expected, end);
+				++num_lines;
+			}
+			assert(arena[1] == num_lines);
+			assert(memcmp(arena + 2, expected + 2, end - 8) == 0);
+		}
+		if (capacity >= size) {
+			assert(memcmp(arena, expected, size) == 0);
+		}
+		ink_runner_delete(runner);
+		ink_globals_delete(store);
+	}
+	return expected[1];
+}
+
+int main()
+{
+	const char* error = NULL;
+	ink_compile_json(
+	    INK_TEST_RESOURCE_DIR "simple-1.1.1-inklecate.json",
+	    INK_TEST_RESOURCE_DIR "BatchCapacity.bin", &error
+	);
+	assert(error == NULL);
+	HInkStory* story = ink_story_from_file(INK_TEST_RESOURCE_DIR "BatchCapacity.bin");
+
+	assert(check_turn(story, -1) == 1);
+	assert(check_turn(story, 0) > 1);
+	assert(check_turn(story, 1) > 1);
+	ink_story_delete(story);
+}
@@ -3,7 +3,10 @@
 
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <map>
 #include <regex>
+#include <sstream>
 
 #include <story.h>
 #include <runner.h>
@@ -11,7 +14,9 @@
 #include <choice.h>
 #include <globals.h>
 #include <snapshot.h>
+#include <explorer.h>
 
+#include "serve.h"
 #include "test.h"
 
 void usage()
@@ -24,9 +29,85 @@ void usage()
 	     << "\t--ommit-choice-tags:\tdo not print tags after choices, primarly used to be compatible "
 	        "with inkclecat output"
 	     << "\t--inklecate <path-to-inklecate>:\toverwrites INKLECATE enviroment variable\n"
+	     << "\t-j <threads>:\tcompile knots on <threads> threads, 0 uses all hardware threads\n"
+	     << "\t--cache <directory>:\treuse knots compiled by previous runs from <directory>\n"
+	     << "\t-O0, -O1:\toptimization level of the bytecode, -O1 folds constants, removes "
+	        "instructions\n\tafter diverts and ends that nothing jumps to and fuses common "
+	        "instruction\n\tsequences, containers are kept even if they are unreachable\n"
+	     << "\t--embed <symbol>:\tEmbed mode\n\twrite a C++ source (and header) defining the "
+	        "story\n\tas byte array <symbol> with size <symbol>_size,\n\tload it with "
+	        "story::from_static\n"
+	     << "\t--serve:\tServe mode, used as last argument instead of the json file\n\tanswer "
+	        "requests read line by line from stdin, each response is\n\tframed as 'ok <length>' "
+	        "or 'error <length>' followed by <length> bytes\n"
+	        "\t\tcompile <input> [<output>]\n"
+	        "\t\tload <story>\n"
+	        "\t\tplay [--snapshot <snapshot>] <story> [<choice> ...]\n"
+	        "\t\tsnapshot <output> <story> [<choice> ...]\n"
+	        "\t\tquit\n"
+	     << "\t--max-stories <n>:\tnumber of compiled stories kept in memory in serve mode\n"
+	     << "\t--explore:\tExplore mode\n\ttake every choice sequence on -j threads and report "
+	        "how many\n\texplored states visited each knot and stitch\n"
+	     << "\t--depth <n>:\tmaximum number of choices taken in explore mode\n"
+	     << "\t--max-states <n>:\tmaximum number of distinct states explored\n"
+	     << "\t--breadth-first:\texplore states closer to the start first\n"
 	     << endl;
 }
 
+// Writes story binary as C++ source and header to embed it into an executable
+void write_embedded(
+    const std::string& binary, const std::string& symbol, const std::string& sourceFilename
+)
+{
+	std::string headerFilename
+	    = std::regex_replace(sourceFilename, std::regex("\\.[^\\.]+$"), ".h");
+	std::string headerName = std::regex_replace(headerFilename, std::regex("^.*[\\\\/]"), "");
+
+	std::ofstream header(headerFilename, std::ios::out);
+	header << "// generated by inkcpp_cl, do not edit\n"
+	       << "#pragma once\n\n"
+	       << "#include <cstddef>\n\n"
+	       << "extern const unsigned char " << symbol << "[];\n"
+	       << "extern const std::size_t " << symbol << "_size;\n";
+
+	std::ofstream source(sourceFilename, std::ios::out);
+	source << "// generated by inkcpp_cl, do not edit\n"
+	       << "#include \"" << headerName << "\"\n\n"
+	       << "alignas(4) extern const unsigned char " << symbol << "[] = {";
+	source << std::hex << std::setfill('0');
+	for (size_t i = 0; i < binary.size(); ++i) {
+		source << (i % 16 == 0 ? "\n\t" : " ") << "0x" << std::setw(2)
+		       << static_cast<int>(static_cast<unsigned char>(binary[i])) << ",";
+	}
+	source << "\n};\n"
+	       << "extern const std::size_t " << symbol << "_size = sizeof(" << symbol << ");\n";
+}
+
+// Prints statistics and the coverage of named containers of an exploration
+void print_exploration(
+    const ink::runtime::explore_result& result, const std::map<uint32_t, std::string>& names
+)
+{
+	std::cout << "explored " << result.states << " states, " << result.endings << " endings, "
+	          << result.duplicates << " duplicates, " << result.truncated << " truncated"
+	          << (result.complete ? "" : " (incomplete)") << '\n'
+	          << "covered " << result.covered() << " of " << result.containers.size()
+	          << " containers\n";
+
+	std::map<std::string, size_t> coverage;
+	for (const ink::runtime::container_coverage& container : result.containers) {
+		// variable declarations are not part of the story flow
+		auto name = names.find(container.name);
+		if (name != names.end() && name->second != "global decl") {
+			coverage[name->second] = container.states;
+		}
+	}
+	for (const auto& [name, states] : coverage) {
+		std::cout << std::setw(10) << states << "  " << name << (states == 0 ? "  NOT COVERED" : "")
+		          << '\n';
+	}
+}
+
 int main(int argc, const char** argv)
 {
 	// Usage
@@ -39,7 +120,16 @@ int main(int argc, const char** argv)
 	std::string outputFilename;
 	bool        playMode = false, testMode = false, testDirectory = false, ommit_choice_tags = false;
 	std::string snapshotFile;
+	std::string embedSymbol;
 	const char* inklecateOverwrite = nullptr;
+
+	bool   serveMode  = false;
+	size_t maxStories = 16;
+
+	bool                          exploreMode = false;
+	ink::runtime::explore_options exploreOptions;
+
+	ink::compiler::compilation_options compileOptions;
 	for (int i = 1; i < argc - 1; i++) {
 		std::string option = argv[i];
 		if (option == "-o") {
@@ -58,6 +148,58 @@ int main(int argc, const char** argv)
 		} else if (option == "-td") {
 			testMode      = true;
 			testDirectory = true;
+		} else if (option == "-j") {
+			if (i + 1 < argc - 1 && argv[i + 1][0] != '-') {
+				++i;
+				compileOptions.threads = std::stoul(argv[i]);
+			} else {
+				std::cerr << "-j requires a number of threads\n";
+				return 1;
+			}
+		} else if (option == "--cache") {
+			if (i + 1 < argc - 1 && argv[i + 1][0] != '-') {
+				++i;
+				compileOptions.cache_directory = argv[i];
+			} else {
+				std::cerr << "--cache requires a directory\n";
+				return 1;
+			}
+		} else if (option == "-O0" || option == "-O1") {
+			compileOptions.optimization_level = option[2] - '0';
+		} else if (option == "--embed") {
+			if (i + 1 < argc - 1 && argv[i + 1][0] != '-') {
+				++i;
+				embedSymbol = argv[i];
+			} else {
+				std::cerr << "--embed requires a symbol name\n";
+				return 1;
+			}
+		} else if (option == "--serve") {
+			serveMode = true;
+		} else if (option == "--max-stories") {
+			if (i + 1 < argc - 1 && argv[i + 1][0] != '-') {
+				++i;
+				maxStories = std::stoul(argv[i]);
+			} else {
+				std::cerr << "--max-stories requires a number of stories\n";
+				return 1;
+			}
+		} else if (option == "--explore") {
+			exploreMode = true;
+		} else if (option == "--depth" || option == "--max-states") {
+			if (i + 1 < argc - 1 && argv[i + 1][0] != '-') {
+				++i;
+				if (option == "--depth") {
+					exploreOptions.max_depth = std::stoul(argv[i]);
+				} else {
+					exploreOptions.max_states = std::stoul(argv[i]);
+				}
+			} else {
+				std::cerr << option << " requires a number\n";
+				return 1;
+			}
+		} else if (option == "--breadth-first") {
+			exploreOptions.breadth_first = true;
 		} else if (option == "--inklecate") {
 			if (i + 1 < argc - 1 && argv[i + 1][0] != '-') {
 				++i;
@@ -71,6 +213,17 @@ int main(int argc, const char** argv)
 	// Get input filename
 	std::string inputFilename = argv[argc - 1];
 
+	// Serve mode
+	if (serveMode || inputFilename == "--serve") {
+		serve_options options;
+		options.compileOptions     = compileOptions;
+		options.inklecateOverwrite = inklecateOverwrite;
+		options.ommitChoiceTags    = ommit_choice_tags;
+		options.maxStories         = maxStories;
+		serve(std::cin, std::cout, options);
+		return 0;
+	}
+
 	// Test mode
 	// if (testMode) {
 	// 	bool result;
@@ -85,7 +238,9 @@ int main(int argc, const char** argv)
 
 	// If output filename not specified, use input filename as guideline
 	if (outputFilename.empty()) {
-		outputFilename = std::regex_replace(inputFilename, std::regex("\\.[^\\.]+$"), ".bin");
+		outputFilename = std::regex_replace(
+		    inputFilename, std::regex("\\.[^\\.]+$"), embedSymbol.empty() ? ".bin" : ".cpp"
+		);
 	}
 
 	// If input filename is an .ink file
@@ -109,11 +264,19 @@ int main(int argc, const char** argv)
 	}
 
 	// Open file and compile
+	std::string                        embedded;
+	ink::compiler::compilation_results results;
 	try {
-		ink::compiler::compilation_results results;
-		std::ofstream                      fout(outputFilename, std::ios::binary | std::ios::out);
-		ink::compiler::run(inputFilename.c_str(), fout, &results);
-		fout.close();
+		if (embedSymbol.empty()) {
+			std::ofstream fout(outputFilename, std::ios::binary | std::ios::out);
+			ink::compiler::run(inputFilename.c_str(), fout, &results, compileOptions);
+			fout.close();
+		} else {
+			std::stringstream binary(std::ios::binary | std::ios::in | std::ios::out);
+			ink::compiler::run(inputFilename.c_str(), binary, &results, compileOptions);
+			embedded = binary.str();
+			write_embedded(embedded, embedSymbol, outputFilename);
+		}
 		if (json_file_is_tmp_file) {
 			remove(inputFilename.c_str());
 		}
@@ -126,8 +289,9 @@ int main(int argc, const char** argv)
 			std::cerr << "ERROR: " << err << '\n';
 		}
 
-		if (results.errors.size() > 0 && playMode) {
-			std::cerr << "Cancelling play mode. Errors detected in compilation" << std::endl;
+		if (results.errors.size() > 0 && (playMode || exploreMode)) {
+			std::cerr << "Cancelling " << (playMode ? "play" : "explore")
+			          << " mode. Errors detected in compilation" << std::endl;
 			return -1;
 		}
 	} catch (std::exception& e) {
@@ -138,7 +302,7 @@ int main(int argc, const char** argv)
 		return 1;
 	}
 
-	if (! playMode) {
+	if (! playMode && ! exploreMode) {
 		return 0;
 	}
 
@@ -147,7 +311,19 @@ int main(int argc, const char** argv)
 		using namespace ink::runtime;
 
 		// Load story
-		std::unique_ptr<story> myInk{story::from_file(outputFilename.c_str())};
+		std::unique_ptr<story> myInk{
+		    embedSymbol.empty()
+		        ? story::from_file(outputFilename.c_str())
+		        : story::from_static(
+		              reinterpret_cast<const unsigned char*>(embedded.data()), embedded.size()
+		          )
+		};
+
+		if (exploreMode) {
+			exploreOptions.threads = compileOptions.threads;
+			print_exploration(explore(*myInk, exploreOptions), results.container_names);
+			return 0;
+		}
 
 		// Start runner
 		runner thread;
@@ -159,54 +335,10 @@ int main(int argc, const char** argv)
 			thread = myInk->new_runner();
 		}
 
-		while (true) {
-			while (thread->can_continue()) {
-				std::cout << thread->getline();
-				if (thread->has_tags()) {
-					std::cout << "# tags: ";
-					for (int i = 0; i < thread->num_tags(); ++i) {
-						if (i != 0) {
-							std::cout << ", ";
-						}
-						std::cout << thread->get_tag(i);
-					}
-					std::cout << std::endl;
-				}
-			}
-			if (thread->has_choices()) {
-				// Extra end line
-				std::cout << std::endl;
-
-				int index = 1;
-				for (const ink::runtime::choice& c : *thread) {
-					std::cout << index++ << ": " << c.text();
-					if (! ommit_choice_tags && c.has_tags()) {
-						std::cout << "\n\t";
-						for (size_t i = 0; i < c.num_tags(); ++i) {
-							std::cout << "# " << c.get_tag(i) << " ";
-						}
-					}
-					std::cout << std::endl;
-				}
-
-				int c = 0;
-				std::cout << "?> ";
-				std::cin >> c;
-				if (c == -1) {
-					snapshot* snap = thread->create_snapshot();
-					snap->write_to_file(
-					    std::regex_replace(inputFilename, std::regex("\\.[^\\.]+$"), ".snap").c_str()
-					);
-					delete snap;
-					break;
-				}
-				thread->choose(c - 1);
-				continue;
-			}
-
-			// out of content
-			break;
-		}
+		play(
+		    thread, std::cin, std::cout, ommit_choice_tags,
+		    std::regex_replace(inputFilename, std::regex("\\.[^\\.]+$"), ".snap")
+		);
 	} catch (const std::exception& e) {
 		std::cerr << "Unhandled ink runtime exception: " << e.what() << std::endl;
 		return 1;
@@ -0,0 +1,265 @@
+#include "serve.h"
+#include "test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <choice.h>
+#include <compiler.h>
+#include <globals.h>
+#include <snapshot.h>
+#include <story.h>
+
+using namespace ink::runtime;
+
+void play(
+    runner& thread, std::istream& choices, std::ostream& out, bool ommitChoiceTags,
+    const std::string& snapshotFilename
+)
+{
+	while (true) {
+		while (thread->can_continue()) {
+			out << thread->getline();
+			if (thread->has_tags()) {
+				out << "# tags: ";
+				for (size_t i = 0; i < thread->num_tags(); ++i) {
+					if (i != 0) {
+						out << ", ";
+					}
+					out << thread->get_tag(i);
+				}
+				out << std::endl;
+			}
+		}
+		if (thread->has_choices()) {
+			// Extra end line
+			out << std::endl;
+
+			int index = 1;
+			for (const choice& c : *thread) {
+				out << index++ << ": " << c.text();
+				if (! ommitChoiceTags && c.has_tags()) {
+					out << "\n\t";
+					for (size_t i = 0; i < c.num_tags(); ++i) {
+						out << "# " << c.get_tag(i) << " ";
+					}
+				}
+				out << std::endl;
+			}
+
+			int c = 0;
+			out << "?> ";
+			if (! (choices >> c)) {
+				// no choices left
+				break;
+			}
+			if (c == -1) {
+				std::ofstream snap(snapshotFilename, std::ios::binary);
+				if (! snap.is_open()) {
+					throw std::runtime_error("Failed to open file to write snapshot");
+				}
+				stream_snapshot_sink sink(snap);
+				thread->write_snapshot(sink);
+				break;
+			}
+			thread->choose(c - 1);
+			continue;
+		}
+
+		// out of content
+		break;
+	}
+}
+
+namespace
+{
+// Compiled stories, if the cache is full the least recently used story is dropped
+class story_cache
+{
+public:
+	struct entry {
+		std::string                     filename;
+		std::filesystem::file_time_type modified;
+		std::string                     binary;
+		std::unique_ptr<story>          ink;
+	};
+
+	story_cache(const serve_options& options)
+	    : _options{options}
+	{
+	}
+
+	// Returns the story compiled from filename (.ink, .json or .bin),
+	// it is compiled again if the file changed since it was cached
+	entry& get(const std::string& filename, std::ostream& messages, bool& cached)
+	{
+		std::filesystem::file_time_type modified = std::filesystem::last_write_time(filename);
+
+		auto itr = _index.find(filename);
+		cached   = itr != _index.end() && itr->second->modified == modified;
+		if (cached) {
+			_entries.splice(_entries.begin(), _entries, itr->second);
+			return _entries.front();
+		}
+		if (itr != _index.end()) {
+			_entries.erase(itr->second);
+			_index.erase(itr);
+		}
+
+		std::string binary = compile(filename, messages);
+		_entries.push_front(entry{filename, modified, std::move(binary), nullptr});
+		entry& result = _entries.front();
+		result.ink.reset(story::from_binary(
+		    reinterpret_cast<unsigned char*>(result.binary.data()), result.binary.size(), false
+		));
+		_index[filename] = _entries.begin();
+
+		while (_entries.size() > _options.maxStories && _entries.size() > 1) {
+			_index.erase(_entries.back().filename);
+			_entries.pop_back();
+		}
+		return result;
+	}
+
+private:
+	std::string compile(const std::string& filename, std::ostream& messages)
+	{
+		std::string extension = std::filesystem::path(filename).extension().string();
+		if (extension == ".bin") {
+			std::ifstream file(filename, std::ios::binary);
+			return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		std::string jsonFilename = filename;
+		if (extension == ".ink") {
+			jsonFilename = std::regex_replace(filename, std::regex("\\.[^\\.]+$"), ".tmp");
+			inklecate(filename, jsonFilename, _options.inklecateOverwrite);
+		}
+		std::stringstream                  binary(std::ios::binary | std::ios::in | std::ios::out);
+		ink::compiler::compilation_results results;
+		try {
+			ink::compiler::run(jsonFilename.c_str(), binary, &results, _options.compileOptions);
+		} catch (...) {
+			if (jsonFilename != filename) {
+				remove(jsonFilename.c_str());
+			}
+			throw;
+		}
+		if (jsonFilename != filename) {
+			remove(jsonFilename.c_str());
+		}
+
+		for (auto& warn : results.warnings) {
+			messages << "WARNING: " << warn << '\n';
+		}
+		if (! results.errors.empty()) {
+			std::string errors;
+			for (auto& err : results.errors) {
+				errors += "ERROR: " + err + '\n';
+			}
+			throw std::runtime_error(errors);
+		}
+		return binary.str();
+	}
+
+	const serve_options&                                        _options;
+	std::list<entry>                                            _entries; // most recently used first
+	std::unordered_map<std::string, std::list<entry>::iterator> _index;
+};
+
+std::string next_argument(std::istream& request, const char* name)
+{
+	std::string argument;
+	if (! (request >> std::quoted(argument))) {
+		throw std::runtime_error(std::string("missing argument <") + name + ">");
+	}
+	return argument;
+}
+} // namespace
+
+void serve(std::istream& in, std::ostream& out, const serve_options& options)
+{
+	story_cache cache(options);
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream request(line);
+		std::string        command;
+		if (! (request >> command)) {
+			continue;
+		}
+		if (command == "quit") {
+			break;
+		}
+
+		std::ostringstream result;
+		bool               ok = true;
+		try {
+			bool cached;
+			if (command == "compile") {
+				// compile <input> [<output>]
+				story_cache::entry& entry = cache.get(next_argument(request, "input"), result, cached);
+				std::string         outputFilename;
+				if (request >> std::quoted(outputFilename)) {
+					std::ofstream output(outputFilename, std::ios::binary);
+					output.write(entry.binary.data(), entry.binary.size());
+				}
+			} else if (command == "load") {
+				// load <story>
+				cache.get(next_argument(request, "story"), result, cached);
+				result << (cached ? "cached" : "loaded") << '\n';
+			} else if (command == "play" || command == "snapshot") {
+				// play [--snapshot <snapshot>] <story> [<choice> ...]
+				// snapshot <output> <story> [<choice> ...]
+				std::string snapshotFilename, filename;
+				if (command == "snapshot") {
+					snapshotFilename = next_argument(request, "output");
+					filename         = next_argument(request, "story");
+				} else {
+					filename = next_argument(request, "story");
+					if (filename == "--snapshot") {
+						snapshotFilename = next_argument(request, "snapshot");
+						filename         = next_argument(request, "story");
+					}
+				}
+				story& ink = *cache.get(filename, result, cached).ink;
+				runner thread;
+				if (command == "play" && ! snapshotFilename.empty()) {
+					std::unique_ptr<snapshot> snap{snapshot::from_file(snapshotFilename.c_str())};
+					thread = ink.new_runner_from_snapshot(*snap);
+				} else {
+					thread = ink.new_runner();
+				}
+				play(
+				    thread, request, result, options.ommitChoiceTags,
+				    std::regex_replace(filename, std::regex("\\.[^\\.]+$"), ".snap")
+				);
+				if (command == "snapshot") {
+					std::ofstream snap(snapshotFilename, std::ios::binary);
+					if (! snap.is_open()) {
+						throw std::runtime_error("Failed to open file to write snapshot");
+					}
+					stream_snapshot_sink sink(snap);
+					thread->write_snapshot(sink);
+				}
+			} else {
+				throw std::runtime_error("Unknown request '" + command + "'");
+			}
+		} catch (const std::exception& e) {
+			ok = false;
+			result << e.what() << '\n';
+		}
+
+		std::string payload = result.str();
+		out << (ok ? "ok " : "error ") << payload.size() << '\n' << payload;
+		out.flush();
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+#include <compiler.h>
+#include <runner.h>
+
+// Options for play and serve mode
+struct serve_options {
+	ink::compiler::compilation_options compileOptions;
+	const char*                        inklecateOverwrite = nullptr;
+	bool                               ommitChoiceTags    = false;
+	size_t                             maxStories         = 16;
+};
+
+// Plays the story, reading 1 based choice indices from choices until the story or the choices end.
+// Choosing -1 writes a snapshot to snapshotFilename and stops.
+void play(
+    ink::runtime::runner& thread, std::istream& choices, std::ostream& out, bool ommitChoiceTags,
+    const std::string& snapshotFilename
+);
+
+// Answers requests read line by line from in, until the input ends or a quit request
+// Each response is framed as "ok <length>\n" or "error <length>\n" followed by <length> bytes.
+void serve(std::istream& in, std::ostream& out, const serve_options& options);
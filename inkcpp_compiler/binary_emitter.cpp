@@ -9,14 +9,15 @@
 #include "header.h"
 #include "version.h"
 #include "list_data.h"
+#include "parallel.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <fstream>
-
-#ifndef WIN32
-#	include <cstring>
-#endif
+#include <limits>
+#include <string_view>
 
 namespace ink::compiler::internal
 {
@@ -24,19 +25,6 @@ using std::vector;
 using std::map;
 using std::string;
 
-char* strtok_s(char* s, const char* sep, char** context)
-{
-#if defined(_WIN32) || defined(_WIN64)
-	return ::strtok_s(s, sep, context);
-#else
-	if (context == nullptr || sep == nullptr || (s == nullptr && *context == nullptr)) {
-		errno = EINVAL;
-		return nullptr;
-	}
-	return ::strtok_r(s, sep, context);
-#endif
-}
-
 // holds information about a container
 struct container_data {
 	// child containers
@@ -61,6 +49,10 @@ struct container_data {
 	// Index used in CNT? operations
 	container_t counter_index = ~0;
 
+	// How the container was added to its parent
+	int    index_in_parent = -1;
+	string name;
+
 	~container_data()
 	{
 		// Destroy children
@@ -74,8 +66,137 @@ struct container_data {
 		// noop_offsets.clear();
 		parent = nullptr;
 	}
+
+	void add_child(container_data* child, int child_index, const string& child_name)
+	{
+		child->parent          = this;
+		child->index_in_parent = child_index;
+		child->name            = child_name;
+		children.push_back(child);
+		indexed_children.insert({child_index, child});
+
+		if (! child_name.empty()) {
+			named_children.insert({child_name, child});
+		}
+	}
+
+	// moves the container and its children by the given offsets
+	void relocate(uint32_t instruction_offset, container_t container_index_offset)
+	{
+		offset += instruction_offset;
+		end_offset += instruction_offset;
+		for (auto& noop : noop_offsets)
+			noop.second += instruction_offset;
+		if (counter_index != ~container_t(0))
+			counter_index += container_index_offset;
+
+		for (auto child : children)
+			child->relocate(instruction_offset, container_index_offset);
+	}
+};
+
+namespace
+{
+// instruction decoded by the optimizer
+struct instruction {
+	uint32_t    offset;
+	Command     command;
+	CommandFlag flag;
+	uint32_t    payload_size = 0;
+	uint32_t    payload      = 0;
+	// second payload of superinstructions, the offset of an instruction
+	uint32_t target = 0;
+
+	// payload is the offset of an instruction
+	bool code_payload = false;
+	bool removed      = false;
+
+	// superinstruction this instruction was fused into and position of its payload there
+	std::size_t fused_into     = ~std::size_t(0);
+	uint32_t    fused_position = 0;
 };
 
+// size of the payload written after a command
+uint32_t payload_size(Command command)
+{
+	switch (command) {
+		case Command::DIVERT_IF_READ_COUNT:
+		case Command::DIVERT_IF_VARIABLE: return 2 * sizeof(uint32_t);
+		case Command::STR:
+		case Command::INT:
+		case Command::BOOL:
+		case Command::FLOAT:
+		case Command::VALUE_POINTER:
+		case Command::DIVERT_VAL:
+		case Command::LIST:
+		case Command::TAG:
+		case Command::DIVERT:
+		case Command::DIVERT_TO_VARIABLE:
+		case Command::TUNNEL:
+		case Command::FUNCTION:
+		case Command::DEFINE_TEMP:
+		case Command::SET_VARIABLE:
+		case Command::PUSH_VARIABLE_VALUE:
+		case Command::READ_COUNT:
+		case Command::CHOICE:
+		case Command::START_CONTAINER_MARKER:
+		case Command::END_CONTAINER_MARKER:
+		case Command::CALL_EXTERNAL:
+		case Command::STR_NEWLINE:
+		case Command::OUTPUT_VARIABLE: return sizeof(uint32_t);
+		default: return 0;
+	}
+}
+
+// commands which may not continue with the next instruction, or whose execution depends on the
+//  position of the next instruction
+bool is_control(Command command)
+{
+	switch (command) {
+		case Command::DIVERT:
+		case Command::DIVERT_TO_VARIABLE:
+		case Command::TUNNEL:
+		case Command::FUNCTION:
+		case Command::DONE:
+		case Command::END:
+		case Command::TUNNEL_RETURN:
+		case Command::FUNCTION_RETURN:
+		case Command::CHOICE:
+		case Command::THREAD:
+		case Command::CALL_EXTERNAL:
+		case Command::START_CONTAINER_MARKER:
+		case Command::END_CONTAINER_MARKER:
+		case Command::DIVERT_IF_READ_COUNT:
+		case Command::DIVERT_IF_VARIABLE: return true;
+		default: return false;
+	}
+}
+
+// evaluates an integer operation like the runtime, false if the result is not representable
+bool fold(Command op, int32_t lhs, int32_t rhs, int32_t& result)
+{
+	int64_t value;
+	switch (op) {
+		case Command::ADD: value = int64_t(lhs) + rhs; break;
+		case Command::SUBTRACT: value = int64_t(lhs) - rhs; break;
+		case Command::MULTIPLY: value = int64_t(lhs) * rhs; break;
+		case Command::DIVIDE:
+		case Command::MOD:
+			if (rhs == 0 || (rhs == -1 && lhs == std::numeric_limits<int32_t>::min())) {
+				return false;
+			}
+			value = op == Command::DIVIDE ? lhs / rhs : lhs % rhs;
+			break;
+		default: return false;
+	}
+	if (value < std::numeric_limits<int32_t>::min() || value > std::numeric_limits<int32_t>::max()) {
+		return false;
+	}
+	result = static_cast<int32_t>(value);
+	return true;
+}
+} // namespace
+
 binary_emitter::binary_emitter()
     : _root(nullptr)
 {
@@ -105,12 +226,7 @@ uint32_t binary_emitter::start_container(int index_in_parent, const std::string&
 
 	// Add to parents lists
 	if (_current != nullptr) {
-		_current->children.push_back(container);
-		_current->indexed_children.insert({index_in_parent, container});
-
-		if (! name.empty()) {
-			_current->named_children.insert({name, container});
-		}
+		_current->add_child(container, index_in_parent, name);
 	}
 
 	// Set this as the current pointer
@@ -159,6 +275,11 @@ void binary_emitter::write_raw(
 	_containers.write(flag);
 	if (payload_size > 0)
 		_containers.write(( const byte_t* ) payload, payload_size);
+
+	// container markers payload is the container index
+	if (command == Command::START_CONTAINER_MARKER || command == Command::END_CONTAINER_MARKER) {
+		_relocations.push_back({_containers.pos() - sizeof(container_t), relocation::container_index});
+	}
 }
 
 void binary_emitter::write_path(
@@ -196,6 +317,7 @@ void binary_emitter::write_string(Command command, CommandFlag flag, const std::
 
 	// Written position is what we write out in our command
 	write(command, pos, flag);
+	_relocations.push_back({_containers.pos() - sizeof(uint32_t), relocation::string});
 }
 
 void binary_emitter::write_list(
@@ -208,6 +330,7 @@ void binary_emitter::write_list(
 	}
 	_lists.write(null_flag);
 	write(command, id, flag);
+	_relocations.push_back({_containers.pos() - sizeof(uint32_t), relocation::list});
 }
 
 void binary_emitter::handle_nop(int index_in_parent)
@@ -217,37 +340,85 @@ void binary_emitter::handle_nop(int index_in_parent)
 
 void binary_emitter::output(std::ostream& out)
 {
+	using header  = ink::internal::header;
+	using section = header::section;
+
+	// Collect container map and hash map first, their sizes are part of the directory
+	uint32_t      END_MARKER = ~0;
+	binary_stream map_data;
+	write_container_map(map_data, _container_map);
+	uint32_t container_map_size = map_data.pos() / (2 * sizeof(uint32_t));
+	map_data.write(END_MARKER);
+
+	binary_stream hash_data;
+	write_container_hash_map(hash_data);
+	uint32_t container_hash_size = hash_data.pos() / (2 * sizeof(uint32_t));
+	hash_data.write(END_MARKER);
+
+	// Layout sections, data containing uint32_t is aligned to 4 bytes
+	header::section_entry sections[header::NumSections];
+	uint32_t              offset = header::Size + header::DirectorySize;
+	auto place = [&sections, &offset](section s, size_t size, uint32_t align = 1) {
+		offset = (offset + align - 1) / align * align;
+		sections[static_cast<uint32_t>(s)] = {offset, static_cast<uint32_t>(size)};
+		offset += static_cast<uint32_t>(size);
+	};
+	place(section::strings, _strings.pos() + 1);
+	place(section::list_meta, _list_meta_size);
+	place(section::lists, _lists.pos() - _list_meta_size + sizeof(null_flag));
+	place(section::container_map, map_data.pos(), sizeof(uint32_t));
+	place(section::container_hash, hash_data.pos(), sizeof(uint32_t));
+	place(section::instructions, _containers.pos(), sizeof(uint32_t));
+
 	// Write the ink version
-	// TODO: define this order in header?
-	using header              = ink::internal::header;
 	header::endian_types same = header::endian_types::same;
 	out.write(( const char* ) &same, sizeof(decltype(same)));
 	out.write(( const char* ) &_ink_version, sizeof(decltype(_ink_version)));
 	out.write(( const char* ) &ink::InkBinVersion, sizeof(decltype(ink::InkBinVersion)));
 
+	// Write the section directory
+	for (const header::section_entry& entry : sections) {
+		out.write(( const char* ) &entry.offset, sizeof(uint32_t));
+		out.write(( const char* ) &entry.size, sizeof(uint32_t));
+	}
+	out.write(( const char* ) &_max_container_index, sizeof(uint32_t));
+	out.write(( const char* ) &container_map_size, sizeof(uint32_t));
+	out.write(( const char* ) &container_hash_size, sizeof(uint32_t));
+
+	// Fill gap till the start of the section
+	uint32_t written = header::Size + header::DirectorySize;
+	auto     pad_to  = [&out, &written, &sections](section s) {
+		const header::section_entry& entry = sections[static_cast<uint32_t>(s)];
+		for (; written < entry.offset; ++written) {
+			out << ( char ) 0;
+		}
+		written += entry.size;
+	};
+
 	// Write the string table
+	pad_to(section::strings);
 	_strings.write_to(out);
 
 	// Write a separator
 	out << ( char ) 0;
 
 	// Write lists meta data and defined lists
+	pad_to(section::list_meta);
+	pad_to(section::lists);
 	_lists.write_to(out);
 	// Write a seperator
 	out.write(reinterpret_cast<const char*>(&null_flag), sizeof(null_flag));
 
 	// Write out container map
-	write_container_map(out, _container_map, _max_container_index);
-
-	// Write a separator
-	uint32_t END_MARKER = ~0;
-	out.write(( const char* ) &END_MARKER, sizeof(uint32_t));
+	pad_to(section::container_map);
+	map_data.write_to(out);
 
 	// Write container hash list
-	write_container_hash_map(out);
-	out.write(( const char* ) &END_MARKER, sizeof(uint32_t));
+	pad_to(section::container_hash);
+	hash_data.write_to(out);
 
 	// Write the container data
+	pad_to(section::instructions);
 	_containers.write_to(out);
 
 	// Flush the file
@@ -258,12 +429,14 @@ void binary_emitter::initialize()
 {
 	// Reset binary data stores
 	_strings.reset();
-	_list_count = 0;
+	_list_count     = 0;
+	_list_meta_size = 0;
 	_lists.reset();
 	_containers.reset();
 
 	// clear other data
 	_paths.clear();
+	_relocations.clear();
 
 	if (_root != nullptr)
 		delete _root;
@@ -276,6 +449,10 @@ void binary_emitter::finalize()
 {
 	// post process path commands
 	process_paths();
+
+	// optimizations work on the resolved paths
+	if (_optimization_level > 0)
+		optimize();
 }
 
 void binary_emitter::setContainerIndex(container_t index) { _current->counter_index = index; }
@@ -286,7 +463,9 @@ uint32_t binary_emitter::fallthrough_divert()
 	write<uint32_t>(Command::DIVERT, ( uint32_t ) 0, CommandFlag::DIVERT_IS_FALLTHROUGH);
 
 	// Return the location of the divert offset
-	return _containers.pos() - sizeof(uint32_t);
+	uint32_t position = _containers.pos() - sizeof(uint32_t);
+	_relocations.push_back({position, relocation::instruction});
+	return position;
 }
 
 void binary_emitter::patch_fallthroughs(uint32_t position)
@@ -297,121 +476,532 @@ void binary_emitter::patch_fallthroughs(uint32_t position)
 
 void binary_emitter::process_paths()
 {
-	for (auto pair : _paths) {
-		// We need to replace the uint32_t at this location with the byte position of the requested
-		// container
-		using std::get;
-		size_t             position      = get<0>(pair);
-		const std::string& path          = get<1>(pair);
-		bool               optional      = get<2>(pair);
-		container_data*    context       = get<3>(pair);
-		bool               useCountIndex = get<4>(pair);
-
-		// Start at the root
-		container_data* container = _root;
-
-		// Unless it's a relative path
-		const char* path_cstr = path.c_str();
-		if (path_cstr[0] == '.') {
-			container = context;
-			path_cstr += 1;
-		}
-
-		bool firstParent = true;
-
-		// We need to parse the path
-		offset_t    noop_offset = ~0;
-		char*       _context    = nullptr;
-		const char* token
-		    = ink::compiler::internal::strtok_s(const_cast<char*>(path_cstr), ".", &_context);
-		while (token != nullptr) {
-			// Number
-			// variable names can start with a number
-			bool isNumber = true;
-			for (const char* i = token; *i; ++i) {
-				if (! isdigit(*i)) {
-					isNumber = false;
-					break;
-				}
-			}
-			if (isNumber) {
-				// Check if we have a nop registered at that index
-				int  index    = atoi(token);
-				auto nop_iter = container->noop_offsets.find(index);
-				if (nop_iter != container->noop_offsets.end()) {
-					noop_offset = nop_iter->second;
-					break;
-				} else
-					container = container->indexed_children[index];
+	// paths only read the container tree and write to distinct positions,
+	//  so they can be resolved in parallel
+	constexpr size_t ChunkSize = 4096;
+	size_t           chunks    = (_paths.size() + ChunkSize - 1) / ChunkSize;
+	parallel_for(chunks, thread_count(_threads), [this](size_t chunk) {
+		size_t end = std::min<size_t>(_paths.size(), (chunk + 1) * ChunkSize);
+		for (size_t i = chunk * ChunkSize; i < end; ++i) {
+			resolve_path(_paths[i]);
+		}
+	});
+}
+
+void binary_emitter::resolve_path(const path_t& entry)
+{
+	// We need to replace the uint32_t at this location with the byte position of the requested
+	// container
+	using std::get;
+	size_t             position      = get<0>(entry);
+	const std::string& path          = get<1>(entry);
+	bool               optional      = get<2>(entry);
+	container_data*    context       = get<3>(entry);
+	bool               useCountIndex = get<4>(entry);
+
+	// Start at the root
+	container_data* container = _root;
+
+	// Unless it's a relative path
+	std::string_view remaining = path;
+	if (! remaining.empty() && remaining[0] == '.') {
+		container = context;
+		remaining.remove_prefix(1);
+	}
+
+	bool firstParent = true;
+
+	// We need to parse the path
+	offset_t noop_offset = ~0;
+	while (container != nullptr && ! remaining.empty()) {
+		// Get the next token
+		std::size_t      separator = remaining.find('.');
+		std::string_view token     = remaining.substr(0, separator);
+		remaining.remove_prefix(separator == std::string_view::npos ? remaining.size() : separator + 1);
+		if (token.empty()) {
+			continue;
+		}
+
+		// Number
+		// variable names can start with a number
+		bool isNumber = true;
+		for (char c : token) {
+			if (! isdigit(c)) {
+				isNumber = false;
+				break;
 			}
-			// Parent
-			else if (token[0] == '^') {
-				if (! firstParent)
-					container = container->parent;
+		}
+		if (isNumber) {
+			// Check if we have a nop registered at that index
+			int  index    = atoi(std::string(token).c_str());
+			auto nop_iter = container->noop_offsets.find(index);
+			if (nop_iter != container->noop_offsets.end()) {
+				noop_offset = nop_iter->second;
+				break;
+			} else {
+				auto itr  = container->indexed_children.find(index);
+				container = itr == container->indexed_children.end() ? nullptr : itr->second;
 			}
-			// Named child
-			else {
-				auto itr  = container->named_children.find(token);
-				container = itr == container->named_children.end() ? nullptr : itr->second;
+		}
+		// Parent
+		else if (token[0] == '^') {
+			if (! firstParent)
+				container = container->parent;
+		}
+		// Named child
+		else {
+			auto itr  = container->named_children.find(std::string(token));
+			container = itr == container->named_children.end() ? nullptr : itr->second;
+		}
+
+		firstParent = false;
+	}
+
+	if (noop_offset != ~0) {
+		inkAssert(! useCountIndex, "Can't count visits to a noop!");
+		_containers.set(position, noop_offset);
+	} else {
+		// If we want the count index, write that out
+		if (useCountIndex) {
+			inkAssert(container != nullptr, "Was not able to resolve path '%hs'", path.c_str());
+			inkAssert(container->counter_index != ~0, "No count index available for this container!");
+			_containers.set(position, container->counter_index);
+		} else {
+			// Otherwise, write container address
+			if (container == nullptr) {
+				_containers.set(position, 0);
+				inkAssert(optional, "Was not able to resolve a not optional path! '%hs'", path.c_str());
+			} else {
+				_containers.set(position, container->offset);
 			}
+		}
+	}
+}
+
+void binary_emitter::optimize()
+{
+	constexpr std::size_t None = ~std::size_t(0);
+	constexpr uint32_t    InstructionHeader = sizeof(Command) + sizeof(CommandFlag);
+	if (_root == nullptr) {
+		return;
+	}
+
+	// Decode the instructions
+	std::vector<instruction> code;
+	uint32_t                 end = _containers.pos();
+	for (uint32_t offset = 0; offset < end;) {
+		instruction inst{
+		    offset, static_cast<Command>(_containers.get(offset)),
+		    static_cast<CommandFlag>(_containers.get(offset + 1))
+		};
+		inst.payload_size = payload_size(inst.command);
+		inst.payload = inst.payload_size > 0 ? _containers.read<uint32_t>(offset + InstructionHeader) : 0;
+		offset += InstructionHeader + inst.payload_size;
+		inkAssert(offset <= end, "Failed to decode instructions for optimization!");
+		code.push_back(inst);
+	}
+	const std::size_t size = code.size();
+
+	// index of the instruction at offset, size for the end of the instructions
+	auto index_of = [&code, end](uint32_t offset) -> std::size_t {
+		auto itr = std::lower_bound(
+		    code.begin(), code.end(), offset,
+		    [](const instruction& inst, uint32_t value) { return inst.offset < value; }
+		);
+		inkAssert(
+		    offset <= end && (itr == code.end() || itr->offset == offset),
+		    "Offset %u is not the start of an instruction!", offset
+		);
+		return itr - code.begin();
+	};
+
+	// Find all positions which are jumped to or define a container. The runtime only jumps to
+	//  the start of the story, to resolved paths and fallthrough diverts (both are instruction
+	//  payloads), to named containers (through the hash map) and knows the start and end of
+	//  counted containers from the container map. Every other offset is only reached by falling
+	//  through: a noop, the end of a container or the start of an unnamed container is a label
+	//  only if a path resolved to it, so they are not marked on their own
+	std::vector<bool> label(size + 1), container_start(size + 1), boundary(size + 1);
+	label[0] = true;
+	auto mark_code_payload = [&](uint32_t position) {
+		instruction& inst             = code[index_of(position - InstructionHeader)];
+		inst.code_payload             = true;
+		label[index_of(inst.payload)] = true;
+	};
+	for (const path_t& path : _paths) {
+		if (! std::get<4>(path)) {
+			mark_code_payload(std::get<0>(path));
+		}
+	}
+	for (const auto& [position, type] : _relocations) {
+		if (type == relocation::instruction) {
+			mark_code_payload(position);
+		}
+	}
+	std::vector<const container_data*> containers{_root};
+	while (! containers.empty()) {
+		const container_data* container = containers.back();
+		containers.pop_back();
+		std::size_t start       = index_of(container->offset);
+		container_start[start] = boundary[start] = true;
+		if (! container->name.empty()) {
+			label[start] = true;
+		}
+		containers.insert(containers.end(), container->children.begin(), container->children.end());
+	}
+	for (const auto& [offset, index] : _container_map) {
+		std::size_t i = index_of(offset);
+		label[i] = container_start[i] = boundary[i] = true;
+	}
+	for (std::size_t i = 0; i < size; ++i) {
+		if (code[i].command == Command::START_CONTAINER_MARKER
+		    || code[i].command == Command::END_CONTAINER_MARKER) {
+			boundary[i] = true;
+		}
+	}
 
-			firstParent = false;
+	// The runtime (runner_impl::jump) counts a container as entered at its start if the
+	//  position is at most one START_CONTAINER_MARKER (6 bytes) behind it. Instructions this close
+	//  to a container start are never moved or removed, so these distances stay the same
+	constexpr uint32_t ContainerMarkerSize = InstructionHeader + sizeof(uint32_t);
+	static_assert(ContainerMarkerSize == 6, "runtime expects START_CONTAINER_MARKER to be 6 bytes");
+	std::vector<bool> near_start(size + 1);
+	for (std::size_t i = 0; i < size; ++i) {
+		for (std::size_t j = i;
+		     container_start[i] && j < size && code[j].offset - code[i].offset <= ContainerMarkerSize;
+		     ++j) {
+			near_start[j] = true;
+		}
+	}
+
+	// number of boundaries before an instruction
+	std::vector<uint32_t> boundaries_before(size + 2);
+	for (std::size_t i = 0; i <= size; ++i) {
+		boundaries_before[i + 1] = boundaries_before[i] + boundary[i];
+	}
+
+	auto previous = [&code](std::size_t i) {
+		do {
+			if (i == 0) {
+				return None;
+			}
+		} while (code[--i].removed);
+		return i;
+	};
+	auto next = [&code, size](std::size_t i) {
+		do {
+			++i;
+		} while (i < size && code[i].removed);
+		return i;
+	};
+	// an instruction can be removed if nothing depends on its position and it is only reached by
+	//  continuing after the previous instruction
+	auto removable = [&](std::size_t i) {
+		std::size_t prev = previous(i);
+		return ! label[i] && ! near_start[i] && ! boundary[i] && prev != None
+		    && ! is_control(code[prev].command);
+	};
+
+	// Divert threading: a divert to an unconditional divert jumps to its target directly.
+	//  Both diverts must be in the same container and not at its start, so that the runtime enters
+	//  and visits the same containers.
+	auto same_container = [&](uint32_t from, uint32_t to) {
+		std::size_t a = index_of(from), b = index_of(to);
+		if (b == size || near_start[a] || near_start[b]) {
+			return false;
+		}
+		auto [low, high] = std::minmax(a, b);
+		return boundaries_before[high + 1] == boundaries_before[low];
+	};
+	constexpr int MaxChain = 16;
+	for (instruction& inst : code) {
+		if (inst.command != Command::DIVERT || inst.flag & CommandFlag::DIVERT_IS_FALLTHROUGH
+		    || ! inst.code_payload) {
+			continue;
+		}
+		uint32_t target = inst.payload;
+		for (int i = 0; i < MaxChain && index_of(target) < size; ++i) {
+			const instruction& jump = code[index_of(target)];
+			if (jump.command != Command::DIVERT || jump.flag != CommandFlag::NO_FLAGS
+			    || ! jump.code_payload || ! same_container(target, jump.payload)) {
+				break;
+			}
+			target = jump.payload;
+		}
+		inst.payload = target;
+	}
 
-			// Get the next token
-			token = ink::compiler::internal::strtok_s(nullptr, ".", &_context);
+	// Constant folding and redundant evaluation mode switches, tracks the evaluation mode through
+	//  instructions which are executed in sequence
+	enum class eval_mode {
+		unknown,
+		on,
+		off
+	} mode = eval_mode::unknown;
+	std::vector<std::size_t> constants;
+	for (std::size_t i = 0; i < size; ++i) {
+		instruction& inst = code[i];
+		if (inst.removed) {
+			continue;
+		}
+		if (label[i]) {
+			mode = eval_mode::unknown;
+			constants.clear();
 		}
 
-		if (noop_offset != ~0) {
-			inkAssert(! useCountIndex, "Can't count visits to a noop!");
-			_containers.set(position, noop_offset);
-		} else {
-			// If we want the count index, write that out
-			if (useCountIndex) {
-				inkAssert(container->counter_index != ~0, "No count index available for this container!");
-				_containers.set(position, container->counter_index);
-			} else {
-				// Otherwise, write container address
-				if (container == nullptr) {
-					_containers.set(position, 0);
-					inkAssert(optional, "Was not able to resolve a not optional path! '%hs'", path.c_str());
+		switch (inst.command) {
+			case Command::START_EVAL:
+			case Command::END_EVAL: {
+				bool        start   = inst.command == Command::START_EVAL;
+				eval_mode   entered = start ? eval_mode::on : eval_mode::off;
+				std::size_t j       = next(i);
+				constants.clear();
+				if (mode == entered && removable(i)) {
+					// already in this mode
+					inst.removed = true;
+				} else if (mode != eval_mode::unknown && j < size
+				           && code[j].command == (start ? Command::END_EVAL : Command::START_EVAL)
+				           && removable(i) && ! label[j] && ! near_start[j]) {
+					// switched back immediately
+					inst.removed = code[j].removed = true;
 				} else {
-					_containers.set(position, container->offset);
+					mode = entered;
+				}
+			} break;
+			case Command::INT:
+				if (mode == eval_mode::on) {
+					constants.push_back(i);
+				} else {
+					constants.clear();
+				}
+				break;
+			case Command::NEGATE: {
+				if (mode == eval_mode::on && ! constants.empty() && removable(i)) {
+					instruction& value = code[constants.back()];
+					if (static_cast<int32_t>(value.payload) != std::numeric_limits<int32_t>::min()) {
+						value.payload = static_cast<uint32_t>(-static_cast<int32_t>(value.payload));
+						inst.removed  = true;
+						break;
+					}
+				}
+				constants.clear();
+			} break;
+			case Command::ADD:
+			case Command::SUBTRACT:
+			case Command::MULTIPLY:
+			case Command::DIVIDE:
+			case Command::MOD: {
+				int32_t result;
+				if (mode == eval_mode::on && constants.size() >= 2 && removable(i)
+				    && removable(constants.back())
+				    && fold(
+				        inst.command, static_cast<int32_t>(code[constants[constants.size() - 2]].payload),
+				        static_cast<int32_t>(code[constants.back()].payload), result
+				    )) {
+					code[constants.back()].removed = inst.removed = true;
+					constants.pop_back();
+					code[constants.back()].payload = static_cast<uint32_t>(result);
+					break;
+				}
+				constants.clear();
+			} break;
+			default:
+				if (is_control(inst.command)) {
+					mode = eval_mode::unknown;
 				}
+				constants.clear();
+		}
+	}
+
+	// Unreachable code: instructions after a command which never continues with the next
+	//  instruction, up to the next position something jumps to
+	for (std::size_t i = 0; i < size; ++i) {
+		const instruction& inst = code[i];
+		if (inst.removed) {
+			continue;
+		}
+		bool ends = inst.command == Command::END || inst.command == Command::TUNNEL_RETURN
+		         || inst.command == Command::FUNCTION_RETURN;
+		if ((inst.command == Command::DIVERT || inst.command == Command::DIVERT_TO_VARIABLE)
+		    && inst.flag == CommandFlag::NO_FLAGS) {
+			// a thread returns after the divert following it
+			std::size_t prev = previous(i);
+			ends             = prev == None || code[prev].command != Command::THREAD;
+		}
+		if (! ends) {
+			continue;
+		}
+		std::size_t j = i + 1;
+		while (j < size && ! label[j] && ! near_start[j] && ! boundary[j]) {
+			++j;
+		}
+		// a divert to the following instruction is skipped by the runtime, which would not enter a
+		//  container starting there
+		if (j == i + 1
+		    || (inst.code_payload && index_of(inst.payload) == j && (near_start[j] || boundary[j]))) {
+			continue;
+		}
+		for (std::size_t k = i + 1; k < j; ++k) {
+			code[k].removed = true;
+		}
+		i = j - 1;
+	}
+
+	// Superinstructions: fuse common sequences into one instruction, if nothing jumps into them
+	for (std::size_t i = 0; i < size; ++i) {
+		instruction& inst = code[i];
+		if (inst.removed) {
+			continue;
+		}
+		std::size_t sequence[4] = {i};
+		for (std::size_t j = 1; j < 4; ++j) {
+			sequence[j] = sequence[j - 1] < size ? next(sequence[j - 1]) : size;
+		}
+		auto matches = [&](std::initializer_list<Command> commands) {
+			std::size_t j = 0;
+			for (Command command : commands) {
+				std::size_t k = sequence[j++];
+				if (k == size || code[k].command != command || (k != i && label[k])) {
+					return false;
+				}
+			}
+			return true;
+		};
+		auto fuse = [&](Command command, std::size_t length) {
+			inst.command = command;
+			for (std::size_t j = 1; j < length; ++j) {
+				code[sequence[j]].removed = true;
 			}
+			// i is skipped by the loop
+			i = sequence[length - 1];
+		};
+
+		if (matches({Command::STR, Command::NEWLINE})) {
+			fuse(Command::STR_NEWLINE, 2);
+		} else if (matches({Command::START_EVAL, Command::PUSH_VARIABLE_VALUE, Command::OUTPUT})) {
+			inst.payload_size = sizeof(uint32_t);
+			inst.payload      = code[sequence[1]].payload;
+			fuse(Command::OUTPUT_VARIABLE, 3);
+		} else if ((matches({Command::START_EVAL, Command::READ_COUNT, Command::END_EVAL, Command::DIVERT})
+		            || matches(
+		                {Command::START_EVAL, Command::PUSH_VARIABLE_VALUE, Command::END_EVAL,
+		                 Command::DIVERT}
+		            ))
+		           && code[sequence[3]].flag == CommandFlag::DIVERT_HAS_CONDITION
+		           && code[sequence[3]].code_payload) {
+			instruction& value  = code[sequence[1]];
+			instruction& divert = code[sequence[3]];
+			inst.flag           = divert.flag;
+			inst.payload_size   = 2 * sizeof(uint32_t);
+			inst.payload        = value.payload;
+			inst.target         = divert.payload;
+			value.fused_into = divert.fused_into = i;
+			divert.fused_position                = sizeof(uint32_t);
+			fuse(
+			    value.command == Command::READ_COUNT ? Command::DIVERT_IF_READ_COUNT
+			                                         : Command::DIVERT_IF_VARIABLE,
+			    4
+			);
+		}
+	}
+
+	// Write the remaining instructions and move everything pointing to them
+	std::vector<uint32_t> moved(size + 1);
+	uint32_t              position = 0;
+	for (std::size_t i = 0; i < size; ++i) {
+		moved[i] = position;
+		if (! code[i].removed) {
+			position += InstructionHeader + code[i].payload_size;
+		}
+	}
+	moved[size] = position;
+	auto move   = [&](uint32_t offset) { return moved[index_of(offset)]; };
+
+	binary_stream optimized;
+	for (const instruction& inst : code) {
+		if (inst.removed) {
+			continue;
+		}
+		optimized.write(inst.command);
+		optimized.write(inst.flag);
+		if (inst.payload_size > 0) {
+			optimized.write(inst.code_payload ? move(inst.payload) : inst.payload);
+		}
+		if (inst.payload_size > sizeof(uint32_t)) {
+			optimized.write(move(inst.target));
+		}
+	}
+	_containers.reset();
+	_containers.append(optimized);
+
+	// payloads of removed instructions are dropped, unless they were fused into another one
+	auto move_payload = [&](auto& position) {
+		const instruction& inst = code[index_of(position - InstructionHeader)];
+		if (inst.fused_into != None) {
+			position = moved[inst.fused_into] + InstructionHeader + inst.fused_position;
+			return false;
 		}
+		position = moved[index_of(inst.offset)] + InstructionHeader;
+		return inst.removed;
+	};
+	_paths.erase(
+	    std::remove_if(
+	        _paths.begin(), _paths.end(), [&](path_t& path) { return move_payload(std::get<0>(path)); }
+	    ),
+	    _paths.end()
+	);
+	_relocations.erase(
+	    std::remove_if(
+	        _relocations.begin(), _relocations.end(),
+	        [&](std::pair<uint32_t, relocation>& entry) { return move_payload(entry.first); }
+	    ),
+	    _relocations.end()
+	);
+
+	std::vector<container_data*> moving{_root};
+	while (! moving.empty()) {
+		container_data* container = moving.back();
+		moving.pop_back();
+		container->offset     = move(container->offset);
+		container->end_offset = move(container->end_offset);
+		for (auto& noop : container->noop_offsets) {
+			noop.second = move(noop.second);
+		}
+		moving.insert(moving.end(), container->children.begin(), container->children.end());
+	}
+	for (auto& entry : _container_map) {
+		entry.first = move(entry.first);
 	}
 }
 
-void binary_emitter::write_container_map(
-    std::ostream& out, const container_map& map, container_t num
-)
+void binary_emitter::write_container_map(binary_stream& out, const container_map& map)
 {
-	// Write out container count
-	out.write(reinterpret_cast<const char*>(&num), sizeof(container_t));
-
 	// Write out entries
 	for (const auto& pair : map) {
-		out.write(( const char* ) &pair.first, sizeof(uint32_t));
-		out.write(( const char* ) &pair.second, sizeof(uint32_t));
+		out.write(pair.first);
+		out.write(pair.second);
 	}
 }
 
-void binary_emitter::write_container_hash_map(std::ostream& out)
+void binary_emitter::write_container_hash_map(binary_stream& out)
 {
 	write_container_hash_map(out, "", _root);
 }
 
 void binary_emitter::write_container_hash_map(
-    std::ostream& out, const std::string& name, const container_data* context
+    binary_stream& out, const std::string& name, const container_data* context
 )
 {
 	for (auto child : context->named_children) {
 		// Get the child's name in the hierarchy
 		std::string child_name = name.empty() ? child.first : (name + "." + child.first);
 		hash_t      name_hash  = hash_string(child_name.c_str());
+		if (results() != nullptr) {
+			results()->container_names[name_hash] = child_name;
+		}
 		// Write out name hash and offset
-		out.write(( const char* ) &name_hash, sizeof(hash_t));
-		out.write(( const char* ) &child.second->offset, sizeof(uint32_t));
+		out.write(name_hash);
+		out.write(child.second->offset);
 
 		// Recurse
 		write_container_hash_map(out, child_name, child.second);
@@ -422,6 +1012,252 @@ void binary_emitter::write_container_hash_map(
 	}
 }
 
+std::unique_ptr<emitter> binary_emitter::create_fragment() const
+{
+	return std::make_unique<binary_emitter>();
+}
+
+void binary_emitter::append_fragment(
+    emitter& output, int index_in_parent, const std::string& name, container_t container_index_offset
+)
+{
+	inkAssert(_current != nullptr, "Fragments can only be appended inside a container!");
+	binary_emitter& fragment = static_cast<binary_emitter&>(output);
+
+	uint32_t instruction_offset = _containers.pos();
+	uint32_t string_offset      = _strings.pos();
+	uint32_t list_offset        = _list_count;
+
+	// Adjust payloads to their final position
+	for (const auto& [position, type] : fragment._relocations) {
+		uint32_t value = fragment._containers.read<uint32_t>(position);
+		switch (type) {
+			case relocation::container_index: value += container_index_offset; break;
+			case relocation::string: value += string_offset; break;
+			case relocation::list: value += list_offset; break;
+			case relocation::instruction: value += instruction_offset; break;
+		}
+		fragment._containers.set(position, value);
+		_relocations.push_back({position + instruction_offset, type});
+	}
+
+	// Append data
+	_containers.append(fragment._containers);
+	_strings.append(fragment._strings);
+	_lists.append(fragment._lists);
+	_list_count += fragment._list_count;
+
+	// Take over containers
+	container_data* root = fragment._root;
+	fragment._root       = nullptr;
+	fragment._current    = nullptr;
+	root->relocate(instruction_offset, container_index_offset);
+	_current->add_child(root, index_in_parent, name);
+
+	for (const auto& [offset, index] : fragment._container_map) {
+		_container_map.push_back({offset + instruction_offset, index + container_index_offset});
+	}
+
+	// Paths are resolved once all containers are known
+	for (path_t& path : fragment._paths) {
+		std::get<0>(path) += instruction_offset;
+		_paths.push_back(std::move(path));
+	}
+	fragment._paths.clear();
+}
+
+namespace
+{
+	template<typename T>
+	void save_value(std::ostream& out, const T& value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	T load_value(std::istream& in)
+	{
+		T value{};
+		in.read(reinterpret_cast<char*>(&value), sizeof(T));
+		return value;
+	}
+
+	void save_string(std::ostream& out, const string& value)
+	{
+		save_value<uint32_t>(out, value.size());
+		out.write(value.data(), value.size());
+	}
+
+	string load_string(std::istream& in)
+	{
+		string value(load_value<uint32_t>(in), '\0');
+		in.read(value.data(), value.size());
+		return value;
+	}
+
+	void save_stream(std::ostream& out, const binary_stream& data)
+	{
+		save_value<uint32_t>(out, data.pos());
+		data.write_to(out);
+	}
+
+	void load_stream(std::istream& in, binary_stream& data)
+	{
+		// read in chunks, a damaged size only reads till the end of the file
+		byte_t buffer[256];
+		for (uint32_t size = load_value<uint32_t>(in); size > 0 && in;) {
+			uint32_t len = std::min<uint32_t>(size, sizeof(buffer));
+			in.read(reinterpret_cast<char*>(buffer), len);
+			data.write(buffer, in.gcount());
+			size -= len;
+		}
+	}
+} // namespace
+
+void binary_emitter::save_fragment(std::ostream& out) const
+{
+	save_stream(out, _containers);
+	save_stream(out, _strings);
+	save_stream(out, _lists);
+	save_value<uint32_t>(out, _list_count);
+
+	save_value<uint32_t>(out, _relocations.size());
+	for (const auto& [position, type] : _relocations) {
+		save_value(out, position);
+		save_value(out, static_cast<uint8_t>(type));
+	}
+
+	save_value<uint32_t>(out, _container_map.size());
+	for (const auto& [offset, index] : _container_map) {
+		save_value(out, offset);
+		save_value(out, index);
+	}
+
+	// paths reference their context by the position of the container in the tree
+	std::map<const container_data*, uint32_t> ids;
+	save_container(out, _root, ids);
+
+	save_value<uint32_t>(out, _paths.size());
+	for (const path_t& path : _paths) {
+		using std::get;
+		save_value<uint32_t>(out, get<0>(path));
+		save_string(out, get<1>(path));
+		save_value<uint8_t>(out, get<2>(path));
+		save_value<uint32_t>(out, ids.at(get<3>(path)));
+		save_value<uint8_t>(out, get<4>(path));
+	}
+}
+
+void binary_emitter::save_container(
+    std::ostream& out, const container_data* container,
+    std::map<const container_data*, uint32_t>& ids
+) const
+{
+	uint32_t id = ids.size();
+	ids.insert({container, id});
+
+	save_value(out, container->offset);
+	save_value(out, container->end_offset);
+	save_value(out, container->counter_index);
+	save_value<int32_t>(out, container->index_in_parent);
+	save_string(out, container->name);
+
+	save_value<uint32_t>(out, container->noop_offsets.size());
+	for (const auto& [index, offset] : container->noop_offsets) {
+		save_value<int32_t>(out, index);
+		save_value(out, offset);
+	}
+
+	save_value<uint32_t>(out, container->children.size());
+	for (const container_data* child : container->children) {
+		save_container(out, child, ids);
+	}
+}
+
+bool binary_emitter::load_fragment(std::istream& in)
+{
+	inkAssert(_root == nullptr, "Fragments can only be loaded into an empty emitter!");
+	load_stream(in, _containers);
+	load_stream(in, _strings);
+	load_stream(in, _lists);
+	_list_count = load_value<uint32_t>(in);
+
+	// offsets from the file are patched and followed later, they must lie inside the fragment
+	const uint32_t size        = _containers.pos();
+	auto           is_position = [size](uint32_t position) {
+		return position <= size && size - position >= sizeof(uint32_t);
+	};
+
+	for (uint32_t count = load_value<uint32_t>(in); count > 0 && in; --count) {
+		uint32_t position = load_value<uint32_t>(in);
+		uint8_t  type     = load_value<uint8_t>(in);
+		if (type > static_cast<uint8_t>(relocation::instruction) || ! is_position(position)) {
+			return false;
+		}
+		_relocations.push_back({position, static_cast<relocation>(type)});
+	}
+
+	for (uint32_t count = load_value<uint32_t>(in); count > 0 && in; --count) {
+		uint32_t    offset = load_value<uint32_t>(in);
+		container_t index  = load_value<container_t>(in);
+		if (offset > size) {
+			return false;
+		}
+		_container_map.push_back({offset, index});
+	}
+
+	std::vector<container_data*> ids;
+	_root = load_container(in, ids);
+	for (const container_data* container : ids) {
+		if (container->offset > container->end_offset || container->end_offset > size) {
+			return false;
+		}
+		for (const auto& [index, offset] : container->noop_offsets) {
+			if (offset > size) {
+				return false;
+			}
+		}
+	}
+
+	for (uint32_t count = load_value<uint32_t>(in); count > 0 && in; --count) {
+		uint32_t position      = load_value<uint32_t>(in);
+		string   path          = load_string(in);
+		bool     optional      = load_value<uint8_t>(in);
+		uint32_t context       = load_value<uint32_t>(in);
+		bool     useCountIndex = load_value<uint8_t>(in);
+		if (context >= ids.size() || ! is_position(position)) {
+			return false;
+		}
+		_paths.push_back(std::make_tuple(position, path, optional, ids[context], useCountIndex));
+	}
+
+	return static_cast<bool>(in);
+}
+
+container_data* binary_emitter::load_container(std::istream& in, std::vector<container_data*>& ids)
+{
+	auto container = new container_data();
+	ids.push_back(container);
+
+	container->offset          = load_value<uint32_t>(in);
+	container->end_offset      = load_value<uint32_t>(in);
+	container->counter_index   = load_value<container_t>(in);
+	container->index_in_parent = load_value<int32_t>(in);
+	container->name            = load_string(in);
+
+	for (uint32_t count = load_value<uint32_t>(in); count > 0 && in; --count) {
+		int      index  = load_value<int32_t>(in);
+		uint32_t offset = load_value<uint32_t>(in);
+		container->noop_offsets.insert({index, offset});
+	}
+
+	for (uint32_t count = load_value<uint32_t>(in); count > 0 && in; --count) {
+		container_data* child = load_container(in, ids);
+		container->add_child(child, child->index_in_parent, child->name);
+	}
+	return container;
+}
+
 void binary_emitter::set_list_meta(const list_data& list_defs)
 {
 	if (list_defs.empty()) {
@@ -442,5 +1278,6 @@ void binary_emitter::set_list_meta(const list_data& list_defs)
 		_lists.write(reinterpret_cast<const byte_t*>(flag.name->c_str()), flag.name->size() + 1);
 	}
 	_lists.write(null_flag);
+	_list_meta_size = _lists.pos();
 }
 } // namespace ink::compiler::internal
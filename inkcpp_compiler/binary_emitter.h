@@ -9,6 +9,9 @@
 #include "emitter.h"
 #include "binary_stream.h"
 
+#include <map>
+#include <tuple>
+
 namespace ink::compiler::internal
 {
 	struct container_data;
@@ -34,6 +37,10 @@ namespace ink::compiler::internal
 		virtual void patch_fallthroughs(uint32_t position) override;
 		virtual void set_list_meta(const list_data& list_defs) override;
 		virtual void write_list(Command command, CommandFlag flag, const std::vector<list_flag>& entries) override;
+		virtual std::unique_ptr<emitter> create_fragment() const override;
+		virtual void append_fragment(emitter& fragment, int index_in_parent, const std::string& name, container_t container_index_offset) override;
+		virtual void save_fragment(std::ostream& out) const override;
+		virtual bool load_fragment(std::istream& in) override;
 		// End emitter
 
 		// write out the emitters data
@@ -45,10 +52,29 @@ namespace ink::compiler::internal
 		virtual void setContainerIndex(container_t index) override;
 
 	private:
+		// positon to write address
+		// path as string
+		// if path may not exists (used for function fallbackes)
+		// container data
+		// use count index?
+		typedef std::tuple<size_t, std::string, bool, container_data*, bool> path_t;
+
+		// payloads which depend on the position of the data in the final binary
+		enum class relocation {
+			container_index,
+			string,
+			list,
+			instruction,
+		};
+
+		void save_container(std::ostream& out, const container_data* container, std::map<const container_data*, uint32_t>& ids) const;
+		container_data* load_container(std::istream& in, std::vector<container_data*>& ids);
 		void process_paths();
-		void write_container_map(std::ostream&, const container_map&, container_t);
-		void write_container_hash_map(std::ostream&);
-		void write_container_hash_map(std::ostream&, const std::string&, const container_data*);
+		void resolve_path(const path_t& path);
+		void optimize();
+		void write_container_map(binary_stream&, const container_map&);
+		void write_container_hash_map(binary_stream&);
+		void write_container_hash_map(binary_stream&, const std::string&, const container_data*);
 
 	private:
 		container_data* _root;
@@ -57,14 +83,13 @@ namespace ink::compiler::internal
 
 		binary_stream _strings;
 		uint32_t _list_count = 0;
+		size_t _list_meta_size = 0;
 		binary_stream _lists;
 		binary_stream _containers;
 
-		// positon to write address
-		// path as string
-		// if path may not exists (used for function fallbackes)
-		// container data
-		// use count index?
-		std::vector<std::tuple<size_t, std::string, bool, container_data*, bool>> _paths;
+		std::vector<path_t> _paths;
+
+		// positions of payloads to adjust when appending this as fragment
+		std::vector<std::pair<uint32_t, relocation>> _relocations;
 	};
 }
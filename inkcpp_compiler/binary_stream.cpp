@@ -86,6 +86,19 @@ namespace ink
 				}
 			}
 
+			void binary_stream::append(const binary_stream& other)
+			{
+				for (byte_t* slab : other._slabs)
+				{
+					write(slab, DATA_SIZE);
+				}
+
+				if (other._currentSlab != nullptr)
+				{
+					write(other._currentSlab, other._ptr - other._currentSlab);
+				}
+			}
+
 			size_t binary_stream::pos() const
 			{
 				// If we have no data, we're at position 0
@@ -39,6 +39,9 @@ namespace ink
 				// Writes the data in the buffer into another stream
 				void write_to(std::ostream& out) const;
 
+				// Writes the data of another binary stream to the end of the stream
+				void append(const binary_stream& other);
+
 				// Gets the current position in memory of the write head
 				size_t pos() const;
 
@@ -57,6 +60,16 @@ namespace ink
 				// read a byte from stream
 				byte_t get(size_t offset) const;
 
+				// read an arbitrary type from stream
+				template<typename T>
+				T read(size_t offset) const
+				{
+					T value;
+					for (size_t i = 0; i < sizeof(T); ++i)
+						((byte_t*)&value)[i] = get(offset + i);
+					return value;
+				}
+
 			private:
 				// Size of a data slab. Whenever
 				//  a slab runs out of data,
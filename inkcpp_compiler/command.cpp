@@ -95,7 +95,12 @@ namespace ink
 			"START_CONTAINER",
 			"END_CONTAINER",
 
-			"CALL_EXTERNAL"
+			"CALL_EXTERNAL",
+
+			"inkcpp_STR_NEWLINE",
+			"inkcpp_OUTPUT_VARIABLE",
+			"inkcpp_DIVERT_IF_READ_COUNT",
+			"inkcpp_DIVERT_IF_VARIABLE"
 	};
 
 	template<unsigned A, unsigned B>
@@ -0,0 +1,97 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#include "compile_cache.h"
+
+#include "emitter.h"
+#include "version.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace ink::compiler::internal
+{
+namespace
+{
+	// change when the layout of cache files or the compiled fragments change
+	constexpr uint32_t CacheVersion = 1;
+	constexpr char     Magic[4]     = {'I', 'N', 'K', 'C'};
+} // namespace
+
+compile_cache::compile_cache(const std::string& directory)
+    : _directory(directory)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(_directory, ec);
+}
+
+uint64_t compile_cache::hash(std::string_view data, uint64_t seed)
+{
+	for (char c : data) {
+		seed ^= static_cast<unsigned char>(c);
+		seed *= 0x100000001b3ull;
+	}
+	return seed;
+}
+
+std::string compile_cache::filename(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.inkc", static_cast<unsigned long long>(key));
+	return (std::filesystem::path(_directory) / name).string();
+}
+
+bool compile_cache::load(uint64_t key, emitter& fragment, container_t& num_containers) const
+{
+	std::ifstream in(filename(key), std::ios::binary);
+	if (! in) {
+		return false;
+	}
+
+	char     magic[sizeof(Magic)];
+	uint32_t cache_version = 0, bin_version = 0;
+	uint64_t stored_key = 0;
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char*>(&cache_version), sizeof(cache_version));
+	in.read(reinterpret_cast<char*>(&bin_version), sizeof(bin_version));
+	in.read(reinterpret_cast<char*>(&stored_key), sizeof(stored_key));
+	in.read(reinterpret_cast<char*>(&num_containers), sizeof(num_containers));
+	if (! in || std::string_view(magic, sizeof(magic)) != std::string_view(Magic, sizeof(Magic))
+	    || cache_version != CacheVersion || bin_version != ink::InkBinVersion || stored_key != key) {
+		return false;
+	}
+	return fragment.load_fragment(in);
+}
+
+void compile_cache::store(uint64_t key, const emitter& fragment, container_t num_containers) const
+{
+	// write to a temporary file first, so concurrent compilations never read a partial file
+	std::string target    = filename(key);
+	std::string temporary = target + '.' + std::to_string(std::random_device{}()) + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary);
+		out.write(Magic, sizeof(Magic));
+		out.write(reinterpret_cast<const char*>(&CacheVersion), sizeof(CacheVersion));
+		out.write(reinterpret_cast<const char*>(&ink::InkBinVersion), sizeof(ink::InkBinVersion));
+		out.write(reinterpret_cast<const char*>(&key), sizeof(key));
+		out.write(reinterpret_cast<const char*>(&num_containers), sizeof(num_containers));
+		fragment.save_fragment(out);
+		if (! out) {
+			out.close();
+			std::remove(temporary.c_str());
+			return;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(temporary, target, ec);
+	if (ec) {
+		std::filesystem::remove(temporary, ec);
+	}
+}
+} // namespace ink::compiler::internal
@@ -0,0 +1,41 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#pragma once
+
+#include "system.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ink::compiler::internal
+{
+class emitter;
+
+// On disk cache of emitter fragments, keyed by a hash of everything the fragment depends on.
+//  Each fragment is stored in its own file, so multiple compilations can share a directory.
+class compile_cache
+{
+public:
+	explicit compile_cache(const std::string& directory);
+
+	// 64 bit FNV-1a, feed previous results as seed to hash multiple parts
+	static constexpr uint64_t Seed = 0xcbf29ce484222325ull;
+	static uint64_t           hash(std::string_view data, uint64_t seed = Seed);
+
+	// loads the fragment stored for key into a started fragment emitter, false if there is none
+	bool load(uint64_t key, emitter& fragment, container_t& num_containers) const;
+
+	// stores a fragment, failing to write is not an error, the fragment is just not cached
+	void store(uint64_t key, const emitter& fragment, container_t num_containers) const;
+
+private:
+	std::string filename(uint64_t key) const;
+
+	std::string _directory;
+};
+} // namespace ink::compiler::internal
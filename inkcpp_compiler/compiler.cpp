@@ -10,15 +10,48 @@
 #include "binary_emitter.h"
 
 #include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
 
 namespace ink::compiler
 {
-	void run(const nlohmann::json& src, std::ostream& out, compilation_results* results)
+	namespace
+	{
+		// compile json text directly, without building a json DOM first
+		void run(
+		    std::string_view src, std::ostream& out, compilation_results* results,
+		    const compilation_options& options
+		)
+		{
+			using namespace internal;
+
+			// Create compiler and emitter
+			json_compiler  compiler(options);
+			binary_emitter emitter;
+
+			// Compile into emitter
+			compiler.compile(src, &emitter, results);
+
+			// write emitter's results into the stream
+			emitter.output(out);
+		}
+
+		std::string read_all(std::istream& in)
+		{
+			return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		}
+	} // namespace
+
+	void run(
+	    const nlohmann::json& src, std::ostream& out, compilation_results* results,
+	    const compilation_options& options
+	)
 	{
 		using namespace internal;
 		
 		// Create compiler and emitter
-		json_compiler compiler;
+		json_compiler compiler(options);
 		binary_emitter emitter;
 
 		// Compile into emitter
@@ -28,67 +61,78 @@ namespace ink::compiler
 		emitter.output(out);
 	}
 
-	void run(const char* filenameIn, const char* filenameOut, compilation_results* results)
+	void run(
+	    const char* filenameIn, const char* filenameOut, compilation_results* results,
+	    const compilation_options& options
+	)
 	{
-		// Load JSON
-		nlohmann::json j;
-		std::ifstream fin(filenameIn);
-		fin >> j;
+		// Load JSON text
+		std::ifstream fin(filenameIn, std::ios::binary);
+		std::string   src = read_all(fin);
 
 		// Open output stream
 		std::ofstream fout(filenameOut, std::ios::binary | std::ios::out);
 
 		// Run compiler
-		ink::compiler::run(j, fout, results);
+		run(std::string_view(src), fout, results, options);
 
 		// Close file
 		fout.close();
 	}
 
-	void run(const char* filenameIn, std::ostream& out, compilation_results* results)
+	void run(
+	    const char* filenameIn, std::ostream& out, compilation_results* results,
+	    const compilation_options& options
+	)
 	{
-		// Load JSON
-		nlohmann::json j;
-		std::ifstream fin(filenameIn);
-		fin >> j;
+		// Load JSON text
+		std::ifstream fin(filenameIn, std::ios::binary);
+		std::string   src = read_all(fin);
 
 		// Run compiler
-		ink::compiler::run(j, out, results);
+		run(std::string_view(src), out, results, options);
 	}
 
-	void run(const nlohmann::json& j, const char* filenameOut, compilation_results* results)
+	void run(
+	    const nlohmann::json& j, const char* filenameOut, compilation_results* results,
+	    const compilation_options& options
+	)
 	{
 		// Open output stream
 		std::ofstream fout(filenameOut, std::ios::binary | std::ios::out);
 
 		// Run compiler
-		ink::compiler::run(j, fout, results);
+		ink::compiler::run(j, fout, results, options);
 
 		// Close file
 		fout.close();
 	}
 
-	void run(std::istream& in, std::ostream& out, compilation_results* results)
+	void run(
+	    std::istream& in, std::ostream& out, compilation_results* results,
+	    const compilation_options& options
+	)
 	{
-		// Load JSON
-		nlohmann::json j;
-		in >> j;
+		// Load JSON text
+		std::string src = read_all(in);
 
 		// Run compiler
-		ink::compiler::run(j, out, results);
+		run(std::string_view(src), out, results, options);
 	}
 
-	void run(std::istream& in, const char* filenameOut, compilation_results* results)
+	void run(
+	    std::istream& in, const char* filenameOut, compilation_results* results,
+	    const compilation_options& options
+	)
 	{
-		// Load JSON
-		nlohmann::json j;
-		in >> j;
+		// Load JSON text
+		std::string src = read_all(in);
 
 		// Open output stream
 		std::ofstream fout(filenameOut, std::ios::binary | std::ios::out);
 
 		// Run compiler
-		ink::compiler::run(j, fout, results);
+		run(std::string_view(src), fout, results, options);
 
 		// Close file
 		fout.close();
@@ -8,10 +8,14 @@
 
 namespace ink::compiler::internal
 {
-	void emitter::start(int ink_version, compilation_results* results)
+	void emitter::start(
+	    int ink_version, compilation_results* results, unsigned threads, unsigned optimization_level
+	)
 	{
 		// store
 		_ink_version = ink_version;
+		_threads = threads;
+		_optimization_level = optimization_level;
 		set_results(results);
 
 		// reset
@@ -9,6 +9,8 @@
 #include "command.h"
 #include "system.h"
 #include "reporter.h"
+#include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -23,7 +25,12 @@ namespace ink::compiler::internal
 		virtual ~emitter() { }
 
 		// starts up the emitter (and calls initialize)
-		void start(int ink_version, compilation_results* results = nullptr);
+		//  threads is the number of threads to use for post processing
+		//  optimization_level selects the optimizations applied while finalizing
+		void start(
+		    int ink_version, compilation_results* results = nullptr, unsigned threads = 1,
+		    unsigned optimization_level = 0
+		);
 
 		// tells the emitter compilation is done (and calls finalize)
 		void finish(container_t max_container_index);
@@ -73,6 +80,24 @@ namespace ink::compiler::internal
 		// add list definitions
 		virtual void set_list_meta(const list_data& lists_defs) = 0;
 
+		// creates an emitter to compile a child container independently of this one (e.g. on another
+		//  thread), it has to be started and is later added with append_fragment
+		virtual std::unique_ptr<emitter> create_fragment() const = 0;
+
+		// appends a fragment as child container of the current container, as if it was compiled here
+		//  container indices used by the fragment are offset by container_index_offset
+		virtual void append_fragment(
+		    emitter& fragment, int index_in_parent, const std::string& name,
+		    container_t container_index_offset
+		) = 0;
+
+		// writes a fragment which is not yet appended, to be reused by a later compilation
+		virtual void save_fragment(std::ostream& out) const = 0;
+
+		// reads a fragment written with save_fragment into a started fragment emitter
+		// @return false if the data is invalid
+		virtual bool load_fragment(std::istream& in) = 0;
+
 		// Helpers
 		template<typename T>
 		void write(Command command, const T& param, CommandFlag flag = CommandFlag::NO_FLAGS)
@@ -98,6 +123,12 @@ namespace ink::compiler::internal
 		container_map _container_map;
 		container_t _max_container_index;
 
+		// threads available for post processing
+		unsigned _threads = 1;
+
+		// optimizations to apply, see compilation_options::optimization_level
+		unsigned _optimization_level = 0;
+
 		// ink version
 		int _ink_version;
 	};
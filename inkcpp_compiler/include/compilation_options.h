@@ -0,0 +1,37 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#pragma once
+
+#include <string>
+
+namespace ink::compiler
+{
+/** settings for the compilation process */
+struct compilation_options {
+	/** number of threads used to compile knots and resolve paths.
+	 * 0 uses one thread per hardware thread.
+	 * The output is the same for any number of threads.
+	 */
+	unsigned threads = 1;
+
+	/** directory to cache compiled knots in, empty disables the cache.
+	 * Knots whose json did not change since a previous compilation are loaded from the cache
+	 * instead of being compiled again.
+	 */
+	std::string cache_directory;
+
+	/** optimization level of the generated bytecode.
+	 * 0 writes the bytecode as compiled, 1 folds integer constants, threads diverts to diverts,
+	 * drops redundant evaluation mode switches, removes instructions after diverts and ends which
+	 * nothing jumps to and fuses common instruction sequences (like conditional diverts) into
+	 * single instructions. Unreachable containers are kept.
+	 * Stories behave the same on every level, but snapshots can only be loaded into a story
+	 * compiled with the same level.
+	 */
+	unsigned optimization_level = 0;
+};
+} // namespace ink::compiler
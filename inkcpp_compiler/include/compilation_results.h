@@ -6,6 +6,8 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <vector>
 #include <string>
 
@@ -18,5 +20,11 @@ typedef std::vector<std::string> error_list;
 struct compilation_results {
 	error_list warnings; ///< list of all warnings generated
 	error_list errors;   ///< list of all errors generated
+
+	unsigned cache_hits   = 0; ///< knots loaded from compilation_options::cache_directory
+	unsigned cache_misses = 0; ///< knots compiled and stored in the cache
+
+	/** path (e.g. `knot.stitch`) of each named container, by the hash stored in the binary */
+	std::map<uint32_t, std::string> container_names;
 };
 } // namespace ink::compiler
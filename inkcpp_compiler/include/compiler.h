@@ -13,6 +13,7 @@
 #	endif
 #	include "../json.hpp"
 #endif
+#include "compilation_options.h"
 #include "compilation_results.h"
 #include <iostream>
 
@@ -22,23 +23,41 @@ namespace ink
 namespace compiler
 {
 	/** file -> file */
-	void run(const char* filenameIn, const char* filenameOut, compilation_results* results = nullptr);
+	void run(
+	    const char* filenameIn, const char* filenameOut, compilation_results* results = nullptr,
+	    const compilation_options& options = {}
+	);
 
 	/** file -> stream */
-	void run(const char* filenameIn, std::ostream& out, compilation_results* results = nullptr);
+	void run(
+	    const char* filenameIn, std::ostream& out, compilation_results* results = nullptr,
+	    const compilation_options& options = {}
+	);
 
 #ifdef INK_EXPOSE_JSON
 	/** JSON -> file */
-	void run(const nlohmann::json&, const char* filenameOut, compilation_results* results = nullptr);
+	void run(
+	    const nlohmann::json&, const char* filenameOut, compilation_results* results = nullptr,
+	    const compilation_options& options = {}
+	);
 
 	/** JSON -> stream */
-	void run(const nlohmann::json&, std::ostream& out, compilation_results* results = nullptr);
+	void run(
+	    const nlohmann::json&, std::ostream& out, compilation_results* results = nullptr,
+	    const compilation_options& options = {}
+	);
 #endif
 
 	/** stream -> stream */
-	void run(std::istream& in, std::ostream& out, compilation_results* results = nullptr);
+	void run(
+	    std::istream& in, std::ostream& out, compilation_results* results = nullptr,
+	    const compilation_options& options = {}
+	);
 
 	/** stream -> file */
-	void run(std::istream& in, const char* filenameOut, compilation_results* results = nullptr);
+	void run(
+	    std::istream& in, const char* filenameOut, compilation_results* results = nullptr,
+	    const compilation_options& options = {}
+	);
 } // namespace compiler
 } // namespace ink
@@ -7,10 +7,16 @@
 #include "json_compiler.h"
 
 #include "command.h"
+#include "compile_cache.h"
+#include "json_reader.h"
 #include "list_data.h"
+#include "parallel.h"
 #include "system.h"
 #include "version.h"
 
+#include <algorithm>
+#include <exception>
+#include <memory>
 #include <string_view>
 
 namespace ink::compiler::internal
@@ -18,53 +24,187 @@ namespace ink::compiler::internal
 using nlohmann::json;
 using std::vector;
 
-typedef std::tuple<json, std::string> defer_entry;
-
-json_compiler::json_compiler()
-    : _emitter(nullptr)
+json_compiler::json_compiler(const compilation_options& options)
+    : _options(options)
+    , _emitter(nullptr)
     , _next_container_index(0)
 {
 }
 
-void json_compiler::compile(
-    const nlohmann::json& input, emitter* output, compilation_results* results
+json_compiler::~json_compiler() {}
+
+void json_compiler::begin(
+    int ink_version, std::string_view list_defs, emitter* output, compilation_results* results
 )
 {
 	// Get the runtime version
-	_ink_version = input["inkVersion"];
+	_ink_version = ink_version;
+
+	// Compiled knots depend on the ink version and the list definitions
+	if (! _options.cache_directory.empty()) {
+		_cache      = std::make_unique<compile_cache>(_options.cache_directory);
+		_cache_seed = compile_cache::hash(list_defs, compile_cache::hash(std::to_string(ink_version)));
+	}
 
 	// Start the output
 	set_results(results);
 	_emitter = output;
 
 	// Initialize emitter
-	_emitter->start(_ink_version, results);
-
-	if (auto itr = input.find("listDefs"); itr != input.end()) {
-		compile_lists_definition(*itr);
-		_emitter->set_list_meta(_list_meta);
-	}
-	// Compile the root container
-	compile_container(input["root"], 0, 0);
+	_emitter->start(
+	    _ink_version, results, thread_count(_options.threads), _options.optimization_level
+	);
+}
 
+void json_compiler::end()
+{
 	// finalize
 	_emitter->finish(_next_container_index);
 
 	// Clear
+	_cache.reset();
 	_emitter              = nullptr;
 	_next_container_index = 0;
 	clear_results();
 }
 
-struct container_meta {
-	std::string         name;
-	container_t         indexToReturn        = ~0;
-	bool                recordInContainerMap = false;
-	vector<defer_entry> deferred;
-	CommandFlag         cmd_flags = CommandFlag::NO_FLAGS;
+void json_compiler::compile(
+    const nlohmann::json& input, emitter* output, compilation_results* results
+)
+{
+	auto list_defs = input.find("listDefs");
+	begin(
+	    input["inkVersion"], list_defs != input.end() ? list_defs->dump() : "", output, results
+	);
+
+	if (list_defs != input.end()) {
+		compile_lists_definition(*list_defs);
+		_emitter->set_list_meta(_list_meta);
+	}
+	// Compile the root container
+	compile_container(input["root"], 0, 0);
+
+	end();
+}
+
+void json_compiler::compile(std::string_view input, emitter* output, compilation_results* results)
+{
+	// root may be written before listDefs, so first locate both
+	std::string_view root, list_defs;
+	int              ink_version = 0;
+	json_reader      reader(input);
+	std::string      key;
+	reader.begin_object();
+	while (reader.next_key(key)) {
+		if (key == "inkVersion") {
+			ink_version = json_reader::to_int(reader.read_number());
+		} else if (key == "root") {
+			root = reader.skip();
+		} else if (key == "listDefs") {
+			list_defs = reader.skip();
+		} else {
+			reader.skip();
+		}
+	}
+	if (root.empty()) {
+		throw ink_exception("Missing root container!");
+	}
+
+	begin(ink_version, list_defs, output, results);
+
+	// list definitions are small, no need to stream them
+	//  list meta references the names, so the json must outlive the compilation
+	json list_defs_json;
+	if (! list_defs.empty()) {
+		list_defs_json = json::parse(list_defs.begin(), list_defs.end());
+		compile_lists_definition(list_defs_json);
+		_emitter->set_list_meta(_list_meta);
+	}
+	// Compile the root container
+	compile_container(root, 0, 0);
+
+	end();
+}
+
+// data of a container required to start and end it
+struct container_info {
+	std::string name;
+	container_t indexToReturn        = ~0;
+	bool        recordInContainerMap = false;
+	CommandFlag cmd_flags            = CommandFlag::NO_FLAGS;
+};
+
+// Node references the json of named children, which are compiled after the container content
+template<typename Node>
+struct container_meta : container_info {
+	vector<std::tuple<Node, std::string>> deferred;
+};
+
+// named child compiled into a detached emitter
+struct fragment {
+	std::unique_ptr<emitter> output;
+	compilation_results      results;
+	container_t              num_containers = 0;
+	std::exception_ptr       error;
 };
 
-void json_compiler::handle_container_metadata(const json& meta, container_meta& data, bool is_knot)
+namespace
+{
+	// access the json of a deferred child
+	const json& deref(const json* node) { return *node; }
+
+	std::string_view deref(std::string_view node) { return node; }
+
+	// hash the json of a deferred child
+	uint64_t hash(const json* node, uint64_t seed) { return compile_cache::hash(node->dump(), seed); }
+
+	uint64_t hash(std::string_view node, uint64_t seed) { return compile_cache::hash(node, seed); }
+} // namespace
+
+void json_compiler::handle_container_flags(int flags, container_info& data, bool is_knot)
+{
+	bool visits = false, turns = false, onlyFirst = false;
+
+	if ((flags & 0x1) > 0) // Should record visit counts
+	{
+		visits = true;
+	}
+	if ((flags & 0x2) > 0) // Should record turn counts
+	{
+		turns = true;
+	}
+	if ((flags & 0x4) > 0) // Only count when you enter the first subelement
+	{
+		onlyFirst = true;
+	}
+
+	if (visits || turns || is_knot) {
+		container_t myIndex = _next_container_index++;
+
+		// Make appropriate flags
+		data.cmd_flags = CommandFlag::NO_FLAGS;
+		if (visits)
+			data.cmd_flags |= CommandFlag::CONTAINER_MARKER_TRACK_VISITS;
+		if (turns)
+			data.cmd_flags |= CommandFlag::CONTAINER_MARKER_TRACK_TURNS;
+		if (onlyFirst)
+			data.cmd_flags |= CommandFlag::CONTAINER_MARKER_ONLY_FIRST;
+		if (is_knot)
+			data.cmd_flags |= CommandFlag::CONTAINER_MARKER_IS_KNOT;
+
+
+		data.indexToReturn = myIndex;
+
+		// if (!onlyFirst) // ????
+		{
+			data.recordInContainerMap = true;
+		}
+	}
+}
+
+void json_compiler::handle_container_metadata(
+    const json& meta, container_meta<const json*>& data, bool is_knot
+)
 {
 	if (meta.is_object()) {
 		for (auto& meta_iter : meta.items()) {
@@ -74,50 +214,12 @@ void json_compiler::handle_container_metadata(const json& meta, container_meta&
 			}
 			// Flags
 			else if (meta_iter.key() == "#f") {
-				int flags = meta_iter.value().get<int>();
-
-				bool visits = false, turns = false, onlyFirst = false;
-
-				if ((flags & 0x1) > 0) // Should record visit counts
-				{
-					visits = true;
-				}
-				if ((flags & 0x2) > 0) // Should record turn counts
-				{
-					turns = true;
-				}
-				if ((flags & 0x4) > 0) // Only count when you enter the first subelement
-				{
-					onlyFirst = true;
-				}
-
-				if (visits || turns || is_knot) {
-					container_t myIndex = _next_container_index++;
-
-					// Make appropriate flags
-					data.cmd_flags = CommandFlag::NO_FLAGS;
-					if (visits)
-						data.cmd_flags |= CommandFlag::CONTAINER_MARKER_TRACK_VISITS;
-					if (turns)
-						data.cmd_flags |= CommandFlag::CONTAINER_MARKER_TRACK_TURNS;
-					if (onlyFirst)
-						data.cmd_flags |= CommandFlag::CONTAINER_MARKER_ONLY_FIRST;
-					if (is_knot)
-						data.cmd_flags |= CommandFlag::CONTAINER_MARKER_IS_KNOT;
-
-
-					data.indexToReturn = myIndex;
-
-					// if (!onlyFirst) // ????
-					{
-						data.recordInContainerMap = true;
-					}
-				}
+				handle_container_flags(meta_iter.value().get<int>(), data, is_knot);
 			}
 			// Child container
 			else {
 				// Add to deferred compilation list
-				data.deferred.push_back(std::make_tuple(meta_iter.value(), meta_iter.key()));
+				data.deferred.push_back(std::make_tuple(&meta_iter.value(), meta_iter.key()));
 			}
 		}
 	} else if (is_knot) {
@@ -128,14 +230,44 @@ void json_compiler::handle_container_metadata(const json& meta, container_meta&
 	}
 }
 
-void json_compiler::compile_container(
-    const nlohmann::json& container, int index_in_parent, int depth,
-    const std::string& name_override
+void json_compiler::handle_container_metadata(
+    std::string_view meta, container_meta<std::string_view>& data, bool is_knot
 )
 {
-	// Grab metadata from the last object in this container
-	container_meta meta;
-	bool           is_knot = name_override != "" && index_in_parent == -1;
+	json_reader reader(meta);
+	if (reader.peek() == json_reader::type::object) {
+		std::string key;
+		reader.begin_object();
+		while (reader.next_key(key)) {
+			// Name
+			if (key == "#n") {
+				data.name = reader.read_string();
+			}
+			// Flags
+			else if (key == "#f") {
+				handle_container_flags(json_reader::to_int(reader.read_number()), data, is_knot);
+			}
+			// Child container
+			else {
+				// Add to deferred compilation list, only the text range is stored
+				data.deferred.push_back(std::make_tuple(reader.skip(), key));
+			}
+		}
+		// compile named children in the same order as the json DOM iterates them
+		std::stable_sort(data.deferred.begin(), data.deferred.end(), [](const auto& a, const auto& b) {
+			return std::get<1>(a) < std::get<1>(b);
+		});
+	} else if (is_knot) {
+		container_t myIndex       = _next_container_index++;
+		data.indexToReturn        = myIndex;
+		data.cmd_flags            = CommandFlag::CONTAINER_MARKER_IS_KNOT;
+		data.recordInContainerMap = true;
+	}
+}
+
+bool json_compiler::is_knot(int index_in_parent, const std::string& name_override) const
+{
+	bool is_knot = name_override != "" && index_in_parent == -1;
 	if (is_knot) {
 		// it is not a wave or choice
 		if (name_override.starts_with("c-") || name_override.starts_with("g-")) {
@@ -151,8 +283,13 @@ void json_compiler::compile_container(
 			is_knot = false;
 		}
 	}
-	handle_container_metadata(*container.rbegin(), meta, is_knot);
+	return is_knot;
+}
 
+void json_compiler::start_container(
+    const container_info& meta, int index_in_parent, const std::string& name_override
+)
+{
 	// tell the emitter we're beginning a new container
 	uint32_t position = _emitter->start_container(
 	    index_in_parent, name_override.empty() ? meta.name : name_override
@@ -164,6 +301,140 @@ void json_compiler::compile_container(
 	if (meta.recordInContainerMap) {
 		_emitter->add_start_to_container_map(position, meta.indexToReturn);
 	}
+}
+
+template<typename Node>
+void json_compiler::end_container(const container_meta<Node>& meta, int depth)
+{
+	if (meta.deferred.size() > 0) {
+		std::vector<size_t> divert_positions;
+
+		// Write empty divert to be patched later
+		uint32_t divert_position = _emitter->fallthrough_divert();
+		divert_positions.push_back(divert_position);
+
+		// Knots are independent of each other, compile them in parallel or load them from the cache
+		//  and append them in order
+		std::vector<fragment> fragments;
+		if (depth == 0
+		    && (_cache || (meta.deferred.size() > 1 && thread_count(_options.threads) > 1))) {
+			fragments = compile_fragments(meta.deferred, depth + 1);
+		}
+
+		// (2) Write deffered containers
+		for (size_t i = 0; i < meta.deferred.size(); ++i) {
+			const auto& [node, name] = meta.deferred[i];
+
+			// Add to named child list
+			if (fragments.empty()) {
+				compile_container(deref(node), -1, depth + 1, name);
+			} else {
+				append_fragment(fragments[i], name);
+			}
+
+			// Need a divert here
+			uint32_t pos = _emitter->fallthrough_divert();
+			divert_positions.push_back(pos);
+		}
+
+		// (3) Set divert positions
+		for (size_t offset : divert_positions)
+			_emitter->patch_fallthroughs(offset);
+	}
+
+	// End container
+	uint32_t end_position = _emitter->end_container();
+
+	// Write end container marker, End pointer should point to End command (form symetry with START
+	// command)
+	if (meta.indexToReturn != ~0)
+		_emitter->write(Command::END_CONTAINER_MARKER, meta.indexToReturn, meta.cmd_flags);
+
+	// Record end position in map
+	if (meta.recordInContainerMap)
+		_emitter->add_end_to_container_map(end_position, meta.indexToReturn);
+}
+
+template<typename Node>
+std::vector<fragment> json_compiler::compile_fragments(
+    const std::vector<std::tuple<Node, std::string>>& children, int depth
+)
+{
+	std::vector<fragment> fragments(children.size());
+	parallel_for(children.size(), thread_count(_options.threads), [&](size_t i) {
+		const auto& [node, name] = children[i];
+		fragment& child          = fragments[i];
+		try {
+			child.output = _emitter->create_fragment();
+			child.output->start(_ink_version, &child.results);
+
+			uint64_t key = 0;
+			if (_cache) {
+				key = hash(node, compile_cache::hash(name + '\0', _cache_seed));
+				if (_cache->load(key, *child.output, child.num_containers)) {
+					child.results.cache_hits = 1;
+					return;
+				}
+				// discard partially loaded data
+				child.output->start(_ink_version, &child.results);
+			}
+
+			// fresh compiler numbering containers from 0, they get offset when appended
+			json_compiler worker;
+			worker._list_meta   = _list_meta;
+			worker._ink_version = _ink_version;
+			worker._emitter     = child.output.get();
+			worker.set_results(&child.results);
+
+			worker.compile_container(deref(node), -1, depth, name);
+			child.num_containers = worker._next_container_index;
+
+			// fragments with diagnostics are not cached, so they are reported again
+			if (_cache) {
+				child.results.cache_misses = 1;
+				if (child.results.warnings.empty() && child.results.errors.empty()) {
+					_cache->store(key, *child.output, child.num_containers);
+				}
+			}
+		} catch (...) {
+			child.error = std::current_exception();
+		}
+	});
+	return fragments;
+}
+
+void json_compiler::append_fragment(fragment& child, const std::string& name)
+{
+	// report in the same order as a sequential compilation
+	append_results(child.results);
+	if (child.error) {
+		std::rethrow_exception(child.error);
+	}
+
+	_emitter->append_fragment(*child.output, -1, name, _next_container_index);
+	_next_container_index += child.num_containers;
+}
+
+void json_compiler::compile_string(const std::string& string, int index)
+{
+	if (string[0] == '^')
+		_emitter->write_string(Command::STR, CommandFlag::NO_FLAGS, string);
+	else if (string == "nop")
+		_emitter->handle_nop(index);
+	else
+		compile_command(string);
+}
+
+void json_compiler::compile_container(
+    const nlohmann::json& container, int index_in_parent, int depth,
+    const std::string& name_override
+)
+{
+	// Grab metadata from the last object in this container
+	container_meta<const json*> meta;
+	handle_container_metadata(*container.rbegin(), meta, is_knot(index_in_parent, name_override));
+
+	start_container(meta, index_in_parent, name_override);
 
 	// Now, we want to iterate children of this container, save the last
 	//  The last is the settings object handled above
@@ -179,15 +450,7 @@ void json_compiler::compile_container(
 
 		// Strings are either commands, nops, or raw strings
 		else if (iter->is_string()) {
-			// Get the string
-			std::string string = iter->get<std::string>();
-
-			if (string[0] == '^')
-				_emitter->write_string(Command::STR, CommandFlag::NO_FLAGS, string);
-			else if (string == "nop")
-				_emitter->handle_nop(index);
-			else
-				compile_command(string);
+			compile_string(iter->get<std::string>(), index);
 		}
 
 		// Numbers (floats and integers)
@@ -217,41 +480,70 @@ void json_compiler::compile_container(
 		}
 	}
 
-	if (meta.deferred.size() > 0) {
-		std::vector<size_t> divert_positions;
+	end_container(meta, depth);
+}
 
-		// Write empty divert to be patched later
-		uint32_t divert_position = _emitter->fallthrough_divert();
-		divert_positions.push_back(divert_position);
+void json_compiler::compile_container(
+    std::string_view container, int index_in_parent, int depth, const std::string& name_override
+)
+{
+	// Collect the members first, the metadata is the last one but required to start the container
+	std::vector<std::string_view> members;
+	json_reader                   reader(container);
+	reader.begin_array();
+	while (reader.has_next()) {
+		members.push_back(reader.skip());
+	}
+	if (members.empty()) {
+		throw ink_exception("Container without metadata!");
+	}
 
-		// (2) Write deffered containers
-		for (auto& t : meta.deferred) {
-			using std::get;
+	container_meta<std::string_view> meta;
+	handle_container_metadata(members.back(), meta, is_knot(index_in_parent, name_override));
+
+	start_container(meta, index_in_parent, name_override);
+
+	for (size_t index = 0; index + 1 < members.size(); ++index) {
+		json_reader member(members[index]);
+		switch (member.peek()) {
+			// Arrays are child containers. Recurse.
+			case json_reader::type::array:
+				compile_container(members[index], static_cast<int>(index), depth + 1);
+				break;
+
+			// Strings are either commands, nops, or raw strings
+			case json_reader::type::string:
+				compile_string(member.read_string(), static_cast<int>(index));
+				break;
+
+			// Numbers (floats and integers)
+			case json_reader::type::number: {
+				std::string_view number = member.read_number();
+				if (json_reader::is_float(number)) {
+					float value = json_reader::to_float(number);
+					_emitter->write(Command::FLOAT, value);
+				} else {
+					int value = json_reader::to_int(number);
+					_emitter->write(Command::INT, value);
+				}
+			} break;
 
-			// Add to named child list
-			compile_container(get<0>(t), -1, depth + 1, get<1>(t));
+			// Booleans
+			case json_reader::type::boolean: {
+				int value = member.read_bool() ? 1 : 0;
+				_emitter->write(Command::BOOL, value);
+			} break;
 
-			// Need a divert here
-			uint32_t pos = _emitter->fallthrough_divert();
-			divert_positions.push_back(pos);
-		}
+			// Complex commands, these are small so parsing them is cheap
+			case json_reader::type::object:
+				compile_complex_command(json::parse(members[index].begin(), members[index].end()));
+				break;
 
-		// (3) Set divert positions
-		for (size_t offset : divert_positions)
-			_emitter->patch_fallthroughs(offset);
+			default: throw ink_exception("Failed to container member!");
+		}
 	}
 
-	// End container
-	uint32_t end_position = _emitter->end_container();
-
-	// Write end container marker, End pointer should point to End command (form symetry with START
-	// command)
-	if (meta.indexToReturn != ~0)
-		_emitter->write(Command::END_CONTAINER_MARKER, meta.indexToReturn, meta.cmd_flags);
-
-	// Record end position in map
-	if (meta.recordInContainerMap)
-		_emitter->add_end_to_container_map(end_position, meta.indexToReturn);
+	end_container(meta, depth);
 }
 
 void json_compiler::compile_command(const std::string& command)
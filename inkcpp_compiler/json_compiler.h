@@ -7,34 +7,71 @@
 #pragma once
 #include "json.hpp"
 #include "system.h"
+#include "compilation_options.h"
 #include "compilation_results.h"
 #include "emitter.h"
 #include "reporter.h"
 #include "list_data.h"
 
+#include <memory>
+#include <string_view>
+#include <tuple>
 #include <vector>
 
 namespace ink::compiler::internal
 {
+struct container_info;
+template<typename Node>
 struct container_meta;
+struct fragment;
+class compile_cache;
 
 // Compiles ink json and outputs using a given emitter
 class json_compiler : public reporter
 {
 public:
 	// create new compiler
-	json_compiler();
+	json_compiler(const compilation_options& options = {});
+	~json_compiler();
 
 	// compile from json using an emitter
 	void
 	    compile(const nlohmann::json& input, emitter* output, compilation_results* results = nullptr);
 
+	// compile from json text using an emitter, without building a json DOM
+	//  containers are read directly from the text, named children are kept as text ranges
+	void compile(std::string_view input, emitter* output, compilation_results* results = nullptr);
+
 private: // == Compiler methods ==
-	void handle_container_metadata(const nlohmann::json& meta, container_meta& data, bool is_knot);
+	void begin(
+	    int ink_version, std::string_view list_defs, emitter* output, compilation_results* results
+	);
+	void end();
+
+	void handle_container_metadata(
+	    const nlohmann::json& meta, container_meta<const nlohmann::json*>& data, bool is_knot
+	);
+	void handle_container_metadata(
+	    std::string_view meta, container_meta<std::string_view>& data, bool is_knot
+	);
+	void handle_container_flags(int flags, container_info& data, bool is_knot);
 	void compile_container(
 	    const nlohmann::json& container, int index_in_parent, int depth,
 	    const std::string& name_override = ""
 	);
+	void compile_container(
+	    std::string_view container, int index_in_parent, int depth,
+	    const std::string& name_override = ""
+	);
+	bool is_knot(int index_in_parent, const std::string& name_override) const;
+	void start_container(const container_info& meta, int index_in_parent, const std::string& name);
+	template<typename Node>
+	void end_container(const container_meta<Node>& meta, int depth);
+	template<typename Node>
+	std::vector<fragment>
+	    compile_fragments(const std::vector<std::tuple<Node, std::string>>& children, int depth);
+	void append_fragment(fragment& child, const std::string& name);
+	void compile_string(const std::string& string, int index);
 	void compile_command(const std::string& command);
 	void compile_complex_command(const nlohmann::json& command);
 	void compile_lists_definition(const nlohmann::json& list_defs);
@@ -57,6 +94,10 @@ private: // == JSON Helpers ==
 	}
 
 private: // == Private members ==
+	compilation_options            _options;
+	std::unique_ptr<compile_cache> _cache;
+	uint64_t                       _cache_seed = 0;
+
 	emitter*    _emitter;
 	container_t _next_container_index;
 
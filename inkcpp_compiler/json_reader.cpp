@@ -0,0 +1,292 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#include "json_reader.h"
+
+#include "system.h"
+
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+
+namespace ink::compiler::internal
+{
+json_reader::json_reader(std::string_view data)
+    : _data(data)
+    , _pos(0)
+{
+	// skip UTF-8 byte order mark
+	if (_data.substr(0, 3) == "\xEF\xBB\xBF") {
+		_pos = 3;
+	}
+}
+
+char json_reader::peek_char()
+{
+	while (_pos < _data.size()) {
+		char c = _data[_pos];
+		if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+			return c;
+		}
+		++_pos;
+	}
+	fail("unexpected end of input");
+}
+
+void json_reader::expect(char c)
+{
+	if (peek_char() != c) {
+		fail("unexpected character");
+	}
+	++_pos;
+}
+
+void json_reader::fail(const char* msg) const
+{
+	throw ink_exception(
+	    std::string("JSON parse error at byte ") + std::to_string(_pos) + ": " + msg
+	);
+}
+
+json_reader::type json_reader::peek()
+{
+	switch (peek_char()) {
+		case 'n': return type::null;
+		case 't':
+		case 'f': return type::boolean;
+		case '"': return type::string;
+		case '[': return type::array;
+		case '{': return type::object;
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9': return type::number;
+		default: fail("unexpected character");
+	}
+}
+
+void json_reader::skip_literal(const char* literal)
+{
+	size_t len = strlen(literal);
+	if (_data.substr(_pos, len) != literal) {
+		fail("invalid literal");
+	}
+	_pos += len;
+}
+
+void json_reader::skip_string()
+{
+	expect('"');
+	while (_pos < _data.size()) {
+		char c = _data[_pos++];
+		if (c == '\\') {
+			++_pos;
+		} else if (c == '"') {
+			return;
+		}
+	}
+	fail("unterminated string");
+}
+
+std::string_view json_reader::skip()
+{
+	peek_char();
+	size_t start = _pos;
+	switch (peek()) {
+		case type::null: skip_literal("null"); break;
+		case type::boolean: read_bool(); break;
+		case type::number: read_number(); break;
+		case type::string: skip_string(); break;
+		case type::array:
+		case type::object: {
+			// skip nested containers by counting brackets, strings may contain brackets
+			int depth = 0;
+			do {
+				char c = peek_char();
+				if (c == '"') {
+					skip_string();
+					continue;
+				}
+				if (c == '[' || c == '{') {
+					++depth;
+				} else if (c == ']' || c == '}') {
+					--depth;
+				}
+				++_pos;
+			} while (depth > 0);
+		} break;
+	}
+	return _data.substr(start, _pos - start);
+}
+
+std::string json_reader::read_string()
+{
+	expect('"');
+	std::string result;
+	while (true) {
+		if (_pos >= _data.size()) {
+			fail("unterminated string");
+		}
+		char c = _data[_pos++];
+		if (c == '"') {
+			return result;
+		}
+		if (c != '\\') {
+			result += c;
+			continue;
+		}
+		if (_pos >= _data.size()) {
+			fail("unterminated string");
+		}
+		switch (c = _data[_pos++]) {
+			case '"':
+			case '\\':
+			case '/': result += c; break;
+			case 'b': result += '\b'; break;
+			case 'f': result += '\f'; break;
+			case 'n': result += '\n'; break;
+			case 'r': result += '\r'; break;
+			case 't': result += '\t'; break;
+			case 'u': {
+				auto read_hex = [this]() {
+					if (_pos + 4 > _data.size()) {
+						fail("invalid unicode escape");
+					}
+					unsigned int value = 0;
+					for (int i = 0; i < 4; ++i) {
+						char h = _data[_pos++];
+						value <<= 4;
+						if (h >= '0' && h <= '9') {
+							value |= h - '0';
+						} else if (h >= 'a' && h <= 'f') {
+							value |= h - 'a' + 10;
+						} else if (h >= 'A' && h <= 'F') {
+							value |= h - 'A' + 10;
+						} else {
+							fail("invalid unicode escape");
+						}
+					}
+					return value;
+				};
+				unsigned int code = read_hex();
+				// combine surrogate pairs
+				if (code >= 0xD800 && code <= 0xDBFF) {
+					if (_data.substr(_pos, 2) != "\\u") {
+						fail("missing low surrogate");
+					}
+					_pos += 2;
+					unsigned int low = read_hex();
+					if (low < 0xDC00 || low > 0xDFFF) {
+						fail("invalid low surrogate");
+					}
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				}
+				// encode as UTF-8
+				if (code < 0x80) {
+					result += static_cast<char>(code);
+				} else if (code < 0x800) {
+					result += static_cast<char>(0xC0 | (code >> 6));
+					result += static_cast<char>(0x80 | (code & 0x3F));
+				} else if (code < 0x10000) {
+					result += static_cast<char>(0xE0 | (code >> 12));
+					result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					result += static_cast<char>(0x80 | (code & 0x3F));
+				} else {
+					result += static_cast<char>(0xF0 | (code >> 18));
+					result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+					result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					result += static_cast<char>(0x80 | (code & 0x3F));
+				}
+			} break;
+			default: fail("invalid escape sequence");
+		}
+	}
+}
+
+bool json_reader::read_bool()
+{
+	if (peek_char() == 't') {
+		skip_literal("true");
+		return true;
+	}
+	skip_literal("false");
+	return false;
+}
+
+void json_reader::read_null() { skip_literal("null"); }
+
+std::string_view json_reader::read_number()
+{
+	peek_char();
+	size_t start = _pos;
+	while (_pos < _data.size()) {
+		char c = _data[_pos];
+		if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E') {
+			break;
+		}
+		++_pos;
+	}
+	return _data.substr(start, _pos - start);
+}
+
+bool json_reader::is_float(std::string_view number)
+{
+	return number.find_first_of(".eE") != std::string_view::npos;
+}
+
+int json_reader::to_int(std::string_view number)
+{
+	return static_cast<int>(std::strtoll(std::string(number).c_str(), nullptr, 10));
+}
+
+float json_reader::to_float(std::string_view number)
+{
+	// strtod respects the locale decimal point, like nlohmann::json does
+	std::string text(number);
+	char        decimal_point = *std::localeconv()->decimal_point;
+	for (char& c : text) {
+		if (c == '.') {
+			c = decimal_point;
+		}
+	}
+	return static_cast<float>(std::strtod(text.c_str(), nullptr));
+}
+
+void json_reader::begin_array() { expect('['); }
+
+void json_reader::begin_object() { expect('{'); }
+
+bool json_reader::has_next()
+{
+	char c = peek_char();
+	if (c == ',') {
+		++_pos;
+		c = peek_char();
+	}
+	if (c == ']' || c == '}') {
+		++_pos;
+		return false;
+	}
+	return true;
+}
+
+bool json_reader::next_key(std::string& key)
+{
+	if (! has_next()) {
+		return false;
+	}
+	key = read_string();
+	expect(':');
+	return true;
+}
+} // namespace ink::compiler::internal
@@ -0,0 +1,68 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace ink::compiler::internal
+{
+// Minimal pull reader over a JSON document held in memory.
+//  Values are never materialized as a tree, instead they are read directly or skipped, in which
+//  case their text is returned so they can be read later by constructing a new reader on it.
+class json_reader
+{
+public:
+	enum class type {
+		null,
+		boolean,
+		number,
+		string,
+		array,
+		object,
+	};
+
+	explicit json_reader(std::string_view data);
+
+	// type of the next value
+	type peek();
+
+	// skips the next value and returns its text
+	std::string_view skip();
+
+	// read scalar values
+	std::string read_string();
+	bool        read_bool();
+	void        read_null();
+	// text of a number, use is_float/to_int/to_float to interpret it
+	std::string_view read_number();
+
+	static bool  is_float(std::string_view number);
+	static int   to_int(std::string_view number);
+	static float to_float(std::string_view number);
+
+	// Iterate arrays and objects:
+	//   r.begin_array(); while(r.has_next()) { /* read value */ }
+	//   r.begin_object(); while(r.next_key(key)) { /* read value */ }
+	void begin_array();
+	void begin_object();
+	// false if the current array or object is closed
+	bool has_next();
+	// reads the key of the next object member, false if the object is closed
+	bool next_key(std::string& key);
+
+private:
+	char              peek_char();
+	void              expect(char c);
+	void              skip_literal(const char* literal);
+	void              skip_string();
+	[[noreturn]] void fail(const char* msg) const;
+
+	std::string_view _data;
+	size_t           _pos;
+};
+} // namespace ink::compiler::internal
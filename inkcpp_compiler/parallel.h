@@ -0,0 +1,58 @@
+/* Copyright (c) 2024 Julian Benda
+ *
+ * This file is part of inkCPP which is released under MIT license.
+ * See file LICENSE.txt or go to
+ * https://github.com/JBenda/inkcpp for full license details.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace ink::compiler::internal
+{
+// number of threads to use, 0 selects the number of hardware threads
+inline unsigned thread_count(unsigned requested)
+{
+	if (requested == 0) {
+		requested = std::thread::hardware_concurrency();
+	}
+	return requested == 0 ? 1 : requested;
+}
+
+// Calls fn(index) for each index in [0, count) on up to threads threads, the calling thread
+//  included. If calls throw, the exception of the lowest index is rethrown after all finished.
+template<typename Fn>
+void parallel_for(std::size_t count, unsigned threads, Fn&& fn)
+{
+	std::vector<std::exception_ptr> errors(count);
+	std::atomic<std::size_t>        next{0};
+	auto work = [&]() {
+		for (std::size_t i = next++; i < count; i = next++) {
+			try {
+				fn(i);
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (std::size_t i = 1; i < std::min<std::size_t>(threads, count); ++i) {
+		pool.emplace_back(work);
+	}
+	work();
+	for (std::thread& thread : pool) {
+		thread.join();
+	}
+
+	for (std::exception_ptr& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+} // namespace ink::compiler::internal
@@ -28,6 +28,17 @@ namespace ink::compiler::internal
 		_results = nullptr;
 	}
 
+	void reporter::append_results(const compilation_results& results)
+	{
+		if (_results != nullptr)
+		{
+			_results->warnings.insert(_results->warnings.end(), results.warnings.begin(), results.warnings.end());
+			_results->errors.insert(_results->errors.end(), results.errors.begin(), results.errors.end());
+			_results->cache_hits += results.cache_hits;
+			_results->cache_misses += results.cache_misses;
+		}
+	}
+
 	std::ostream& reporter::warn()
 	{
 		// setp warning buffer
@@ -39,6 +39,12 @@ namespace ink::compiler::internal
 		// clears the results pointer
 		void clear_results();
 
+		// adds warnings, errors and cache statistics collected elsewhere
+		void append_results(const compilation_results&);
+
+		// results to fill, nullptr if not set
+		compilation_results* results() const { return _results; }
+
 		// report warning
 		std::ostream& warn();
 
@@ -225,9 +225,13 @@ If you want convert it to a string use: `str(value)`.)"
 	    );
 	m.def(
 	    "compile_json",
-	    [](const char* input_file_name, const char* output_file_name) {
+	    [](const char* input_file_name, const char* output_file_name, const char* cache_directory) {
 		    ink::compiler::compilation_results results;
-		    ink::compiler::run(input_file_name, output_file_name, &results);
+		    ink::compiler::compilation_options options;
+		    if (cache_directory != nullptr) {
+			    options.cache_directory = cache_directory;
+		    }
+		    ink::compiler::run(input_file_name, output_file_name, &results, options);
 		    if (! results.errors.empty()) {
 			    std::string str;
 			    for (auto& error : results.errors) {
@@ -238,7 +242,9 @@ If you want convert it to a string use: `str(value)`.)"
 		    }
 	    },
 	    py::arg("input_file_name").none(false), py::arg("output_file_name").none(false),
-	    "Converts a story.json file to a story.bin file used by inkcpp"
+	    py::arg("cache_directory") = py::none(),
+	    "Converts a story.json file to a story.bin file used by inkcpp. Knots are cached in "
+	    "cache_directory if given, unchanged knots are loaded from there by later calls"
 	);
 	py::class_<choice>(m, "Choice")
 	    .def("text", &choice::text, "Get choice printable content")
@@ -264,7 +270,7 @@ If you want convert it to a string use: `str(value)`.)"
 	    m, "Globals", "Global variable store. Use `globals[var_name]` to read/write them."
 	)
 	    .def(
-	        "create_snapshot", &globals::create_snapshot,
+	        "create_snapshot", py::overload_cast<>(&globals::create_snapshot, py::const_),
 	        "Creates a snapshot from the current state for later usage"
 	    )
 	    .def(
@@ -304,7 +310,7 @@ Args:
 	    });
 	py::class_<runner, runner_ptr>(m, "Runner", "Runtime logic for a story.")
 	    .def(
-	        "create_snapshot", &runner::create_snapshot,
+	        "create_snapshot", py::overload_cast<>(&runner::create_snapshot, py::const_),
 	        R"(Creates a snapshot from the current state for later usage.
 
 This snapshot will also contain the global state.
@@ -0,0 +1,153 @@
+#include "catch.hpp"
+
+#include <story.h>
+#include <runner.h>
+#include <globals.h>
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ink::runtime;
+
+namespace
+{
+#ifdef __cpp_impl_coroutine
+// coroutine which starts directly and is destroyed at its end
+struct task {
+	struct promise_type {
+		task get_return_object() { return {}; }
+
+		std::suspend_never initial_suspend() { return {}; }
+
+		std::suspend_never final_suspend() noexcept { return {}; }
+
+		void return_void() {}
+
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+task play(runner thread, std::string& text)
+{
+	while (thread->can_continue()) {
+		text += co_await thread->next_line();
+	}
+}
+#endif
+} // namespace
+
+SCENARIO("asynchronous external functions", "[external]")
+{
+	GIVEN("a story calling asynchronous functions")
+	{
+		std::unique_ptr<story>   ink{story::from_file(INK_TEST_RESOURCE_DIR "ExternalLookupStory.bin")};
+		runner                   thread = ink->new_runner();
+		std::vector<int>         numbers;
+		std::vector<std::string> names;
+		thread->bind_async("lookup", [&numbers](int number) { numbers.push_back(number); });
+		thread->bind_async("lookup_name", [&names](const char* name) { names.push_back(name); });
+
+		WHEN("the lines are read")
+		{
+			std::string before = thread->getline();
+			THEN("the function is not called by the lookahead")
+			{
+				REQUIRE(before == "Before\n");
+				REQUIRE(numbers.empty());
+				REQUIRE(thread->can_continue());
+			}
+			std::string waiting = thread->getline();
+			THEN("the runner waits at the call")
+			{
+				REQUIRE(waiting == "");
+				REQUIRE(numbers == std::vector<int>{3});
+				REQUIRE(thread->awaiting_external());
+				REQUIRE_FALSE(thread->can_continue());
+				REQUIRE(thread->getline() == "");
+				REQUIRE(numbers.size() == 1);
+			}
+			WHEN("the results are passed")
+			{
+				thread->resume_external(value(7));
+				REQUIRE(thread->getline() == "");
+				REQUIRE(names == std::vector<std::string>{"a"});
+				{
+					std::string result = "alpha";
+					thread->resume_external(value(result.c_str()));
+				}
+				REQUIRE_FALSE(thread->awaiting_external());
+				std::string line = thread->getline();
+				THEN("the line continues")
+				{
+					REQUIRE(line == "Result: 7 and alpha\n");
+					REQUIRE(thread->num_tags() == 1);
+					REQUIRE(std::string(thread->get_tag(0)) == "tagged");
+					REQUIRE(thread->getall() == "After\n");
+				}
+			}
+		}
+		WHEN("reading everything")
+		{
+			std::string text = thread->getall();
+			THEN("getall stops at the call")
+			{
+				REQUIRE(text == "Before\n");
+				REQUIRE(thread->awaiting_external());
+				thread->resume_external(value(1));
+				REQUIRE(thread->getall() == "");
+				thread->resume_external(value("b"));
+				REQUIRE(thread->getall() == "Result: 1 and b\nAfter\n");
+			}
+		}
+#ifdef __cpp_impl_coroutine
+		WHEN("played from a coroutine")
+		{
+			std::string text;
+			play(thread, text);
+			REQUIRE(text == "Before\n");
+			thread->resume_external(value(2));
+			REQUIRE(text == "Before\n");
+			thread->resume_external(value("c"));
+			THEN("the coroutine continues when the line is complete")
+			{
+				REQUIRE(text == "Before\nResult: 2 and c\nAfter\n");
+			}
+		}
+#endif
+	}
+}
+
+SCENARIO("benchmark runners waiting for external functions", "[.][benchmark]")
+{
+	std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "ExternalLookupStory.bin")};
+	BENCHMARK("1000 runners on one thread")
+	{
+		std::vector<runner> threads;
+		std::vector<runner> waiting;
+		for (int i = 0; i < 1000; ++i) {
+			threads.push_back(ink->new_runner());
+			threads.back()->bind_async("lookup", [](int) {});
+			threads.back()->bind_async("lookup_name", [](const char*) {});
+		}
+		size_t lines = 0;
+		while (! threads.empty()) {
+			for (runner& thread : threads) {
+				while (thread->can_continue()) {
+					lines += ! thread->getline().empty();
+				}
+				if (thread->awaiting_external()) {
+					waiting.push_back(thread);
+				}
+			}
+			// the external lookups finish
+			for (runner& thread : waiting) {
+				thread->resume_external(value(1));
+			}
+			threads.swap(waiting);
+			waiting.clear();
+		}
+		return lines;
+	};
+}
@@ -0,0 +1,112 @@
+#include "catch.hpp"
+
+#include <story.h>
+#include <runner.h>
+#include <choice.h>
+#include <header.h>
+#include <version.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+using namespace ink::runtime;
+using ink::internal::header;
+
+namespace
+{
+std::vector<unsigned char> read_file(const char* filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	return std::vector<unsigned char>(
+	    std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()
+	);
+}
+
+// rebuild a file in the layout used before the section directory existed
+std::vector<unsigned char> to_legacy(const std::vector<unsigned char>& data)
+{
+	header h = header::parse_header(reinterpret_cast<const char*>(data.data()));
+
+	std::vector<unsigned char> res(data.begin(), data.begin() + header::Size);
+	uint32_t                   version = 1;
+	memcpy(res.data() + sizeof(uint16_t) + sizeof(uint32_t), &version, sizeof(uint32_t));
+
+	auto append = [&](header::section s) {
+		const header::section_entry& entry = h.get(s);
+		res.insert(
+		    res.end(), data.begin() + entry.offset, data.begin() + entry.offset + entry.size
+		);
+	};
+	append(header::section::strings);
+	append(header::section::list_meta);
+	append(header::section::lists);
+	const unsigned char* num = reinterpret_cast<const unsigned char*>(&h.num_containers);
+	res.insert(res.end(), num, num + sizeof(uint32_t));
+	append(header::section::container_map);
+	append(header::section::container_hash);
+	append(header::section::instructions);
+	return res;
+}
+} // namespace
+
+SCENARIO("story binary contains a section directory", "[binary]")
+{
+	GIVEN("a compiled story with lists")
+	{
+		std::vector<unsigned char> data = read_file(INK_TEST_RESOURCE_DIR "ListStory.bin");
+		header h = header::parse_header(reinterpret_cast<const char*>(data.data()));
+
+		THEN("it is written with the current version")
+		{
+			REQUIRE(h.ink_bin_version_number == ink::InkBinVersion);
+			REQUIRE(h.has_directory());
+		}
+		THEN("sections are ordered and inside the file")
+		{
+			uint32_t end = header::Size + header::DirectorySize;
+			for (const header::section_entry& entry : h.sections) {
+				REQUIRE(entry.offset >= end);
+				end = entry.offset + entry.size;
+			}
+			REQUIRE(end == data.size());
+			REQUIRE(h.get(header::section::list_meta).size > 0);
+			REQUIRE(h.get(header::section::container_map).offset % sizeof(uint32_t) == 0);
+			REQUIRE(h.get(header::section::container_hash).offset % sizeof(uint32_t) == 0);
+			REQUIRE(
+			    h.get(header::section::container_hash).size
+			    == (h.container_hash_size * 2 + 1) * sizeof(uint32_t)
+			);
+		}
+	}
+}
+
+SCENARIO("story binaries without section directory can still be loaded", "[binary]")
+{
+	GIVEN("the same story in the current and the legacy format")
+	{
+		std::vector<unsigned char> data   = read_file(INK_TEST_RESOURCE_DIR "ListStory.bin");
+		std::vector<unsigned char> legacy = to_legacy(data);
+		std::unique_ptr<story> ink{story::from_binary(data.data(), data.size(), false)};
+		std::unique_ptr<story> old_ink{story::from_binary(legacy.data(), legacy.size(), false)};
+		runner                 thread     = ink->new_runner();
+		runner                 old_thread = old_ink->new_runner();
+
+		WHEN("run both")
+		{
+			std::string out     = thread->getall();
+			std::string old_out = old_thread->getall();
+			THEN("they produce the same output")
+			{
+				REQUIRE(out == "cat, snake\n");
+				REQUIRE(old_out == out);
+				REQUIRE(old_thread->num_choices() == thread->num_choices());
+				REQUIRE(
+				    std::string(old_thread->get_choice(0)->text()) == thread->get_choice(0)->text()
+				);
+			}
+		}
+	}
+}
@@ -0,0 +1,140 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#include <compiler.h>
+#include <story.h>
+#include <globals.h>
+#include <runner.h>
+#include <snapshot.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace ink::runtime;
+
+namespace
+{
+std::string turn(runner& thread)
+{
+	thread->choose(0);
+	return thread->getall();
+}
+
+// loads the snapshot from a copy of its data, like a snapshot read from a file
+std::unique_ptr<snapshot> reload(const snapshot& snap)
+{
+	unsigned char* data = new unsigned char[snap.get_data_len()];
+	memcpy(data, snap.get_data(), snap.get_data_len());
+	return std::unique_ptr<snapshot>{snapshot::from_binary(data, snap.get_data_len())};
+}
+} // namespace
+
+SCENARIO("compact snapshots", "[snapshot]")
+{
+	GIVEN("a story with many unvisited containers after some turns")
+	{
+		std::string            json   = fixture::add_knots(fixture::read("TurnStory.ink.json"), 1000);
+		std::string            binary = fixture::compile(json);
+		std::unique_ptr<story> ink    = fixture::load(binary);
+		runner                 thread = ink->new_runner();
+		thread->getall();
+		turn(thread);
+		REQUIRE(turn(thread) == "turn 2\n");
+		std::unique_ptr<snapshot> standard{thread->create_snapshot()};
+		std::unique_ptr<snapshot> compact{thread->create_snapshot(snapshot_format::compact)};
+		std::unique_ptr<snapshot> compressed{thread->create_snapshot(snapshot_format::compressed)};
+
+		THEN("the compact formats are smaller")
+		{
+			REQUIRE(compact->get_data_len() * 10 < standard->get_data_len());
+			REQUIRE(compressed->get_data_len() < compact->get_data_len());
+		}
+		WHEN("runners are loaded from each format")
+		{
+			runner                    expected = ink->new_runner_from_snapshot(*standard);
+			std::unique_ptr<snapshot> resnap{expected->create_snapshot()};
+			for (const snapshot* snap : {standard.get(), compact.get(), compressed.get()}) {
+				std::unique_ptr<snapshot> loaded = reload(*snap);
+				runner                    copy   = ink->new_runner_from_snapshot(*loaded);
+				THEN("they continue like the original")
+				{
+					REQUIRE(loaded->num_runners() == 1);
+					REQUIRE(turn(copy) == "turn 3\n");
+					REQUIRE(turn(copy) == "turn 4\n");
+				}
+				THEN("they are in the same state as a runner loaded from the standard format")
+				{
+					std::unique_ptr<snapshot> again{copy->create_snapshot()};
+					REQUIRE(again->get_data_len() == resnap->get_data_len());
+					REQUIRE(memcmp(again->get_data(), resnap->get_data(), resnap->get_data_len()) == 0);
+				}
+			}
+		}
+		WHEN("a compact snapshot is used as base of a delta")
+		{
+			THEN("it is rejected")
+			{
+				REQUIRE_THROWS_AS(thread->create_delta_snapshot(*compact), ink::ink_exception);
+			}
+		}
+		WHEN("the size of the compressed data is wrong")
+		{
+			unsigned char* data = new unsigned char[compressed->get_data_len()];
+			memcpy(data, compressed->get_data(), compressed->get_data_len());
+			// the length of the data after decompression follows the marker and the length
+			ink::size_t data_length;
+			memcpy(&data_length, data + 2 * sizeof(ink::size_t), sizeof(data_length));
+			data_length += 16;
+			memcpy(data + 2 * sizeof(ink::size_t), &data_length, sizeof(data_length));
+			THEN("loading fails")
+			{
+				REQUIRE_THROWS_AS(
+				    snapshot::from_binary(data, compressed->get_data_len(), false), ink::ink_exception
+				);
+			}
+			delete[] data;
+		}
+	}
+}
+
+SCENARIO("benchmark compact snapshots", "[.][benchmark]")
+{
+	auto report = [](const char* name, story& ink, runner& thread) {
+		for (snapshot_format format :
+		     {snapshot_format::standard, snapshot_format::compact, snapshot_format::compressed}) {
+			using ms                        = std::chrono::duration<double, std::milli>;
+			auto                      start = std::chrono::steady_clock::now();
+			std::unique_ptr<snapshot> snap{thread->create_snapshot(format)};
+			auto                      created = std::chrono::steady_clock::now();
+			for (int i = 0; i < 100; ++i) {
+				std::unique_ptr<snapshot> loaded = reload(*snap);
+				ink.new_runner_from_snapshot(*loaded);
+			}
+			auto loaded = std::chrono::steady_clock::now();
+			std::cout << name << " format " << static_cast<int>(format) << ": "
+			          << snap->get_data_len() << " bytes, created in " << ms(created - start).count()
+			          << "ms, loaded in " << ms(loaded - created).count() / 100 << "ms\n";
+		}
+	};
+	{
+		std::string            json   = fixture::add_knots(fixture::read("TurnStory.ink.json"), 1000);
+		std::string            binary = fixture::compile(json);
+		std::unique_ptr<story> ink    = fixture::load(binary);
+		runner                 thread = ink->new_runner();
+		thread->getall();
+		turn(thread);
+		report("1000 knots", *ink, thread);
+	}
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "TheIntercept.bin")};
+		runner                 thread = ink->new_runner();
+		thread->getall();
+		for (int i = 0; i < 10 && thread->num_choices() > 0; ++i) {
+			turn(thread);
+		}
+		report("TheIntercept", *ink, thread);
+	}
+}
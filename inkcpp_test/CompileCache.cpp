@@ -0,0 +1,108 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#include <compiler.h>
+
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <string>
+
+using ink::compiler::compilation_options;
+using ink::compiler::compilation_results;
+
+SCENARIO("compile with a knot cache", "[compiler]")
+{
+	GIVEN("an empty cache directory")
+	{
+		std::filesystem::path directory
+		    = std::filesystem::temp_directory_path() / "inkcpp_test_compile_cache";
+		std::filesystem::remove_all(directory);
+		compilation_options options = fixture::default_options();
+		options.cache_directory     = directory.string();
+		std::string json            = fixture::read("KnotStory.ink.json");
+		std::string uncached        = fixture::compile(json);
+
+		WHEN("compiled twice")
+		{
+			compilation_results first, second;
+			std::string         first_binary  = fixture::compile(json, options, &first);
+			std::string         second_binary = fixture::compile(json, options, &second);
+			THEN("all knots are stored and then loaded")
+			{
+				REQUIRE(first.cache_hits == 0);
+				REQUIRE(first.cache_misses == 4);
+				REQUIRE(second.cache_hits == 4);
+				REQUIRE(second.cache_misses == 0);
+			}
+			THEN("the binary is the same as without cache")
+			{
+				REQUIRE(first_binary == uncached);
+				REQUIRE(second_binary == uncached);
+			}
+		}
+		WHEN("one knot changes")
+		{
+			std::string changed = std::regex_replace(json, std::regex("\\^B"), "^changed B");
+			fixture::compile(json, options);
+			compilation_results results;
+			std::string         binary = fixture::compile(changed, options, &results);
+			THEN("only this knot is compiled again")
+			{
+				REQUIRE(results.cache_hits == 3);
+				REQUIRE(results.cache_misses == 1);
+				REQUIRE(binary == fixture::compile(changed));
+			}
+		}
+		WHEN("the cache is damaged")
+		{
+			fixture::compile(json, options);
+			for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+				std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) / 2);
+			}
+			compilation_results results;
+			std::string         binary = fixture::compile(json, options, &results);
+			THEN("knots are compiled again")
+			{
+				REQUIRE(results.cache_hits == 0);
+				REQUIRE(results.cache_misses == 4);
+				REQUIRE(binary == uncached);
+			}
+		}
+		WHEN("a cached offset points outside of its knot")
+		{
+			fixture::compile(json, options);
+			size_t damaged = 0;
+			for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+				std::fstream file(entry.path(), std::ios::binary | std::ios::in | std::ios::out);
+				// header: magic, cache version, binary version, key, number of containers
+				file.seekg(4 + 4 + 4 + 8 + 4);
+				// instructions, strings and lists, each prefixed with its size
+				for (int i = 0; i < 3; ++i) {
+					uint32_t size;
+					file.read(reinterpret_cast<char*>(&size), sizeof(size));
+					file.seekg(size, std::ios::cur);
+				}
+				uint32_t list_count, relocations;
+				file.read(reinterpret_cast<char*>(&list_count), sizeof(list_count));
+				file.read(reinterpret_cast<char*>(&relocations), sizeof(relocations));
+				if (relocations > 0) {
+					uint32_t position = 0xFFFFFF00;
+					file.seekp(file.tellg());
+					file.write(reinterpret_cast<const char*>(&position), sizeof(position));
+					++damaged;
+				}
+			}
+			compilation_results results;
+			std::string         binary = fixture::compile(json, options, &results);
+			THEN("the damaged knots are compiled again")
+			{
+				REQUIRE(damaged > 0);
+				REQUIRE(results.cache_misses == damaged);
+				REQUIRE(results.cache_hits == 4 - damaged);
+				REQUIRE(binary == uncached);
+			}
+		}
+		std::filesystem::remove_all(directory);
+	}
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#include <compiler.h>
+#include <story.h>
+#include <runner.h>
+#include <globals.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ink::runtime;
+
+namespace
+{
+// plays the story with its own globals, always taking the first choice
+std::string play(story& ink)
+{
+	globals     store  = ink.new_globals();
+	runner      thread = ink.new_runner(store);
+	std::string text   = thread->getall();
+	while (thread->num_choices() > 0) {
+		thread->choose(0);
+		text += thread->getall();
+	}
+	return text;
+}
+
+// starts `count` threads at the same time and waits for them
+template<typename F>
+void run_threads(size_t count, F work)
+{
+	std::atomic<size_t>      ready = 0;
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < count; ++i) {
+		threads.emplace_back([&ready, count, &work, i]() {
+			++ready;
+			while (ready < count) {
+				std::this_thread::yield();
+			}
+			work(i);
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+} // namespace
+
+SCENARIO("run independent runners of one story on multiple threads", "[threads]")
+{
+	GIVEN("a story with global variables")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "LoopStory.bin")};
+		WHEN("each thread plays it with its own globals")
+		{
+			std::vector<std::string> results(8);
+			run_threads(results.size(), [&](size_t i) {
+				for (int j = 0; j < 4; ++j) {
+					results[i] += play(*ink);
+				}
+			});
+			THEN("all threads get the same text")
+			{
+				for (const std::string& text : results) {
+					REQUIRE(text == "499500 n1000\n499500 n1000\n499500 n1000\n499500 n1000\n");
+				}
+			}
+		}
+		WHEN("threads copy and release pointers to the same runner")
+		{
+			runner shared = ink->new_runner();
+			run_threads(8, [&shared](size_t) {
+				for (int j = 0; j < 1000; ++j) {
+					runner copy = shared;
+				}
+			});
+			THEN("the runner is still alive") { REQUIRE(shared->getall() == "499500 n1000\n"); }
+		}
+	}
+	GIVEN("a story with choices")
+	{
+		std::string            json     = fixture::read("simple-1.1.1-inklecate.json");
+		std::string            binary   = fixture::compile(json);
+		std::unique_ptr<story> ink      = fixture::load(binary);
+		std::string            expected = play(*ink);
+		WHEN("each thread plays it")
+		{
+			std::vector<std::string> results(8);
+			run_threads(results.size(), [&](size_t i) { results[i] = play(*ink); });
+			THEN("all threads get the same text")
+			{
+				for (const std::string& text : results) {
+					REQUIRE(text == expected);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("benchmark runners on multiple threads", "[.][benchmark]")
+{
+	std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "LoopStory.bin")};
+	// every thread does the same amount of work, ideal scaling keeps the time constant
+	double single = 0;
+	size_t cores  = std::max(1u, std::thread::hardware_concurrency());
+	std::cout << "hardware threads: " << cores << '\n';
+	for (size_t count = 1; count <= 64 && count <= cores; count *= 2) {
+		auto start = std::chrono::steady_clock::now();
+		run_threads(count, [&ink](size_t) {
+			for (int j = 0; j < 200; ++j) {
+				play(*ink);
+			}
+		});
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+		                .count();
+		if (count == 1) {
+			single = ms;
+		}
+		std::cout << count << " threads: " << ms << "ms, scaling efficiency "
+		          << static_cast<int>(100 * single / ms) << "%\n";
+	}
+}
@@ -0,0 +1,159 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#include <compiler.h>
+#include <story.h>
+#include <globals.h>
+#include <runner.h>
+#include <snapshot.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace ink::runtime;
+
+namespace
+{
+std::string turn(runner& thread)
+{
+	thread->choose(0);
+	return thread->getall();
+}
+
+std::string content(const snapshot& snap)
+{
+	return std::string(reinterpret_cast<const char*>(snap.get_data()), snap.get_data_len());
+}
+} // namespace
+
+SCENARIO("delta snapshots", "[snapshot]")
+{
+	GIVEN("a story with many visit counts and a snapshot of its start")
+	{
+		std::string            json   = fixture::add_knots(fixture::read("TurnStory.ink.json"), 1000);
+		std::string            binary = fixture::compile(json);
+		std::unique_ptr<story> ink    = fixture::load(binary);
+		runner                 thread = ink->new_runner();
+		REQUIRE(thread->getall() == "turn 0\n");
+		std::unique_ptr<snapshot> base{thread->create_snapshot()};
+		REQUIRE_FALSE(base->is_delta());
+
+		WHEN("a delta is created after one turn")
+		{
+			REQUIRE(turn(thread) == "turn 1\n");
+			std::unique_ptr<snapshot> delta{thread->create_delta_snapshot(*base)};
+			std::unique_ptr<snapshot> full{thread->create_snapshot()};
+			THEN("it is much smaller than a full snapshot")
+			{
+				REQUIRE(delta->is_delta());
+				REQUIRE(delta->num_runners() == 1);
+				REQUIRE(delta->get_data_len() * 10 < full->get_data_len());
+			}
+			THEN("applying it restores the full snapshot")
+			{
+				const snapshot*           deltas[] = {delta.get()};
+				std::unique_ptr<snapshot> restored{snapshot::from_deltas(*base, deltas, 1)};
+				REQUIRE_FALSE(restored->is_delta());
+				REQUIRE(content(*restored) == content(*full));
+			}
+			THEN("it can not be loaded without its base")
+			{
+				REQUIRE_THROWS(ink->new_runner_from_snapshot(*delta));
+				const snapshot* deltas[] = {delta.get()};
+				REQUIRE_THROWS(snapshot::from_deltas(*full, deltas, 1));
+			}
+		}
+		WHEN("a delta is created against a copy of the base")
+		{
+			turn(thread);
+			std::unique_ptr<snapshot> copy{
+			    snapshot::from_binary(base->get_data(), base->get_data_len(), false)
+			};
+			std::unique_ptr<snapshot> delta{thread->create_delta_snapshot(*copy)};
+			std::unique_ptr<snapshot> full{thread->create_snapshot()};
+			THEN("the whole state is compared, with the same result")
+			{
+				const snapshot*           deltas[] = {delta.get()};
+				std::unique_ptr<snapshot> restored{snapshot::from_deltas(*copy, deltas, 1)};
+				REQUIRE(content(*restored) == content(*full));
+				REQUIRE(delta->get_data_len() * 10 < full->get_data_len());
+			}
+		}
+		WHEN("a chain of deltas is created, each against the previous state")
+		{
+			std::unique_ptr<snapshot> previous{thread->create_snapshot()};
+			std::unique_ptr<snapshot> deltas[3];
+			for (auto& delta : deltas) {
+				turn(thread);
+				delta.reset(thread->create_delta_snapshot(*previous));
+				previous.reset(thread->create_snapshot());
+			}
+			THEN("the runner continues the same after applying the chain")
+			{
+				const snapshot*           chain[] = {deltas[0].get(), deltas[1].get(), deltas[2].get()};
+				std::unique_ptr<snapshot> restored{snapshot::from_deltas(*base, chain, 3)};
+				REQUIRE(content(*restored) == content(*previous));
+				runner loaded = ink->new_runner_from_snapshot(*restored);
+				REQUIRE(turn(loaded) == "turn 4\n");
+				REQUIRE(turn(thread) == "turn 4\n");
+			}
+		}
+	}
+	GIVEN("a story where a global string grows each turn")
+	{
+		std::string            json   = fixture::add_knots(fixture::read("NameStory.ink.json"), 1000);
+		std::string            binary = fixture::compile(json);
+		std::unique_ptr<story> ink    = fixture::load(binary);
+		runner                 thread = ink->new_runner();
+		REQUIRE(thread->getall() == "turn a\n");
+		std::unique_ptr<snapshot> base{thread->create_snapshot()};
+
+		WHEN("a delta is created after the snapshot grew")
+		{
+			for (int i = 0; i < 40; ++i) {
+				turn(thread);
+			}
+			std::unique_ptr<snapshot> full{thread->create_snapshot()};
+			std::unique_ptr<snapshot> delta{thread->create_delta_snapshot(*base)};
+			REQUIRE(full->get_data_len() > base->get_data_len());
+			THEN("only the changed blocks are stored")
+			{
+				REQUIRE(delta->get_data_len() * 10 < full->get_data_len());
+			}
+			THEN("applying it restores the full snapshot")
+			{
+				const snapshot*           deltas[] = {delta.get()};
+				std::unique_ptr<snapshot> restored{snapshot::from_deltas(*base, deltas, 1)};
+				REQUIRE(content(*restored) == content(*full));
+				runner loaded = ink->new_runner_from_snapshot(*restored);
+				REQUIRE(turn(loaded) == turn(thread));
+			}
+		}
+	}
+}
+
+SCENARIO("benchmark autosaves", "[.][benchmark]")
+{
+	std::string            json   = fixture::add_knots(fixture::read("TurnStory.ink.json"), 5000);
+	std::string            binary = fixture::compile(json);
+	std::unique_ptr<story> ink    = fixture::load(binary);
+	runner                 thread = ink->new_runner();
+	thread->getall();
+	std::unique_ptr<snapshot> base{thread->create_snapshot()};
+	turn(thread);
+	std::unique_ptr<snapshot> full{thread->create_snapshot()};
+	std::unique_ptr<snapshot> delta{thread->create_delta_snapshot(*base)};
+	std::cout << "full snapshot: " << full->get_data_len()
+	          << " bytes, delta snapshot: " << delta->get_data_len() << " bytes\n";
+	BENCHMARK("full snapshot")
+	{
+		std::unique_ptr<snapshot> snap{thread->create_snapshot()};
+		return snap->get_data_len();
+	};
+	BENCHMARK("delta snapshot")
+	{
+		std::unique_ptr<snapshot> snap{thread->create_delta_snapshot(*base)};
+		return snap->get_data_len();
+	};
+}
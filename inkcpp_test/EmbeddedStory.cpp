@@ -0,0 +1,47 @@
+#include "catch.hpp"
+
+#include <story.h>
+#include <globals.h>
+#include <runner.h>
+#include <choice.h>
+
+#include <memory>
+
+#include "ForkStoryEmbedded.h"
+
+using namespace ink::runtime;
+
+SCENARIO("run a story embedded into the executable", "[story]")
+{
+	GIVEN("the embedded story and the same story loaded from file")
+	{
+		std::unique_ptr<story> loaded{story::from_file(INK_TEST_RESOURCE_DIR "ForkStory.bin")};
+		std::unique_ptr<story> embedded{story::from_static(ForkStoryEmbedded, ForkStoryEmbedded_size)
+		};
+
+		WHEN("running both")
+		{
+			runner expected = loaded->new_runner();
+			runner thread   = embedded->new_runner();
+			THEN("they produce the same output")
+			{
+				REQUIRE(thread->getall() == expected->getall());
+				REQUIRE(thread->num_choices() == expected->num_choices());
+				thread->choose(0);
+				expected->choose(0);
+				REQUIRE(thread->getall() == expected->getall());
+			}
+		}
+		WHEN("the story is destroyed")
+		{
+			runner thread = embedded->new_runner();
+			embedded.reset();
+			THEN("the static data stays untouched and can be loaded again")
+			{
+				REQUIRE_FALSE(thread);
+				embedded.reset(story::from_static(ForkStoryEmbedded, ForkStoryEmbedded_size));
+				REQUIRE(embedded->new_runner()->getline() == "Hello world!\n");
+			}
+		}
+	}
+}
@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <explorer.h>
+#include <story.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace ink::runtime;
+
+namespace
+{
+size_t coverage(const explore_result& result, const char* name)
+{
+	for (const container_coverage& container : result.containers) {
+		if (container.name == ink::hash_string(name)) {
+			return container.states;
+		}
+	}
+	return 0;
+}
+} // namespace
+
+SCENARIO("explore the choices of a story", "[explorer]")
+{
+	GIVEN("a story without visit counts, where each order of choices reaches the same state")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "HubStory.bin")};
+		explore_options        options;
+		options.max_depth = 10;
+		options.threads   = 4;
+		WHEN("it is explored")
+		{
+			explore_result result = explore(*ink, options);
+			THEN("each number of choices is one state")
+			{
+				REQUIRE(result.states == 11);
+				REQUIRE(result.duplicates == 10);
+				REQUIRE(result.truncated == 1);
+				REQUIRE(result.endings == 0);
+				REQUIRE_FALSE(result.complete);
+				// the knot is the only container with a counter
+				REQUIRE(result.containers.size() == 1);
+				REQUIRE(coverage(result, "hub") == 11);
+			}
+		}
+	}
+	GIVEN("a story with once only choices")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "OnceOnlyHubStory.bin")};
+		WHEN("it is explored without limits")
+		{
+			explore_result result = explore(*ink);
+			THEN("every state is found")
+			{
+				// start, a, b, ab, ba (ab and ba differ in the turns since the choices)
+				REQUIRE(result.complete);
+				REQUIRE(result.states == 5);
+				REQUIRE(result.endings == 2);
+				REQUIRE(result.truncated == 0);
+			}
+			THEN("the coverage counts the states which visited a container")
+			{
+				REQUIRE(result.containers.size() == 3);
+				REQUIRE(result.covered() == 3);
+				REQUIRE(coverage(result, "hub") == 5);
+				REQUIRE(coverage(result, "hub.c-0") == 3);
+				REQUIRE(coverage(result, "hub.c-1") == 3);
+			}
+		}
+	}
+	GIVEN("a story with sticky choices")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "CountedHubStory.bin")};
+		explore_options        options;
+		options.max_depth = 8;
+		options.threads   = 1;
+		explore_result single = explore(*ink, options);
+		WHEN("it is explored on multiple threads")
+		{
+			options.threads              = 4;
+			explore_result depth_first   = explore(*ink, options);
+			options.breadth_first        = true;
+			explore_result breadth_first = explore(*ink, options);
+			THEN("the same states are found")
+			{
+				for (const explore_result& result : {depth_first, breadth_first}) {
+					REQUIRE(result.states == single.states);
+					REQUIRE(result.endings == single.endings);
+					REQUIRE(result.truncated == single.truncated);
+					REQUIRE(coverage(result, "hub.c-0") == coverage(single, "hub.c-0"));
+				}
+			}
+		}
+		WHEN("the number of states is limited")
+		{
+			options.max_depth  = 0;
+			options.max_states = 100;
+			options.threads    = 4;
+			explore_result result = explore(*ink, options);
+			THEN("the exploration stops at the limit")
+			{
+				REQUIRE(result.states == 100);
+				REQUIRE_FALSE(result.complete);
+				REQUIRE(coverage(result, "hub") == 100);
+			}
+		}
+	}
+}
+
+SCENARIO("benchmark the story explorer", "[.][benchmark]")
+{
+	std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "CountedHubStory.bin")};
+	explore_options        options;
+	options.max_depth = 18;
+	double single     = 0;
+	size_t cores      = std::max(1u, std::thread::hardware_concurrency());
+	std::cout << "hardware threads: " << cores << '\n';
+	for (unsigned count = 1; count <= 64 && count <= cores; count *= 2) {
+		options.threads       = count;
+		auto           start  = std::chrono::steady_clock::now();
+		explore_result result = explore(*ink, options);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+		                .count();
+		if (count == 1) {
+			single = ms;
+		}
+		std::cout << count << " threads: " << result.states << " states in " << ms
+		          << "ms, speedup " << single / ms << "\n";
+	}
+}
@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include <../functions.h>
+
+#include <choice.h>
+#include <globals.h>
+#include <runner.h>
+#include <story.h>
+
+using namespace ink::runtime;
+
+namespace
+{
+// a function written against the interface before function_base::clone() existed
+class legacy_function : public internal::function_base
+{
+public:
+	legacy_function()
+	    : function_base(true)
+	{
+	}
+
+	void call(internal::basic_eval_stack*, ink::size_t, internal::string_table&, internal::list_table&)
+	    override
+	{
+	}
+};
+} // namespace
+
+SCENARIO("fork a runner", "[fork]")
+{
+	GIVEN("a runner waiting for a choice")
+	{
+		auto    ink    = story::from_file(INK_TEST_RESOURCE_DIR "ForkStory.bin");
+		globals store  = ink->new_globals();
+		runner  thread = ink->new_runner(store);
+		REQUIRE(thread->getall() == "Hello world!\n");
+
+		WHEN("the runner is forked")
+		{
+			runner fork = thread->fork();
+			THEN("the fork presents the same choices")
+			{
+				REQUIRE(fork->num_choices() == thread->num_choices());
+				for (size_t i = 0; i < thread->num_choices(); ++i) {
+					REQUIRE(std::string(fork->get_choice(i)->text()) == thread->get_choice(i)->text());
+				}
+			}
+			THEN("both runners continue independently")
+			{
+				thread->choose(0);
+				fork->choose(1);
+				REQUIRE(thread->getall() == "Hello back!\nvisits=1 path=start+A\n");
+				REQUIRE(fork->getall() == "Bye\npath=start+B\n");
+				REQUIRE(*store->get<int32_t>("visits") == 1);
+				REQUIRE(*store->get<const char*>("path") == std::string{"start+A"});
+			}
+			THEN("the fork survives the original runner")
+			{
+				thread = nullptr;
+				fork->choose(0);
+				REQUIRE(fork->getall() == "Hello back!\nvisits=1 path=start+A\n");
+			}
+		}
+		WHEN("the globals are forked")
+		{
+			globals copy = store->fork();
+			store->set<const char*>("path", "changed");
+			THEN("the copy keeps the old values")
+			{
+				REQUIRE(*copy->get<const char*>("path") == std::string{"start+"});
+				REQUIRE(*copy->get<int32_t>("visits") == 0);
+			}
+			THEN("a new runner on the copy uses the copied state")
+			{
+				runner other = ink->new_runner(copy);
+				REQUIRE(other->getall() == "Hello world!\n");
+				REQUIRE(*copy->get<const char*>("path") == std::string{"start++"});
+				REQUIRE(*store->get<const char*>("path") == std::string{"changed"});
+			}
+		}
+	}
+}
+
+SCENARIO("fork the external functions of a runner", "[fork]")
+{
+	GIVEN("a custom function which does not implement clone()")
+	{
+		internal::functions bound;
+		bound.add(ink::hash_string("legacy"), new legacy_function);
+		WHEN("the functions are copied for a fork")
+		{
+			internal::functions copy;
+			copy.copy_from(bound);
+			THEN("the function is not bound in the copy")
+			{
+				REQUIRE(bound.find(ink::hash_string("legacy")) != nullptr);
+				REQUIRE(copy.find(ink::hash_string("legacy")) == nullptr);
+			}
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#include "catch.hpp"
+
+#include <story.h>
+#include <globals.h>
+#include <runner.h>
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+using namespace ink::runtime;
+
+SCENARIO("globals are copied from an initialized image", "[global variables]")
+{
+	GIVEN("a story with global variables")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "GlobalStory.bin")};
+		globals                first = ink->new_globals();
+
+		WHEN("no runner was created yet")
+		{
+			THEN("variables are already initialized")
+			{
+				REQUIRE(*first->get<int32_t>("age") == 23);
+				REQUIRE(*first->get<const char*>("friendly_name_of_player") == std::string{"Jackie"});
+			}
+		}
+		WHEN("one globals store is modified")
+		{
+			first->set<int32_t>("age", 30);
+			first->set<const char*>("friendly_name_of_player", "Freddy");
+			globals second = ink->new_globals();
+			runner  thread = ink->new_runner(second);
+			THEN("new stores start from the initial values")
+			{
+				REQUIRE(*second->get<int32_t>("age") == 23);
+				REQUIRE(
+				    thread->getall()
+				    == "My name is Jean Passepartout, but my friend's call me Jackie. I'm 23 years "
+				       "old.\nFoo:23\n"
+				);
+				REQUIRE(*second->get<const char*>("concat") == std::string{"Foo:23"});
+				REQUIRE(*first->get<int32_t>("age") == 30);
+				REQUIRE(*first->get<const char*>("concat") == std::string{"Foo:"});
+			}
+		}
+	}
+}
+
+SCENARIO("benchmark creating globals", "[.][benchmark]")
+{
+	std::ifstream              file(INK_TEST_RESOURCE_DIR "TheIntercept.bin", std::ios::binary);
+	std::vector<unsigned char> data(
+	    (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+	);
+	std::unique_ptr<story> ink{story::from_binary(data.data(), data.size(), false)};
+	ink->new_globals();
+
+	BENCHMARK("new_globals with global decl execution")
+	{
+		std::unique_ptr<story> fresh{story::from_binary(data.data(), data.size(), false)};
+		globals                store  = fresh->new_globals();
+		runner                 thread = fresh->new_runner(store);
+		return thread->can_continue();
+	};
+	BENCHMARK("new_globals from image")
+	{
+		globals store  = ink->new_globals();
+		runner  thread = ink->new_runner(store);
+		return thread->can_continue();
+	};
+}
@@ -0,0 +1,166 @@
+#include "catch.hpp"
+
+#include <compiler.h>
+#include <story.h>
+#include <globals.h>
+#include <runner.h>
+#include <snapshot.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace ink::runtime;
+
+namespace
+{
+std::string turn(runner& thread)
+{
+	thread->choose(0);
+	return thread->getall();
+}
+
+// copy of a snapshot to corrupt
+std::unique_ptr<unsigned char[]> copy(const snapshot& snap)
+{
+	std::unique_ptr<unsigned char[]> data{new unsigned char[snap.get_data_len()]};
+	memcpy(data.get(), snap.get_data(), snap.get_data_len());
+	return data;
+}
+
+ink::size_t read_size(const unsigned char* data, ink::size_t idx)
+{
+	ink::size_t value;
+	memcpy(&value, data + idx * sizeof(ink::size_t), sizeof(value));
+	return value;
+}
+} // namespace
+
+SCENARIO("load a story from a memory mapped file", "[story]")
+{
+	GIVEN("a story loaded from file and the same story mapped twice")
+	{
+		std::unique_ptr<story> loaded{story::from_file(INK_TEST_RESOURCE_DIR "GlobalStory.bin")};
+		std::unique_ptr<story> mapped{story::from_mapped_file(INK_TEST_RESOURCE_DIR "GlobalStory.bin")
+		};
+		std::unique_ptr<story> shared{story::from_mapped_file(INK_TEST_RESOURCE_DIR "GlobalStory.bin")
+		};
+		std::string expected = loaded->new_runner()->getall();
+
+		WHEN("running several runners on the mapped stories")
+		{
+			runner first  = mapped->new_runner();
+			runner second = mapped->new_runner();
+			runner third  = shared->new_runner();
+			THEN("they produce the same output as the loaded story")
+			{
+				REQUIRE(first->getall() == expected);
+				REQUIRE(second->getall() == expected);
+				REQUIRE(third->getall() == expected);
+			}
+		}
+		WHEN("a mapped story is destroyed")
+		{
+			runner thread = mapped->new_runner();
+			mapped.reset();
+			THEN("its runners are invalidated and the other mapping is unaffected")
+			{
+				REQUIRE_FALSE(thread);
+				REQUIRE(shared->new_runner()->getall() == expected);
+			}
+		}
+	}
+	GIVEN("a file which does not exist")
+	{
+		THEN("mapping fails with an exception")
+		{
+			REQUIRE_THROWS(story::from_mapped_file(INK_TEST_RESOURCE_DIR "DoesNotExist.bin"));
+		}
+	}
+}
+
+SCENARIO("load a snapshot from a memory mapped file", "[snapshot]")
+{
+	GIVEN("a snapshot with dynamic strings written to a file")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "NameStory.bin")};
+		runner                 thread = ink->new_runner();
+		REQUIRE(thread->getall() == "turn a\n");
+		turn(thread);
+		REQUIRE(turn(thread) == "turn axx\n");
+		std::unique_ptr<snapshot> snap{thread->create_snapshot()};
+		snap->write_to_file("MappedSnapshot.snap");
+
+		WHEN("the file is mapped")
+		{
+			std::unique_ptr<snapshot> mapped{snapshot::from_mapped_file("MappedSnapshot.snap")};
+			THEN("it contains the written snapshot")
+			{
+				REQUIRE(mapped->get_data_len() == snap->get_data_len());
+				REQUIRE(memcmp(mapped->get_data(), snap->get_data(), snap->get_data_len()) == 0);
+			}
+			THEN("runners loaded from it continue like the original")
+			{
+				runner first  = ink->new_runner_from_snapshot(*mapped);
+				runner second = ink->new_runner_from_snapshot(*mapped);
+				for (int i = 0; i < 3; ++i) {
+					std::string expected = turn(thread);
+					REQUIRE(turn(first) == expected);
+					REQUIRE(turn(second) == expected);
+				}
+				REQUIRE(first->getall() == "");
+				REQUIRE(turn(first) == "turn axxxxxx\n");
+			}
+			THEN("the runner stays valid after the snapshot is destroyed")
+			{
+				runner loaded = ink->new_runner_from_snapshot(*mapped);
+				mapped.reset();
+				REQUIRE(turn(loaded) == "turn axxx\n");
+			}
+		}
+		std::remove("MappedSnapshot.snap");
+	}
+	GIVEN("corrupted snapshots")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "NameStory.bin")};
+		runner                 thread = ink->new_runner();
+		thread->getall();
+		turn(thread);
+		std::unique_ptr<snapshot> snap{thread->create_snapshot()};
+		ink::size_t               length = snap->get_data_len();
+
+		THEN("truncated data is rejected")
+		{
+			auto data = copy(*snap);
+			REQUIRE_THROWS_AS(snapshot::from_binary(data.get(), 4, false), ink::ink_exception);
+			REQUIRE_THROWS_AS(
+			    snapshot::from_binary(data.get(), length - 8, false), ink::ink_exception
+			);
+		}
+		THEN("offsets outside of the data are rejected")
+		{
+			auto        data   = copy(*snap);
+			ink::size_t offset = length + 1;
+			memcpy(data.get() + 3 * sizeof(ink::size_t), &offset, sizeof(offset));
+			REQUIRE_THROWS_AS(snapshot::from_binary(data.get(), length, false), ink::ink_exception);
+		}
+		THEN("a part which does not fit its size is rejected when loading")
+		{
+			auto        data    = copy(*snap);
+			ink::size_t globals = read_size(data.get(), 2);
+			ink::size_t runner  = read_size(data.get(), 3);
+			memset(data.get() + globals, 0x7f, runner - globals);
+			std::unique_ptr<snapshot> broken{snapshot::from_binary(data.get(), length, false)};
+			REQUIRE_THROWS_AS(ink->new_globals_from_snapshot(*broken), ink::ink_exception);
+		}
+	}
+	GIVEN("a file which does not exist")
+	{
+		THEN("mapping fails with an exception")
+		{
+			REQUIRE_THROWS(snapshot::from_mapped_file(INK_TEST_RESOURCE_DIR "DoesNotExist.snap"));
+		}
+	}
+}
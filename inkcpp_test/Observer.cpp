@@ -1,4 +1,5 @@
 #include "catch.hpp"
+#include "fixtures.h"
 
 #include <../runner_impl.h>
 #include <choice.h>
@@ -7,8 +8,26 @@
 #include <runner.h>
 #include <story.h>
 
+#include <memory>
+#include <string>
+
 using namespace ink::runtime;
 
+namespace
+{
+// LoopStory with `count` further global variables
+std::string add_variables(const std::string& json, int count)
+{
+	nlohmann::json  story = nlohmann::json::parse(json);
+	nlohmann::json& decl  = story["root"].back()["global decl"];
+	for (int i = 0; i < count; ++i) {
+		// before the final "/ev", "end" and null
+		decl.insert(decl.end() - 3, {i, {{"VAR=", "v" + std::to_string(i)}}});
+	}
+	return story.dump();
+}
+} // namespace
+
 SCENARIO("Observer", "[variables][observer]")
 {
 	GIVEN("a story which changes variables")
@@ -247,3 +266,103 @@ SCENARIO("Observer", "[variables][observer]")
 		}
 	}
 }
+
+SCENARIO("Observe globals before the first runner", "[variables][observer]")
+{
+	GIVEN("a new global store")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "ForkStory.bin")};
+		globals                store = ink->new_globals();
+		std::string            calls;
+		WHEN("an observer is attached before a runner is created")
+		{
+			store->observe("visits", [&calls](int32_t value, ink::optional<int32_t> old_value) {
+				calls += std::to_string(value) + (old_value.has_value() ? " old " : " new ");
+			});
+			THEN("the initial value is reported during observe, without an old value")
+			{
+				REQUIRE(calls == "0 new ");
+			}
+			THEN("creating the runner does not report it again")
+			{
+				runner thread = ink->new_runner(store);
+				REQUIRE(calls == "0 new ");
+				REQUIRE(thread->getall() == "Hello world!\n");
+				REQUIRE(calls == "0 new ");
+			}
+		}
+	}
+}
+
+SCENARIO("Coalesced observers", "[variables][observer]")
+{
+	GIVEN("a story which assigns variables ahead of the current line")
+	{
+		std::unique_ptr<story> ink{
+		    story::from_file(INK_TEST_RESOURCE_DIR "LookaheadObserverStory.bin")
+		};
+		globals                store   = ink->new_globals();
+		runner                 thread  = ink->new_runner(store);
+		std::string            changes = "";
+		auto                   record  = [&changes](const char* name) {
+      return [&changes, name](int32_t new_value, ink::optional<int32_t> old_value) {
+        changes += std::string(name) + ":" + (old_value ? std::to_string(*old_value) : "-") + "->"
+                 + std::to_string(new_value) + " ";
+      };
+		};
+		store->observe("y", record("y"));
+		store->observe("x", record("x"));
+		store->observe("y", record("y2"));
+		changes = "";
+		WHEN("observers are called on every assignment")
+		{
+			std::string first = thread->getline();
+			THEN("the lookahead is reported too")
+			{
+				REQUIRE(first == "line one\n");
+				REQUIRE(changes == "x:0->1 x:1->2 y:0->1 y2:0->1 ");
+			}
+		}
+		WHEN("observers are coalesced")
+		{
+			store->coalesce_observers(true);
+			std::string first        = thread->getline();
+			std::string first_lines  = changes;
+			changes                  = "";
+			std::string second       = thread->getline();
+			std::string second_lines = changes;
+			THEN("each variable is reported once per line")
+			{
+				REQUIRE(first == "line one\n");
+				REQUIRE(first_lines == "x:0->2 ");
+				REQUIRE(second == "line two\n");
+				REQUIRE(second_lines == "y:0->1 y2:0->1 ");
+			}
+		}
+		WHEN("coalesced observers are set from outside")
+		{
+			store->coalesce_observers(true);
+			store->set<int32_t>("y", 7);
+			THEN("they are reported directly") { REQUIRE(changes == "y:0->7 y2:0->7 "); }
+		}
+	}
+}
+
+SCENARIO("benchmark many observers", "[.][benchmark]")
+{
+	std::string            json   = add_variables(fixture::read("LoopStory.ink.json"), 200);
+	std::string            binary = fixture::compile(json);
+	std::unique_ptr<story> ink    = fixture::load(binary);
+	globals                store  = ink->new_globals();
+	runner                 check  = ink->new_runner(store);
+	int                    calls  = 0;
+	for (int i = 0; i < 200; ++i) {
+		store->observe(("v" + std::to_string(i)).c_str(), [&calls]() { ++calls; });
+	}
+	REQUIRE(check->getall() == "499500 n1000\n");
+	BENCHMARK("assign a variable next to 200 observed ones")
+	{
+		runner thread = ink->new_runner(store);
+		return thread->getall();
+	};
+}
@@ -0,0 +1,85 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#include <compiler.h>
+#include <story.h>
+#include <runner.h>
+#include <globals.h>
+
+#include <memory>
+#include <string>
+
+using namespace ink::runtime;
+
+namespace
+{
+// plays the story, always taking the first choice
+std::string play(std::string& binary)
+{
+	std::unique_ptr<story> ink    = fixture::load(binary);
+	runner                 thread = ink->new_runner();
+	std::string            text   = thread->getall();
+	while (thread->num_choices() > 0) {
+		thread->choose(0);
+		text += thread->getall();
+	}
+	return text;
+}
+} // namespace
+
+SCENARIO("optimize the bytecode", "[compiler]")
+{
+	GIVEN("a story with optimizable bytecode")
+	{
+		std::string json        = fixture::read("OptimizableStory.ink.json");
+		std::string unoptimized = fixture::compile(json, 0);
+		std::string optimized   = fixture::compile(json, 1);
+		THEN("the optimized bytecode is smaller")
+		{
+			REQUIRE(optimized.size() < unoptimized.size());
+		}
+		THEN("both behave the same")
+		{
+			REQUIRE(play(unoptimized) == "9\n-5\n102\nafter 1\n");
+			REQUIRE(play(optimized) == "9\n-5\n102\nafter 1\n");
+		}
+	}
+	GIVEN("a story with jumps behind removed instructions")
+	{
+		std::string json        = fixture::read("OptimizerJumps.json");
+		std::string unoptimized = fixture::compile(json, 0);
+		std::string optimized   = fixture::compile(json, 1);
+		THEN("the optimized bytecode is smaller")
+		{
+			REQUIRE(optimized.size() < unoptimized.size());
+		}
+		THEN("the jumps are moved to their new targets")
+		{
+			REQUIRE(play(unoptimized) == "6\n-1\ntarget\nafter\n42\n");
+			REQUIRE(play(optimized) == "6\n-1\ntarget\nafter\n42\n");
+		}
+	}
+	GIVEN("a story with jumps to a noop, an unnamed container and a gather")
+	{
+		std::string json        = fixture::read("OptimizerLabels.json");
+		std::string unoptimized = fixture::compile(json, 0);
+		std::string optimized   = fixture::compile(json, 1);
+		THEN("the optimized bytecode is smaller")
+		{
+			REQUIRE(optimized.size() < unoptimized.size());
+		}
+		THEN("the paths still lead to the same instructions")
+		{
+			REQUIRE(play(unoptimized) == "in a\n8\ninner 7\npicked\n4\n");
+			REQUIRE(play(optimized) == "in a\n8\ninner 7\npicked\n4\n");
+		}
+	}
+	GIVEN("json exported by inklecate and inky")
+	{
+		auto        compiler    = GENERATE("inklecate", "inky");
+		std::string json        = fixture::read(std::string("simple-1.1.1-") + compiler + ".json");
+		std::string unoptimized = fixture::compile(json, 0);
+		std::string optimized   = fixture::compile(json, 1);
+		THEN("both behave the same") { REQUIRE(play(optimized) == play(unoptimized)); }
+	}
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#define INK_EXPOSE_JSON
+#include <compiler.h>
+#include <story.h>
+#include <runner.h>
+#include <globals.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace ink::runtime;
+using ink::compiler::compilation_options;
+
+namespace
+{
+compilation_options with_threads(unsigned threads)
+{
+	compilation_options options = fixture::default_options();
+	options.threads             = threads;
+	return options;
+}
+
+std::string compile(const nlohmann::json& in, unsigned threads)
+{
+	std::stringstream out;
+	ink::compiler::run(in, out, nullptr, with_threads(threads));
+	return out.str();
+}
+} // namespace
+
+SCENARIO("compile knots on multiple threads", "[compiler]")
+{
+	GIVEN("json exported by inklecate and inky")
+	{
+		auto        compiler = GENERATE("inklecate", "inky");
+		std::string json     = fixture::read(std::string("simple-1.1.1-") + compiler + ".json");
+		THEN("the binary does not depend on the number of threads")
+		{
+			REQUIRE(fixture::compile(json, with_threads(1)) == fixture::compile(json, with_threads(4)));
+		}
+	}
+	GIVEN("a story with knots referencing each other")
+	{
+		std::string json   = fixture::read("KnotStory.ink.json");
+		std::string binary = fixture::compile(json, with_threads(1));
+		THEN("the binary does not depend on the number of threads")
+		{
+			REQUIRE(binary == fixture::compile(json, with_threads(4)));
+			REQUIRE(binary == fixture::compile(json, with_threads(0)));
+			REQUIRE(compile(nlohmann::json::parse(json), 4) == binary);
+		}
+		THEN("the story runs")
+		{
+			std::unique_ptr<story> ink    = fixture::load(binary);
+			runner                 thread = ink->new_runner();
+			REQUIRE(thread->getall() == "A\nred\nB\n1\ninner 5\ngathered\n");
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <globals.h>
+#include <runner.h>
+#include <snapshot.h>
+#include <story.h>
+
+#include <memory>
+
+using namespace ink::runtime;
+
+namespace
+{
+// hash of a runner loaded from a snapshot of thread, computed from scratch
+uint64_t loaded_hash(story& ink, const runner& thread)
+{
+	std::unique_ptr<snapshot> snap{thread->create_snapshot()};
+	runner                    loaded = ink.new_runner_from_snapshot(*snap);
+	return loaded->state_hash();
+}
+} // namespace
+
+SCENARIO("hash the state of a runner", "[state hash]")
+{
+	GIVEN("a runner waiting for a choice")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "ForkStory.bin")};
+		globals                store  = ink->new_globals();
+		runner                 thread = ink->new_runner(store);
+		thread->getall();
+		uint64_t start = thread->state_hash();
+		REQUIRE(thread->state_hash() == start);
+
+		WHEN("the runner is forked")
+		{
+			runner fork = thread->fork();
+			THEN("the fork has the same hash") { REQUIRE(fork->state_hash() == start); }
+			THEN("different choices lead to different hashes")
+			{
+				thread->choose(0);
+				fork->choose(1);
+				REQUIRE(thread->state_hash() != start);
+				REQUIRE(thread->state_hash() != fork->state_hash());
+				thread->getall();
+				fork->getall();
+				REQUIRE(thread->state_hash() != fork->state_hash());
+			}
+		}
+		WHEN("the runner is loaded from a snapshot")
+		{
+			THEN("the hashes are equal") { REQUIRE(loaded_hash(*ink, thread) == start); }
+			THEN("the hashes stay equal while the runner continues")
+			{
+				thread->choose(0);
+				REQUIRE(loaded_hash(*ink, thread) == thread->state_hash());
+				thread->getline();
+				REQUIRE(loaded_hash(*ink, thread) == thread->state_hash());
+				thread->getall();
+				REQUIRE(loaded_hash(*ink, thread) == thread->state_hash());
+			}
+		}
+		WHEN("a global variable is changed")
+		{
+			uint64_t globals_start = store->state_hash();
+			store->set<int32_t>("visits", 5);
+			THEN("the hashes change")
+			{
+				REQUIRE(store->state_hash() != globals_start);
+				REQUIRE(thread->state_hash() != start);
+				REQUIRE(loaded_hash(*ink, thread) == thread->state_hash());
+			}
+			THEN("setting the old value restores the hashes")
+			{
+				store->set<int32_t>("visits", 0);
+				REQUIRE(store->state_hash() == globals_start);
+				REQUIRE(thread->state_hash() == start);
+			}
+		}
+		WHEN("the globals are forked")
+		{
+			globals copy = store->fork();
+			THEN("the copy has the same hash") { REQUIRE(copy->state_hash() == store->state_hash()); }
+			THEN("equal strings have equal hashes")
+			{
+				store->set<const char*>("path", "other");
+				copy->set<const char*>("path", "other");
+				REQUIRE(copy->state_hash() == store->state_hash());
+			}
+		}
+	}
+	GIVEN("a story where different choices lead to the same state")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "HubStory.bin")};
+		runner                 a      = ink->new_runner();
+		a->getall();
+		uint64_t start = a->state_hash();
+		runner   b     = a->fork();
+		WHEN("the runners take different choices")
+		{
+			a->choose(0);
+			a->getall();
+			b->choose(1);
+			b->getall();
+			THEN("the hashes are equal")
+			{
+				REQUIRE(a->state_hash() == b->state_hash());
+				REQUIRE(a->state_hash() != start);
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#define INK_EXPOSE_JSON
+#include <compiler.h>
+#include <story.h>
+#include <runner.h>
+#include <globals.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace ink::runtime;
+
+namespace
+{
+std::string compile_dom(const std::string& json)
+{
+	std::stringstream out;
+	ink::compiler::run(nlohmann::json::parse(json), out, nullptr, fixture::default_options());
+	return out.str();
+}
+} // namespace
+
+SCENARIO("compile json without building a DOM", "[compiler]")
+{
+	GIVEN("json exported by inklecate and inky")
+	{
+		auto        compiler = GENERATE("inklecate", "inky");
+		std::string json     = fixture::read(std::string("simple-1.1.1-") + compiler + ".json");
+		THEN("the streaming compiler produces the same binary")
+		{
+			REQUIRE(fixture::compile(json) == compile_dom(json));
+		}
+	}
+	GIVEN("json with escapes, floats, unordered named children and a BOM")
+	{
+		std::string json   = fixture::read("EdgeCaseStory.json");
+		std::string binary = fixture::compile(json);
+		THEN("the streaming compiler produces the same binary")
+		{
+			REQUIRE(binary == compile_dom(json));
+		}
+		THEN("the story runs")
+		{
+			std::unique_ptr<story> ink    = fixture::load(binary);
+			runner                 thread = ink->new_runner();
+			REQUIRE(thread->getall() == "caf\xC3\xA9 \xF0\x9F\x98\x80 \"q\"\n-1998.5\nin b\nin a\n");
+		}
+	}
+}
@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include <story.h>
+#include <globals.h>
+#include <runner.h>
+#include <snapshot.h>
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ink::runtime;
+
+namespace
+{
+// plays up to count choices, always taking the first one
+std::string play(runner& thread, int count)
+{
+	std::string text = thread->getall();
+	for (int i = 0; i < count && thread->num_choices() > 0; ++i) {
+		thread->choose(0);
+		text += thread->getall();
+	}
+	return text;
+}
+
+// collects the snapshot in chunks, as a custom sink would do
+class chunk_sink : public snapshot_sink
+{
+public:
+	void write(const unsigned char* data, ink::size_t length) override
+	{
+		++chunks;
+		content.append(reinterpret_cast<const char*>(data), length);
+	}
+
+	void patch(ink::size_t offset, const unsigned char* data, ink::size_t length) override
+	{
+		content.replace(offset, length, reinterpret_cast<const char*>(data), length);
+	}
+
+	std::string content;
+	int         chunks = 0;
+};
+
+std::string content(const snapshot& snap)
+{
+	return std::string(reinterpret_cast<const char*>(snap.get_data()), snap.get_data_len());
+}
+} // namespace
+
+SCENARIO("write snapshots to a sink", "[snapshot]")
+{
+	GIVEN("two runners with shared globals in the middle of a story")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "TheIntercept.bin")};
+		globals                store  = ink->new_globals();
+		runner                 first  = ink->new_runner(store);
+		runner                 second = ink->new_runner(store);
+		play(first, 5);
+		play(second, 2);
+		std::unique_ptr<snapshot> expected{store->create_snapshot()};
+		WHEN("it is written to a custom sink")
+		{
+			chunk_sink sink;
+			store->write_snapshot(sink);
+			THEN("each part is passed separately and the result matches create_snapshot")
+			{
+				REQUIRE(sink.chunks == 4);
+				REQUIRE(sink.content == content(*expected));
+			}
+		}
+		WHEN("it is written to a stream after other data")
+		{
+			std::stringstream out;
+			out << "prefix";
+			stream_snapshot_sink sink(out);
+			first->write_snapshot(sink);
+			THEN("the header is patched relative to the start of the snapshot")
+			{
+				REQUIRE(out.str() == "prefix" + content(*expected));
+			}
+		}
+		WHEN("it is written to a file")
+		{
+			FILE* file = tmpfile();
+			REQUIRE(file != nullptr);
+			file_snapshot_sink sink(file);
+			store->write_snapshot(sink);
+			std::string data(ftell(file), '\0');
+			rewind(file);
+			REQUIRE(fread(data.data(), 1, data.size(), file) == data.size());
+			fclose(file);
+			THEN("it can be loaded and continues the same")
+			{
+				REQUIRE(data == content(*expected));
+				std::unique_ptr<snapshot> snap{snapshot::from_binary(
+				    reinterpret_cast<const unsigned char*>(data.data()), data.size(), false
+				)};
+				globals loaded_store  = ink->new_globals_from_snapshot(*snap);
+				runner  loaded_first  = ink->new_runner_from_snapshot(*snap, loaded_store, 0);
+				runner  loaded_second = ink->new_runner_from_snapshot(*snap, loaded_store, 1);
+				REQUIRE(play(loaded_first, 3) == play(first, 3));
+				REQUIRE(play(loaded_second, 3) == play(second, 3));
+			}
+		}
+	}
+}
+
+SCENARIO("benchmark writing snapshots", "[.][benchmark]")
+{
+	std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "TheIntercept.bin")};
+	globals                store = ink->new_globals();
+	// many runners make a large snapshot out of small parts
+	std::vector<runner> threads;
+	for (int i = 0; i < 200; ++i) {
+		threads.push_back(ink->new_runner(store));
+		play(threads.back(), i % 5);
+	}
+	BENCHMARK("create_snapshot and copy to stream")
+	{
+		std::ostringstream        out;
+		std::unique_ptr<snapshot> snap{store->create_snapshot()};
+		out.write(reinterpret_cast<const char*>(snap->get_data()), snap->get_data_len());
+		return out.tellp();
+	};
+	BENCHMARK("write_snapshot to stream")
+	{
+		std::ostringstream   out;
+		stream_snapshot_sink sink(out);
+		store->write_snapshot(sink);
+		return out.tellp();
+	};
+}
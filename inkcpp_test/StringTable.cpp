@@ -0,0 +1,142 @@
+#include "catch.hpp"
+
+#include "../inkcpp/string_table.h"
+
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+using ink::runtime::internal::managed_array;
+using ink::runtime::internal::snapshot_interface;
+using ink::runtime::internal::string_table;
+
+namespace
+{
+std::vector<const char*> fill(string_table& table, int count)
+{
+	std::vector<const char*> strings;
+	for (int i = 0; i < count; ++i) {
+		std::string text = "string " + std::to_string(i);
+		strings.push_back(table.duplicate(text.c_str()));
+	}
+	return strings;
+}
+
+std::vector<unsigned char> snap(const string_table& table)
+{
+	snapshot_interface::snapper snapper{table, nullptr};
+	std::vector<unsigned char>  data(table.snap(nullptr, snapper));
+	table.snap(data.data(), snapper);
+	return data;
+}
+} // namespace
+
+SCENARIO("snapshot a string table", "[strings]")
+{
+	GIVEN("more strings than the initial capacity")
+	{
+		string_table             table;
+		std::vector<const char*> strings = fill(table, 1000);
+		WHEN("the table is written")
+		{
+			std::vector<unsigned char> data = snap(table);
+			THEN("each string has its own id")
+			{
+				std::set<ink::size_t> ids;
+				for (const char* str : strings) {
+					ids.insert(table.get_id(str));
+				}
+				REQUIRE(ids.size() == strings.size());
+				REQUIRE(*ids.rbegin() == strings.size() - 1);
+			}
+			THEN("the ids point to the same strings after loading")
+			{
+				string_table                        loaded;
+				managed_array<const char*, true, 5> loaded_strings;
+				snapshot_interface::loader          loader{loaded_strings, nullptr};
+				REQUIRE(loaded.snap_load(data.data(), loader) == data.data() + data.size());
+				REQUIRE(loaded_strings.size() == strings.size());
+				for (const char* str : strings) {
+					REQUIRE(strcmp(loaded_strings[table.get_id(str)], str) == 0);
+				}
+			}
+			THEN("the loaded strings can be collected one by one")
+			{
+				string_table                        loaded;
+				managed_array<const char*, true, 5> loaded_strings;
+				snapshot_interface::loader          loader{loaded_strings, nullptr};
+				loaded.snap_load(data.data(), loader);
+				std::string kept = loaded_strings[1];
+				loaded.clear_usage();
+				loaded.mark_used(loaded_strings[1]);
+				loaded.gc();
+				REQUIRE(loaded_strings[1] == kept);
+				loaded.clear_usage();
+				loaded.gc();
+				REQUIRE(loaded.duplicate("new") != nullptr);
+			}
+		}
+		WHEN("the table is loaded from truncated data")
+		{
+			std::vector<unsigned char>          data = snap(table);
+			string_table                        loaded;
+			managed_array<const char*, true, 5> loaded_strings;
+			// the terminating zero is missing
+			const unsigned char*                end = data.data() + data.size() - 1;
+			snapshot_interface::loader          loader{loaded_strings, nullptr, nullptr, end};
+			THEN("it is rejected")
+			{
+				REQUIRE_THROWS_AS(loaded.snap_load(data.data(), loader), ink::ink_exception);
+			}
+		}
+		WHEN("unused strings are collected")
+		{
+			table.clear_usage();
+			for (size_t i = 0; i < strings.size(); i += 3) {
+				table.mark_used(strings[i]);
+			}
+			table.gc();
+			snap(table);
+			THEN("the remaining strings are numbered without gaps")
+			{
+				std::set<ink::size_t> ids;
+				for (size_t i = 0; i < strings.size(); i += 3) {
+					ids.insert(table.get_id(strings[i]));
+				}
+				REQUIRE(ids.size() == 334);
+				REQUIRE(*ids.rbegin() == 333);
+			}
+		}
+	}
+}
+
+SCENARIO("benchmark string table snapshots", "[.][benchmark]")
+{
+	string_table             table;
+	std::vector<const char*> strings = fill(table, 10000);
+	BENCHMARK("10k live strings")
+	{
+		std::vector<unsigned char> data = snap(table);
+		// the stacks resolve every string reference
+		ink::size_t                sum  = 0;
+		for (const char* str : strings) {
+			sum += table.get_id(str);
+		}
+		return data.size() + sum;
+	};
+}
+
+SCENARIO("benchmark loading string tables", "[.][benchmark]")
+{
+	string_table               table;
+	std::vector<const char*>   strings = fill(table, 10000);
+	std::vector<unsigned char> data    = snap(table);
+	BENCHMARK("10k strings")
+	{
+		string_table                        loaded;
+		managed_array<const char*, true, 5> loaded_strings;
+		snapshot_interface::loader          loader{loaded_strings, nullptr};
+		return loaded.snap_load(data.data(), loader);
+	};
+}
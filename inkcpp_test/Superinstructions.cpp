@@ -0,0 +1,91 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#include <../runner_impl.h>
+#include <compiler.h>
+#include <story.h>
+#include <runner.h>
+#include <globals.h>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace ink::runtime;
+
+namespace
+{
+struct play_result {
+	std::string text;
+	size_t      dispatches = 0;
+};
+
+// plays the story, always taking the first choice, and counts the executed instructions
+play_result play(std::string& binary)
+{
+	std::unique_ptr<story> ink    = fixture::load(binary);
+	auto                   thread = ink->new_runner().cast<internal::runner_impl>();
+	std::stringstream      debug;
+	thread->set_debug_enabled(&debug);
+	play_result result;
+	result.text = thread->getall();
+	while (thread->num_choices() > 0) {
+		thread->choose(0);
+		result.text += thread->getall();
+	}
+	// one line per instruction
+	for (std::string line; std::getline(debug, line);) {
+		++result.dispatches;
+	}
+	return result;
+}
+} // namespace
+
+SCENARIO("fuse common instruction sequences", "[compiler]")
+{
+	GIVEN("a story with conditionals and printed variables")
+	{
+		std::string json        = fixture::read("ConditionalStory.ink.json");
+		std::string unoptimized = fixture::compile(json, 0);
+		std::string optimized   = fixture::compile(json, 1);
+		play_result before      = play(unoptimized);
+		play_result after       = play(optimized);
+		THEN("both behave the same")
+		{
+			REQUIRE(before.text == "in k\nx is set\nk was visited\nx = 1\n");
+			REQUIRE(after.text == before.text);
+		}
+		THEN("fewer instructions are executed") { REQUIRE(after.dispatches < before.dispatches); }
+	}
+	GIVEN("json exported by inklecate and inky")
+	{
+		auto        compiler    = GENERATE("inklecate", "inky");
+		std::string json        = fixture::read(std::string("simple-1.1.1-") + compiler + ".json");
+		std::string unoptimized = fixture::compile(json, 0);
+		std::string optimized   = fixture::compile(json, 1);
+		play_result before      = play(unoptimized);
+		play_result after       = play(optimized);
+		THEN("both behave the same") { REQUIRE(after.text == before.text); }
+		THEN("fewer instructions are executed") { REQUIRE(after.dispatches < before.dispatches); }
+	}
+}
+
+SCENARIO("report executed instructions per story", "[.][benchmark]")
+{
+	const std::pair<const char*, const char*> stories[] = {
+	    {    "conditionals",   "ConditionalStory.ink.json"},
+	    {"simple-inklecate", "simple-1.1.1-inklecate.json"},
+	    {     "simple-inky",      "simple-1.1.1-inky.json"},
+	};
+	for (const auto& [name, filename] : stories) {
+		std::string json        = fixture::read(filename);
+		std::string unoptimized = fixture::compile(json, 0);
+		std::string optimized   = fixture::compile(json, 1);
+		play_result before      = play(unoptimized);
+		play_result after       = play(optimized);
+		REQUIRE(after.text == before.text);
+		std::cout << name << ": " << before.dispatches << " -> " << after.dispatches
+		          << " instructions, " << unoptimized.size() << " -> " << optimized.size() << " bytes\n";
+	}
+}
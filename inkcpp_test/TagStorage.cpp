@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "fixtures.h"
+
+#include <compiler.h>
+#include <story.h>
+#include <runner.h>
+#include <globals.h>
+#include <choice.h>
+
+#include <memory>
+#include <string>
+
+using namespace ink::runtime;
+
+namespace
+{
+// TaggedStory with `count` tags on its line and without choices
+std::string tagged_line(int count)
+{
+	nlohmann::json story   = nlohmann::json::parse(fixture::read("TaggedStory.ink.json"));
+	nlohmann::json content = nlohmann::json::array({"^line"});
+	for (int i = 0; i < count; ++i) {
+		content.push_back({{"#", "line " + std::to_string(i)}});
+	}
+	content.insert(content.end(), {"\n", nullptr});
+	story["root"][0] = content;
+	return story.dump();
+}
+} // namespace
+
+SCENARIO("store many tags per line and choice", "[tags]")
+{
+	GIVEN("a line and choices with more tags than the initial capacity")
+	{
+		std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "TaggedStory.bin")};
+		runner                 thread = ink->new_runner();
+		WHEN("the line is read")
+		{
+			std::string line = thread->getline();
+			THEN("all line tags are kept in order")
+			{
+				REQUIRE(line == "line\n");
+				REQUIRE(thread->num_tags() == 50);
+				for (int i = 0; i < 50; ++i) {
+					REQUIRE(std::string(thread->get_tag(i)) == "line " + std::to_string(i));
+				}
+				REQUIRE(thread->get_tag(50) == nullptr);
+			}
+			THEN("each choice keeps its own tags")
+			{
+				thread->getall();
+				REQUIRE(thread->num_choices() == 4);
+				for (int c = 0; c < 4; ++c) {
+					const choice* current = thread->get_choice(c);
+					REQUIRE(std::string(current->text()) == "choice " + std::to_string(c));
+					REQUIRE(current->num_tags() == 7);
+					for (int i = 0; i < 7; ++i) {
+						REQUIRE(
+						    std::string(current->get_tag(i))
+						    == "tag " + std::to_string(c) + " " + std::to_string(i)
+						);
+					}
+				}
+			}
+			THEN("tags are cleared after choosing")
+			{
+				thread->getall();
+				thread->choose(2);
+				REQUIRE(thread->getall() == "picked 2\n");
+				REQUIRE(thread->num_tags() == 0);
+			}
+		}
+	}
+}
+
+SCENARIO("benchmark tag heavy lines", "[.][benchmark]")
+{
+	for (int tags : {250, 500, 1000, 2000}) {
+		std::string            binary = fixture::compile(tagged_line(tags));
+		std::unique_ptr<story> ink    = fixture::load(binary);
+		REQUIRE(ink->new_runner()->getline() == "line\n");
+		BENCHMARK(std::to_string(tags) + " tags on one line")
+		{
+			runner thread = ink->new_runner();
+			thread->getline();
+			return thread->num_tags();
+		};
+	}
+}
@@ -0,0 +1,179 @@
+#include "catch.hpp"
+
+#include "../inkcpp/string_table.h"
+#include "../inkcpp/value.h"
+
+#include <story.h>
+#include <globals.h>
+#include <runner.h>
+#include <snapshot.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ink::runtime::internal::managed_array;
+using ink::runtime::internal::snapshot_interface;
+using ink::runtime::internal::string_table;
+using ink::runtime::internal::value;
+using ink::runtime::internal::value_type;
+using ink::runtime::globals;
+using ink::runtime::runner;
+using ink::runtime::snapshot;
+using ink::runtime::story;
+
+namespace
+{
+// plays up to count choices, always taking the first one
+std::string play(runner& thread, int count)
+{
+	std::string text = thread->getall();
+	for (int i = 0; i < count && thread->num_choices() > 0; ++i) {
+		thread->choose(0);
+		text += thread->getall();
+	}
+	return text;
+}
+
+template<typename T>
+std::vector<unsigned char> snap(const T& object, const snapshot_interface::snapper& snapper)
+{
+	std::vector<unsigned char> data(object.snap(nullptr, snapper));
+	object.snap(data.data(), snapper);
+	return data;
+}
+} // namespace
+
+SCENARIO("values keep their data in the storage layout", "[value]")
+{
+	GIVEN("a string")
+	{
+		char  text[] = "text";
+		value allocated = value{}.set<value_type::string>(text, true);
+		value story     = value{}.set<value_type::string>(static_cast<const char*>(text), false);
+		THEN("address and ownership are kept")
+		{
+			REQUIRE(allocated.type() == value_type::string);
+			REQUIRE(allocated.get<value_type::string>().str == text);
+			REQUIRE(allocated.get<value_type::string>().allocated);
+			REQUIRE(story.get<value_type::string>().str == text);
+			REQUIRE_FALSE(story.get<value_type::string>().allocated);
+		}
+	}
+	GIVEN("pointers to variables")
+	{
+		value global = value{}.set<value_type::value_pointer>(ink::hash_t(0xDEADBEEF), -1);
+		value local  = value{}.set<value_type::value_pointer>(ink::hash_t(42), 7);
+		THEN("name and call index are kept")
+		{
+			REQUIRE(global.type() == value_type::value_pointer);
+			REQUIRE(global.get<value_type::value_pointer>().name == 0xDEADBEEF);
+			REQUIRE(global.get<value_type::value_pointer>().ci == -1);
+			REQUIRE(local.get<value_type::value_pointer>().name == 42);
+			REQUIRE(local.get<value_type::value_pointer>().ci == 7);
+		}
+	}
+	GIVEN("thread markers and frames")
+	{
+		value jump   = value{}.set<value_type::jump_marker>(7u, 3u);
+		value thread = value{}.set<value_type::thread_start>(12u, 0u);
+		value frame  = value{}.set<value_type::function_frame>(1234u, true);
+		THEN("their data is kept")
+		{
+			REQUIRE(jump.type() == value_type::jump_marker);
+			REQUIRE(jump.get<value_type::jump_marker>().jump == 7);
+			REQUIRE(jump.get<value_type::jump_marker>().thread_id == 3);
+			REQUIRE(thread.type() == value_type::thread_start);
+			REQUIRE(thread.get<value_type::thread_start>().jump == 12);
+			REQUIRE(frame.get<value_type::function_frame>().addr == 1234);
+			REQUIRE(frame.get<value_type::function_frame>().eval);
+		}
+	}
+	GIVEN("a story in the middle of playing")
+	{
+		std::unique_ptr<story>    ink{story::from_file(INK_TEST_RESOURCE_DIR "TheIntercept.bin")};
+		globals                   store  = ink->new_globals();
+		runner                    thread = ink->new_runner(store);
+		play(thread, 5);
+		std::unique_ptr<snapshot> snap{thread->create_snapshot()};
+		WHEN("it is restored from a snapshot")
+		{
+			globals loaded_store = ink->new_globals_from_snapshot(*snap);
+			runner  loaded       = ink->new_runner_from_snapshot(*snap, loaded_store);
+			THEN("both continue the same") { REQUIRE(play(loaded, 5) == play(thread, 5)); }
+		}
+	}
+}
+
+SCENARIO("load values from corrupted snapshots", "[value][snapshot]")
+{
+	GIVEN("a dynamic string written to a snapshot")
+	{
+		string_table table;
+		table.duplicate("first");
+		char*                       second  = table.duplicate("second");
+		value                       text    = value{}.set<value_type::string>(second, true);
+		snapshot_interface::snapper snapper{table, nullptr};
+		std::vector<unsigned char>  strings = snap(table, snapper);
+		std::vector<unsigned char>  data    = snap(text, snapper);
+
+		string_table                        loaded_table;
+		managed_array<const char*, true, 5> loaded_strings;
+		snapshot_interface::loader          loader{loaded_strings, nullptr};
+		value                               loaded;
+		THEN("it is loaded with its string table")
+		{
+			loaded_table.snap_load(strings.data(), loader);
+			REQUIRE(loaded.snap_load(data.data(), loader) == data.data() + data.size());
+			REQUIRE(strcmp(loaded.get<value_type::string>().str, "second") == 0);
+		}
+		THEN("a string id which is not in the string table is rejected")
+		{
+			REQUIRE_THROWS_AS(loaded.snap_load(data.data(), loader), ink::ink_exception);
+		}
+		THEN("truncated data is rejected")
+		{
+			loaded_table.snap_load(strings.data(), loader);
+			loader.end = data.data() + data.size() - 1;
+			REQUIRE_THROWS_AS(loaded.snap_load(data.data(), loader), ink::ink_exception);
+		}
+	}
+	GIVEN("a story string written to a snapshot")
+	{
+		const char                  story_strings[] = "abc\0def";
+		string_table                table;
+		value                       text = value{}.set<value_type::string>(story_strings + 4, false);
+		snapshot_interface::snapper snapper{table, story_strings};
+		std::vector<unsigned char>  data = snap(text, snapper);
+
+		managed_array<const char*, true, 5> loaded_strings;
+		snapshot_interface::loader          loader{loaded_strings, story_strings};
+		value                               loaded;
+		THEN("it is loaded from the story string table")
+		{
+			loader.story_string_table_size = sizeof(story_strings);
+			REQUIRE(loaded.snap_load(data.data(), loader) == data.data() + data.size());
+			REQUIRE(strcmp(loaded.get<value_type::string>().str, "def") == 0);
+		}
+		THEN("an offset outside of the story string table is rejected")
+		{
+			loader.story_string_table_size = 4;
+			REQUIRE_THROWS_AS(loaded.snap_load(data.data(), loader), ink::ink_exception);
+		}
+	}
+}
+
+SCENARIO("benchmark the value layout", "[.][benchmark]")
+{
+	std::unique_ptr<story> ink{story::from_file(INK_TEST_RESOURCE_DIR "LoopStory.bin")};
+	REQUIRE(ink->new_runner()->getall() == "499500 n1000\n");
+
+	std::cout << "sizeof(value) = " << sizeof(value) << '\n';
+	BENCHMARK("loop over variables")
+	{
+		runner thread = ink->new_runner();
+		return thread->getall();
+	};
+}
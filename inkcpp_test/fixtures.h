@@ -0,0 +1,83 @@
+#pragma once
+
+// add_knots edits the json of a story
+#ifndef INK_EXPOSE_JSON
+#	define INK_EXPOSE_JSON
+#endif
+#include <compiler.h>
+#include <story.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// set by the CMake option INKCPP_TEST_OPTIMIZE
+#ifndef INK_TEST_OPTIMIZATION_LEVEL
+#	define INK_TEST_OPTIMIZATION_LEVEL 0
+#endif
+
+// Helpers for tests which compile stories while they run, like the ink json inklecate writes for
+// the stories in inkcpp_test/ink (see INK_JSON_STORIES in CMakeLists.txt)
+namespace fixture
+{
+// options test stories are compiled with, unless a test chooses its own
+inline ink::compiler::compilation_options default_options()
+{
+	ink::compiler::compilation_options options;
+	options.optimization_level = INK_TEST_OPTIMIZATION_LEVEL;
+	return options;
+}
+
+// content of a file in the test resource directory
+inline std::string read(const std::string& filename)
+{
+	std::ifstream file(INK_TEST_RESOURCE_DIR + filename, std::ios::binary);
+	if (! file) {
+		throw std::runtime_error("Missing test resource " + filename);
+	}
+	std::stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+// compiles ink json to a binary
+inline std::string compile(
+    const std::string& json, const ink::compiler::compilation_options& options = default_options(),
+    ink::compiler::compilation_results* results = nullptr
+)
+{
+	std::istringstream in(json);
+	std::stringstream  out;
+	ink::compiler::run(in, out, results, options);
+	return out.str();
+}
+
+// compiles ink json with the given optimization level
+inline std::string compile(const std::string& json, unsigned optimization_level)
+{
+	ink::compiler::compilation_options options;
+	options.optimization_level = optimization_level;
+	return compile(json, options);
+}
+
+// story using the binary without a copy, the binary has to outlive the story
+inline std::unique_ptr<ink::runtime::story> load(std::string& binary)
+{
+	return std::unique_ptr<ink::runtime::story>{ink::runtime::story::from_binary(
+	    reinterpret_cast<unsigned char*>(binary.data()), binary.size(), false
+	)};
+}
+
+// adds `count` knots to the story which are never visited, but have a visit count
+inline std::string add_knots(const std::string& json, int count)
+{
+	nlohmann::json story = nlohmann::json::parse(json);
+	for (int i = 0; i < count; ++i) {
+		story["root"].back()["k" + std::to_string(i)]
+		    = nlohmann::json::array({"^knot", "\n", "end", nlohmann::json{{"#f", 1}}});
+	}
+	return story.dump();
+}
+} // namespace fixture
@@ -122,6 +122,12 @@ enum class Command : uint8_t {
 	// == Function calls
 	CALL_EXTERNAL,
 
+	// == Superinstructions, fused common sequences (since InkBinVersion 3)
+	STR_NEWLINE,          // STR NEWLINE
+	OUTPUT_VARIABLE,      // START_EVAL PUSH_VARIABLE_VALUE OUTPUT
+	DIVERT_IF_READ_COUNT, // START_EVAL READ_COUNT END_EVAL DIVERT, payload: container, target
+	DIVERT_IF_VARIABLE,   // START_EVAL PUSH_VARIABLE_VALUE END_EVAL DIVERT, payload: variable, target
+
 	NUM_COMMANDS,
 };
 
@@ -42,5 +42,36 @@ namespace ink::internal {
 										   ///   because padding of struct may
 										   ///   differ between platforms
 				sizeof(uint16_t) + 2 * sizeof(uint32_t);
+
+			/// sections of a story file, listed in the directory (since InkBinVersion 2)
+			enum class section : uint32_t {
+				strings = 0,    ///< string table, double null terminated
+				list_meta,      ///< list flags and names, null_flag terminated
+				lists,          ///< predefined lists, each null_flag terminated
+				container_map,  ///< (offset, container id) pairs
+				container_hash, ///< (name hash, offset) pairs
+				instructions,   ///< instruction data
+				NUM_SECTIONS
+			};
+			static constexpr uint32_t NumSections = static_cast<uint32_t>(section::NUM_SECTIONS);
+
+			struct section_entry {
+				uint32_t offset = 0; ///< offset from start of file
+				uint32_t size   = 0; ///< size in bytes
+			};
+
+			/// directory following the header, allows to setup a story without scanning it
+			section_entry sections[NumSections];
+			uint32_t      num_containers      = 0; ///< number of containers with visit counts
+			uint32_t      container_map_size  = 0; ///< number of entries in container_map
+			uint32_t      container_hash_size = 0; ///< number of entries in container_hash
+
+			const section_entry& get(section s) const { return sections[static_cast<uint32_t>(s)]; }
+
+			/// file contains a section directory
+			bool has_directory() const { return ink_bin_version_number >= 2; }
+
+			static constexpr size_t DirectorySize = ///< data size of the directory
+				NumSections * 2 * sizeof(uint32_t) + 3 * sizeof(uint32_t);
 		};
 }
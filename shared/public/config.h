@@ -18,6 +18,11 @@
 // Only turn on if you have json.hpp and you want to use it with the compiler
 // #define INK_EXPOSE_JSON
 
+// Store runtime values in 8 instead of 24 bytes (on 64bit platforms), this requires that all
+// string addresses fit into 56 bits, which is not the case with tagged pointers.
+// Snapshots are only compatible between builds with the same setting.
+// #define INK_COMPACT_VALUE
+
 namespace ink::config
 {
 /// set limitations which are required to minimize heap allocations.
@@ -27,6 +32,8 @@ static constexpr int limitGlobalVariables         = -50;
 static constexpr int limitGlobalVariableObservers = -10;
 static constexpr int limitThreadDepth             = -10;
 static constexpr int limitEvalStackDepth          = -20;
+// number of strings created at runtime which are alive at the same time
+static constexpr int limitStringTable             = -100;
 static constexpr int limitContainerDepth          = -20;
 /** number of lists which can be accessed with get_var
  *  before the story must continue
@@ -9,6 +9,7 @@
 #include "system.h"
 
 namespace ink {
-constexpr uint32_t InkBinVersion = 1;  ///< Supportet version of ink.bin files
+constexpr uint32_t InkBinVersion = 3;  ///< Supportet version of ink.bin files
+constexpr uint32_t InkBinVersionMin = 1; ///< Oldest version of ink.bin files which can be loaded
 constexpr uint32_t InkVersion    = 21; ///< Supported version of ink.json files
 };